@@ -52,19 +52,13 @@ layout(set = 0, binding = 1) uniform LightsBuffer {
   int NumLights;
 };
 
+// Matches iris::Renderer::Material::BufferData, whatever maps are enabled.
 layout(set = 1, binding = 1) uniform MaterialBuffer {
-  vec2 MetallicRoughnessValues;
   vec4 BaseColorFactor;
-
-#ifdef HAS_NORMAL_MAP
-  float NormalScale;
-#endif
-#ifdef HAS_EMISSIVE_MAP
   vec3 EmissiveFactor;
-#endif
-#ifdef HAS_OCCLUSION_MAP
+  float NormalScale;
+  vec2 MetallicRoughnessValues;
   float OcclusionStrength;
-#endif
 };
 
 #ifdef HAS_BASECOLOR_MAP
@@ -141,7 +135,7 @@ vec3 GetNormal() {
   mat3 tbn = TBN;
 
 #ifdef HAS_NORMAL_MAP
-    vec3 n = texture(sampler2D(NormalTexture, NormalSampler), UV0.st).rgb;
+    vec3 n = texture(sampler2D(NormalTexture, NormalSampler), UV).rgb;
     n = normalize(tbn * ((2.0 * n - 1.0) * vec3(NormalScale, NormalScale, 1.0)));
 #else
   // The tbn matrix is linearly interpolated, so we need to re-normalize
@@ -158,7 +152,7 @@ void main() {
 #ifdef HAS_METALLICROUGHNESS_MAP
   // Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel.
   // This layout intentionally reserves the 'r' channel for (optional) occlusion map data
-  vec4 mrSample = texture(sampler2D(MetallicRoughnessTexture, MetallicRoughnessSampler), UV0.st);
+  vec4 mrSample = texture(sampler2D(MetallicRoughnessTexture, MetallicRoughnessSampler), UV);
   perceptualRoughness = mrSample.g * perceptualRoughness;
   metallic = mrSample.b * metallic;
 #endif
@@ -170,7 +164,7 @@ void main() {
   float alphaRoughness = perceptualRoughness * perceptualRoughness;
 
 #ifdef HAS_BASECOLOR_MAP
-  vec4 baseColor = SRGBtoLINEAR(texture(sampler2D(BaseColorTexture, BaseColorSampler), UV0.st)) * BaseColorFactor;
+  vec4 baseColor = SRGBtoLINEAR(texture(sampler2D(BaseColorTexture, BaseColorSampler), UV)) * BaseColorFactor;
 #else
   vec4 baseColor = BaseColorFactor;
 #endif
@@ -235,14 +229,16 @@ void main() {
 
   // Apply optional PBR terms for additional (optional) shading
 #ifdef HAS_OCCLUSION_MAP
-  float ao = texture(sampler2D(OcclusionTexture, OcclusionSampler), UV0.st).r;
+  float ao = texture(sampler2D(OcclusionTexture, OcclusionSampler), UV).r;
   color = mix(color, color * ao, OcclusionStrength);
 #endif
 
 #ifdef HAS_EMISSIVE_MAP
-  vec3 emissive = SRGBtoLINEAR(texture(sampler2D(EmissiveTexture, EmissiveSampler), UV0.st)).rgb * EmissiveFactor;
-  color += emissive;
+  vec3 emissive = SRGBtoLINEAR(texture(sampler2D(EmissiveTexture, EmissiveSampler), UV)).rgb * EmissiveFactor;
+#else
+  vec3 emissive = EmissiveFactor;
 #endif
+  color += emissive;
 
   Color = vec4(pow(color, vec3(1.0/2.2)), baseColor.a);
 }
@@ -27,12 +27,6 @@
 
 #version 460 core
 
-layout(push_constant) uniform PushConstants {
-  mat4 ModelViewMatrix;
-  mat4 ModelViewMatrixInverse;
-  mat3 NormalMatrix;
-};
-
 layout(set = 0, binding = 0) uniform MatricesBuffer {
   mat4 ViewMatrix;
   mat4 ViewMatrixInverse;
@@ -40,11 +34,16 @@ layout(set = 0, binding = 0) uniform MatricesBuffer {
   mat4 ProjectionMatrixInverse;
 };
 
-layout(set = 1, binding = 0) uniform ModelBuffer {
+struct ModelMatrices {
   mat4 ModelMatrix;
   mat4 ModelMatrixInverse;
 };
 
+// One entry per instance of the mesh.
+layout(std430, set = 1, binding = 0) readonly buffer ModelBuffer {
+  ModelMatrices Models[];
+};
+
 layout(location = 0) in vec3 Vertex;
 layout(location = 1) in vec3 Normal;
 layout(location = 2) in vec4 Tangent;
@@ -70,6 +69,12 @@ out gl_PerVertex {
 };
 
 void main() {
+  mat4 ModelMatrix = Models[gl_InstanceIndex].ModelMatrix;
+  mat4 ModelMatrixInverse = Models[gl_InstanceIndex].ModelMatrixInverse;
+  mat4 ModelViewMatrix = ViewMatrix * ModelMatrix;
+  mat4 ModelViewMatrixInverse = ModelMatrixInverse * ViewMatrixInverse;
+  mat3 NormalMatrix = transpose(mat3(ModelViewMatrixInverse));
+
   Po = vec4(Vertex, 1.0);
   Pe = ModelViewMatrix * Po;
 
@@ -88,7 +93,7 @@ void main() {
   TBN = mat3(tangentW, bitangentW, normalW);
 
 #ifdef HAS_TEXCOORDS
-  UV = Texcoord0;
+  UV = Texcoord;
 #else
   UV = vec2(0.0, 0.0);
 #endif
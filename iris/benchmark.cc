@@ -0,0 +1,50 @@
+#include "benchmark.h"
+#if PLATFORM_COMPILER_MSVC
+#pragma warning(push)
+#pragma warning(disable : 4127)
+#endif
+#include "spdlog/sinks/stdout_color_sinks.h"
+#if PLATFORM_COMPILER_MSVC
+#pragma warning(pop)
+#endif
+
+#if PLATFORM_WINDOWS
+#include <Windows.h>
+#include <psapi.h>
+#elif PLATFORM_LINUX
+#include <sys/resource.h>
+#endif
+
+std::uint64_t iris::PeakRSS() noexcept {
+#if PLATFORM_WINDOWS
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize / 1024;
+#elif PLATFORM_LINUX
+  struct rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+  return 0;
+#endif
+} // iris::PeakRSS
+
+std::shared_ptr<spdlog::logger>
+iris::CreateBenchmarkLoggers(spdlog::level::level_enum libraryLevel) {
+  auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+  console_sink->set_level(spdlog::level::info);
+
+  auto libraryLogger = std::make_shared<spdlog::logger>("iris", console_sink);
+  libraryLogger->set_level(libraryLevel);
+  spdlog::register_logger(libraryLogger);
+
+  auto logger = std::make_shared<spdlog::logger>("benchmark", console_sink);
+  logger->set_level(spdlog::level::info);
+  spdlog::register_logger(logger);
+  spdlog::set_pattern("[%T.%e] %v%$");
+
+  return logger;
+} // iris::CreateBenchmarkLoggers
@@ -0,0 +1,35 @@
+#ifndef HEV_IRIS_BENCHMARK_H_
+#define HEV_IRIS_BENCHMARK_H_
+/*! \file
+ * \brief Process measurements and logging shared by the benchmarks.
+ */
+
+#include "iris/config.h"
+#if PLATFORM_COMPILER_MSVC
+#pragma warning(push)
+#pragma warning(disable : 4127)
+#endif
+#include "spdlog/spdlog.h"
+#if PLATFORM_COMPILER_MSVC
+#pragma warning(pop)
+#endif
+#include <cstdint>
+#include <memory>
+
+namespace iris {
+
+//! \brief The peak resident set size of the process so far in KiB, or 0
+//! where it cannot be measured.
+std::uint64_t PeakRSS() noexcept;
+
+/*! \brief Log to the console with timestamps. The "iris" logger of the
+ * library logs at \p libraryLevel, so a benchmark can keep the library's
+ * per-iteration messages out of its results.
+ * \return the logger for the benchmark's own results, which logs at info.
+ */
+std::shared_ptr<spdlog::logger>
+CreateBenchmarkLoggers(spdlog::level::level_enum libraryLevel);
+
+} // namespace iris
+
+#endif // HEV_IRIS_BENCHMARK_H_
@@ -0,0 +1,80 @@
+/*! \file
+ * \brief Measure the time of decoding glTF files and the bytes decoding
+ * copies out of their buffers for each primitive.
+ *
+ * Files are decoded as loading does, but bypassing the scene cache and
+ * without creating anything on the GPU. Decoding reads each byte of an
+ * accessor once, so the bytes copied per primitive should be the size of
+ * its accessors, not a multiple of the size of the buffers.
+ */
+#include "absl/debugging/failure_signal_handler.h"
+#include "absl/debugging/symbolize.h"
+#include "benchmark.h"
+#include "iris/config.h"
+#include "iris/renderer/io/gltf.h"
+#include "flags.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+
+std::shared_ptr<spdlog::logger> sLogger;
+
+int main(int argc, char** argv) {
+  absl::InitializeSymbolizer(argv[0]);
+  absl::InstallFailureSignalHandler({});
+
+  flags::args const args(argc, argv);
+  auto const& files = args.positional();
+  auto const iterations = args.get<int>("iterations", 1);
+
+  // The loader logs every phase of every iteration at info, so it only
+  // gets to report problems.
+  sLogger = iris::CreateBenchmarkLoggers(spdlog::level::warn);
+
+  if (files.empty()) {
+    sLogger->error("Usage: {} [--iterations=N] file...", argv[0]);
+    std::exit(EXIT_FAILURE);
+  }
+
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+
+  for (auto&& file : files) {
+    std::uint64_t const startRSS = iris::PeakRSS();
+    float fastest = std::numeric_limits<float>::max();
+    iris::Renderer::io::GLTFDecodeStatistics statistics;
+
+    for (int i = 0; i < std::max(iterations, 1); ++i) {
+      auto const start = std::chrono::steady_clock::now();
+      if (auto s = iris::Renderer::io::DecodeGLTF(file)) {
+        statistics = std::move(*s);
+      } else {
+        sLogger->error("Cannot decode {}: {}", file, s.error().what());
+        std::exit(EXIT_FAILURE);
+      }
+      fastest = std::min(
+        fastest,
+        Milliseconds(std::chrono::steady_clock::now() - start).count());
+    }
+
+    auto&& perPrimitive = statistics.primitiveBytesCopied;
+    std::size_t const numPrimitives = perPrimitive.size();
+    std::size_t const total =
+      std::accumulate(perPrimitive.begin(), perPrimitive.end(), std::size_t{0});
+    std::size_t const largest =
+      numPrimitives > 0
+        ? *std::max_element(perPrimitive.begin(), perPrimitive.end())
+        : 0;
+    std::size_t const mean = numPrimitives > 0 ? total / numPrimitives : 0;
+
+    std::uint64_t const peakRSS = iris::PeakRSS();
+    sLogger->info("{}: {:.3f} ms, peak RSS {} KiB (+{} KiB)", file, fastest,
+                  peakRSS, peakRSS - startRSS);
+    sLogger->info(
+      "{}: {} primitives copied {} bytes of {} buffer bytes; per primitive "
+      "mean {} bytes, max {} bytes",
+      file, numPrimitives, total, statistics.bufferBytes, mean, largest);
+  }
+}
@@ -0,0 +1,61 @@
+/*! \file
+ * \brief Measure the time and peak memory of parsing the JSON of glTF files.
+ *
+ * Peak RSS only ever grows, so each run measures a single parser: run once
+ * as is for the streaming parser and once with --dom for the DOM parser and
+ * compare.
+ */
+#include "absl/debugging/failure_signal_handler.h"
+#include "absl/debugging/symbolize.h"
+#include "benchmark.h"
+#include "iris/config.h"
+#include "iris/renderer/io/gltf.h"
+#include "flags.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+std::shared_ptr<spdlog::logger> sLogger;
+
+int main(int argc, char** argv) {
+  absl::InitializeSymbolizer(argv[0]);
+  absl::InstallFailureSignalHandler({});
+
+  flags::args const args(argc, argv);
+  auto const& files = args.positional();
+  bool const dom = args.get<bool>("dom", false);
+  auto const iterations = args.get<int>("iterations", 1);
+
+  sLogger = iris::CreateBenchmarkLoggers(spdlog::level::info);
+
+  if (files.empty()) {
+    sLogger->error("Usage: {} [--dom] [--iterations=N] file...", argv[0]);
+    std::exit(EXIT_FAILURE);
+  }
+
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+
+  for (auto&& file : files) {
+    std::uint64_t const startRSS = iris::PeakRSS();
+    float fastest = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < std::max(iterations, 1); ++i) {
+      auto const start = std::chrono::steady_clock::now();
+      if (auto error = iris::Renderer::io::ParseGLTFJSON(file, dom);
+          error.code()) {
+        sLogger->error("Cannot parse {}: {}", file, error.what());
+        std::exit(EXIT_FAILURE);
+      }
+      fastest = std::min(
+        fastest,
+        Milliseconds(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::uint64_t const peakRSS = iris::PeakRSS();
+    sLogger->info("{} ({}): {:.3f} ms, peak RSS {} KiB (+{} KiB)", file,
+                  dom ? "DOM" : "streaming", fastest, peakRSS,
+                  peakRSS - startRSS);
+  }
+}
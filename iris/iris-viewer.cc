@@ -51,6 +51,11 @@ int main(int argc, char** argv) {
 
   flags::args const args(argc, argv);
   auto const& files = args.positional();
+  auto const numFramesInFlight =
+    args.get<std::uint32_t>("frames-in-flight", 2);
+  bool const gpuCulling = args.get<bool>("gpu-culling", false);
+  bool const quantizeVertices = args.get<bool>("quantize-vertices", false);
+  bool const reduceOverdraw = args.get<bool>("reduce-overdraw", false);
 
   auto file_sink =
     std::make_shared<spdlog::sinks::basic_file_sink_mt>("iris-viewer.log", true);
@@ -64,11 +69,20 @@ int main(int argc, char** argv) {
 
   logger.info("initialized");
 
+  auto options = iris::Renderer::Options::kReportDebugMessages |
+                 iris::Renderer::Options::kUseValidationLayers;
+  if (gpuCulling) options = options | iris::Renderer::Options::kGPUCulling;
+  if (quantizeVertices) {
+    options = options | iris::Renderer::Options::kQuantizeVertices;
+  }
+  if (reduceOverdraw) {
+    options = options | iris::Renderer::Options::kReduceOverdraw;
+  }
+
   if (auto error = iris::Renderer::Initialize(
-        "iris-viewer",
-        iris::Renderer::Options::kReportDebugMessages |
-          iris::Renderer::Options::kUseValidationLayers,
-        0, {console_sink, file_sink}); error.code()) {
+        "iris-viewer", options, 0, {console_sink, file_sink},
+        numFramesInFlight);
+      error.code()) {
     logger.critical("cannot initialize renderer: {}", error.what());
     std::exit(EXIT_FAILURE);
   }
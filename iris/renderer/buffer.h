@@ -12,11 +12,12 @@ struct Buffer {
   Create(VkDeviceSize size, VkBufferUsageFlags bufferUsage,
          VmaMemoryUsage memoryUsage, std::string name = {}) noexcept;
 
+  //! \brief Create a buffer and queue an upload of \p data to it; see
+  //! QueueBufferUpload for when it may be used.
   static tl::expected<Buffer, std::system_error>
   CreateFromMemory(VkDeviceSize size, VkBufferUsageFlags bufferUsage,
                    VmaMemoryUsage memoryUsage, gsl::not_null<void const*> data,
-                   std::string name = {},
-                   VkCommandPool commandPool = VK_NULL_HANDLE) noexcept;
+                   std::string name = {}) noexcept;
 
   VkDeviceSize size{0};
   VkBuffer handle{VK_NULL_HANDLE};
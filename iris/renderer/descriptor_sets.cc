@@ -1,14 +1,30 @@
 #include "renderer/descriptor_sets.h"
+#include "absl/container/flat_hash_map.h"
 #include "logging.h"
+#include <mutex>
+#include <string>
 
-tl::expected<iris::Renderer::DescriptorSets, std::system_error>
-iris::Renderer::DescriptorSets::Allocate(
-  VkDescriptorPool pool, gsl::span<VkDescriptorSetLayoutBinding> bindings,
-  std::uint32_t numSets, std::string name) noexcept {
+namespace iris::Renderer {
+
+static std::mutex sDescriptorSetLayoutsMutex;
+static absl::flat_hash_map<std::string, VkDescriptorSetLayout>
+  sDescriptorSetLayouts;
+
+[[nodiscard]] static tl::expected<VkDescriptorSetLayout, std::system_error>
+GetDescriptorSetLayout(gsl::span<VkDescriptorSetLayoutBinding> bindings,
+                       std::string const& name) noexcept {
   IRIS_LOG_ENTER();
-  Expects(sDevice != VK_NULL_HANDLE);
 
-  DescriptorSets descriptorSet(numSets);
+  // VkDescriptorSetLayoutBinding has no padding, so its bytes are its state.
+  std::string const key(reinterpret_cast<char const*>(bindings.data()),
+                        bindings.size_bytes());
+
+  std::lock_guard<std::mutex> lock(sDescriptorSetLayoutsMutex);
+  if (auto iter = sDescriptorSetLayouts.find(key);
+      iter != sDescriptorSetLayouts.end()) {
+    IRIS_LOG_LEAVE();
+    return iter->second;
+  }
 
   VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI = {};
   descriptorSetLayoutCI.sType =
@@ -16,8 +32,9 @@ iris::Renderer::DescriptorSets::Allocate(
   descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
   descriptorSetLayoutCI.pBindings = bindings.data();
 
+  VkDescriptorSetLayout layout;
   if (auto result = vkCreateDescriptorSetLayout(sDevice, &descriptorSetLayoutCI,
-                                                nullptr, &descriptorSet.layout);
+                                                nullptr, &layout);
       result != VK_SUCCESS) {
     IRIS_LOG_LEAVE();
     return tl::unexpected(std::system_error(
@@ -25,8 +42,31 @@ iris::Renderer::DescriptorSets::Allocate(
   }
 
   if (!name.empty()) {
-    NameObject(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, descriptorSet.layout,
-               name.c_str());
+    NameObject(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, layout, name.c_str());
+  }
+
+  sDescriptorSetLayouts.emplace(key, layout);
+
+  IRIS_LOG_LEAVE();
+  return layout;
+} // GetDescriptorSetLayout
+
+} // namespace iris::Renderer
+
+tl::expected<iris::Renderer::DescriptorSets, std::system_error>
+iris::Renderer::DescriptorSets::Allocate(
+  VkDescriptorPool pool, gsl::span<VkDescriptorSetLayoutBinding> bindings,
+  std::uint32_t numSets, std::string name) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+
+  DescriptorSets descriptorSet(numSets);
+
+  if (auto l = GetDescriptorSetLayout(bindings, name)) {
+    descriptorSet.layout = *l;
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(l.error());
   }
 
   absl::FixedArray<VkDescriptorSetLayout> descriptorSetLayouts(
@@ -79,11 +119,15 @@ operator=(DescriptorSets&& rhs) noexcept {
   return *this;
 } // iris::Renderer::DescriptorSets::operator=
 
-iris::Renderer::DescriptorSets::~DescriptorSets() noexcept {
-  if (layout == VK_NULL_HANDLE) return;
+void iris::Renderer::ReleaseDescriptorSetLayouts() noexcept {
   IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
 
-  vkDestroyDescriptorSetLayout(sDevice, layout, nullptr);
+  std::lock_guard<std::mutex> lock(sDescriptorSetLayoutsMutex);
+  for (auto&& iter : sDescriptorSetLayouts) {
+    vkDestroyDescriptorSetLayout(sDevice, iter.second, nullptr);
+  }
+  sDescriptorSetLayouts.clear();
 
   IRIS_LOG_LEAVE();
-}
+} // iris::Renderer::ReleaseDescriptorSetLayouts
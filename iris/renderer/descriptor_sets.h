@@ -8,6 +8,12 @@
 namespace iris::Renderer {
 
 struct DescriptorSets {
+  /*! \brief Allocate \p numSets sets from \p pool.
+   *
+   * The layout is shared by every DescriptorSets allocated with the same
+   * \p bindings, so pipelines built from it can be shared as well. Layouts
+   * are owned by the renderer until ReleaseDescriptorSetLayouts.
+   */
   static tl::expected<DescriptorSets, std::system_error>
   Allocate(VkDescriptorPool pool,
            gsl::span<VkDescriptorSetLayoutBinding> bindings,
@@ -21,12 +27,16 @@ struct DescriptorSets {
   DescriptorSets(DescriptorSets&& other) noexcept;
   DescriptorSets& operator=(DescriptorSets const&) = delete;
   DescriptorSets& operator=(DescriptorSets&& rhs) noexcept;
-  ~DescriptorSets() noexcept;
+  ~DescriptorSets() noexcept = default;
 
 private:
   std::string name;
 }; // struct DescriptorSets
 
+//! \brief Destroy all shared descriptor set layouts; must be called before
+//! the device is destroyed.
+void ReleaseDescriptorSetLayouts() noexcept;
+
 inline void UpdateDescriptorSets(
   gsl::span<VkWriteDescriptorSet> writeDescriptorSets,
   gsl::span<VkCopyDescriptorSet> copyDescriptorSets = {}) noexcept {
@@ -0,0 +1,360 @@
+#include "renderer/geometry_arena.h"
+#include "renderer/upload.h"
+#include "logging.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace iris::Renderer {
+
+static constexpr VkDeviceSize const kInitialArenaCapacity{8 * 1024 * 1024};
+
+//! \brief One shared geometry buffer and the ranges allocated from it.
+struct GeometryArena {
+  std::string name{};
+  VkBufferUsageFlags usage{0};
+  VkBuffer buffer{VK_NULL_HANDLE};
+  VmaAllocation allocation{VK_NULL_HANDLE};
+  GeometryAllocator allocator{};
+}; // struct GeometryArena
+
+static std::array<GeometryArena, 2> sArenas{{
+  {"sGeometryArena.vertices",
+   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+     VK_BUFFER_USAGE_TRANSFER_DST_BIT},
+  {"sGeometryArena.indices",
+   VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+     VK_BUFFER_USAGE_TRANSFER_DST_BIT},
+}};
+
+static std::uint64_t sGeometryGeneration{0};
+
+static GeometryArena& Arena(GeometryKind kind) noexcept {
+  return sArenas[static_cast<std::size_t>(kind)];
+} // Arena
+
+static VkDeviceSize AlignUp(VkDeviceSize offset,
+                            VkDeviceSize alignment) noexcept {
+  return (offset + alignment - 1) / alignment * alignment;
+} // AlignUp
+
+/*! \brief Replace the buffer of \p arena with one of \p capacity bytes and
+ * copy every live range into it, packed from the start in id order.
+ *
+ * The old buffer is destroyed only after the GPU is done with it:
+ * FlushUploads submits the queued uploads and then waits for the device to
+ * go idle, so no frame in flight still reads it, and EndOneTimeSubmit waits
+ * on its fence until the copy out of it has completed.
+ */
+[[nodiscard]] static std::system_error
+CompactArena(GeometryArena& arena, VkDeviceSize capacity) noexcept {
+  IRIS_LOG_ENTER();
+
+  VkBufferCreateInfo bufferCI = {};
+  bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCI.size = capacity;
+  bufferCI.usage = arena.usage;
+
+  VmaAllocationCreateInfo allocationCI = {};
+  allocationCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+  allocationCI.pUserData = arena.name.data();
+
+  VkBuffer buffer;
+  VmaAllocation allocation;
+  if (auto result = vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI,
+                                    &buffer, &allocation, nullptr);
+      result != VK_SUCCESS) {
+    IRIS_LOG_LEAVE();
+    return {make_error_code(result), "Error creating " + arena.name};
+  }
+
+  NameObject(VK_OBJECT_TYPE_BUFFER, buffer, arena.name.c_str());
+
+  std::vector<VkBufferCopy> const regions =
+    arena.allocator.CompactionRegions();
+
+  if (arena.buffer != VK_NULL_HANDLE) {
+    // Queued uploads to the old buffer have to land before it is copied, and
+    // frames in flight have to finish reading it before it is destroyed.
+    if (auto error = FlushUploads(); error.code()) {
+      vmaDestroyBuffer(sAllocator, buffer, allocation);
+      IRIS_LOG_LEAVE();
+      return error;
+    }
+
+    if (!regions.empty()) {
+      VkCommandBuffer commandBuffer;
+      if (auto cb = BeginOneTimeSubmit()) {
+        commandBuffer = *cb;
+      } else {
+        vmaDestroyBuffer(sAllocator, buffer, allocation);
+        IRIS_LOG_LEAVE();
+        return cb.error();
+      }
+
+      vkCmdCopyBuffer(commandBuffer, arena.buffer, buffer,
+                      gsl::narrow_cast<std::uint32_t>(regions.size()),
+                      regions.data());
+
+      if (auto error = EndOneTimeSubmit(commandBuffer); error.code()) {
+        vmaDestroyBuffer(sAllocator, buffer, allocation);
+        IRIS_LOG_LEAVE();
+        return error;
+      }
+    }
+
+    vmaDestroyBuffer(sAllocator, arena.buffer, arena.allocation);
+  }
+
+  arena.allocator.Compact(capacity);
+  GetLogger()->debug("{}: compacted {} ranges ({} bytes) into {} bytes",
+                     arena.name, regions.size(), arena.allocator.bytesUsed,
+                     capacity);
+
+  arena.buffer = buffer;
+  arena.allocation = allocation;
+  sGeometryGeneration++;
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // CompactArena
+
+} // namespace iris::Renderer
+
+std::uint32_t
+iris::Renderer::GeometryAllocator::Allocate(VkDeviceSize size,
+                                            VkDeviceSize alignment) noexcept {
+  Expects(size > 0);
+  Expects(alignment > 0);
+
+  for (auto iter = freeSpace.begin(); iter != freeSpace.end(); ++iter) {
+    auto const [freeOffset, freeSize] = *iter;
+    VkDeviceSize const offset = AlignUp(freeOffset, alignment);
+    if (offset + size > freeOffset + freeSize) continue;
+
+    freeSpace.erase(iter);
+    if (offset > freeOffset) freeSpace.emplace(freeOffset, offset - freeOffset);
+    if (offset + size < freeOffset + freeSize) {
+      freeSpace.emplace(offset + size, freeOffset + freeSize - (offset + size));
+    }
+
+    std::uint32_t id;
+    if (freeIds.empty()) {
+      id = gsl::narrow_cast<std::uint32_t>(ranges.size());
+      ranges.emplace_back();
+    } else {
+      id = freeIds.back();
+      freeIds.pop_back();
+    }
+
+    ranges[id] = {offset, size, alignment, true};
+    bytesUsed += size;
+    return id;
+  }
+
+  return UINT32_MAX;
+} // iris::Renderer::GeometryAllocator::Allocate
+
+void iris::Renderer::GeometryAllocator::Free(std::uint32_t id) noexcept {
+  auto const [offset, size] = Retire(id);
+  Reclaim(offset, size);
+} // iris::Renderer::GeometryAllocator::Free
+
+std::pair<VkDeviceSize, VkDeviceSize>
+iris::Renderer::GeometryAllocator::Retire(std::uint32_t id) noexcept {
+  Expects(id < ranges.size() && ranges[id].live);
+
+  auto&& range = ranges[id];
+  bytesUsed -= range.size;
+  range.live = false;
+  freeIds.push_back(id);
+  return {range.offset, range.size};
+} // iris::Renderer::GeometryAllocator::Retire
+
+void iris::Renderer::GeometryAllocator::Reclaim(VkDeviceSize offset,
+                                                VkDeviceSize size) noexcept {
+  auto next = freeSpace.lower_bound(offset);
+
+  if (next != freeSpace.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      freeSpace.erase(prev);
+    }
+  }
+
+  if (next != freeSpace.end() && offset + size == next->first) {
+    size += next->second;
+    freeSpace.erase(next);
+  }
+
+  freeSpace.emplace(offset, size);
+} // iris::Renderer::GeometryAllocator::Reclaim
+
+std::vector<VkBufferCopy>
+iris::Renderer::GeometryAllocator::CompactionRegions() const {
+  std::vector<VkBufferCopy> regions;
+  VkDeviceSize end = 0;
+
+  for (auto&& range : ranges) {
+    if (!range.live) continue;
+    VkDeviceSize const offset = AlignUp(end, range.alignment);
+    regions.push_back({range.offset, offset, range.size});
+    end = offset + range.size;
+  }
+
+  return regions;
+} // iris::Renderer::GeometryAllocator::CompactionRegions
+
+void iris::Renderer::GeometryAllocator::Compact(VkDeviceSize newCapacity) {
+  VkDeviceSize end = 0;
+
+  for (auto&& range : ranges) {
+    if (!range.live) continue;
+    range.offset = AlignUp(end, range.alignment);
+    end = range.offset + range.size;
+  }
+
+  Expects(end <= newCapacity);
+  capacity = newCapacity;
+  freeSpace.clear();
+  if (end < capacity) freeSpace.emplace(end, capacity - end);
+} // iris::Renderer::GeometryAllocator::Compact
+
+void iris::Renderer::GeometryAllocator::Reset() noexcept {
+  capacity = bytesUsed = 0;
+  freeSpace.clear();
+  ranges.clear();
+  freeIds.clear();
+} // iris::Renderer::GeometryAllocator::Reset
+
+tl::expected<iris::Renderer::GeometryRange, std::system_error>
+iris::Renderer::AllocateGeometry(GeometryKind kind, VkDeviceSize size,
+                                 VkDeviceSize alignment,
+                                 gsl::not_null<void const*> data) noexcept {
+  return AllocateGeometry(kind, size, alignment, [&](std::byte* dst) {
+    std::memcpy(dst, data, size);
+  });
+} // iris::Renderer::AllocateGeometry
+
+tl::expected<iris::Renderer::GeometryRange, std::system_error>
+iris::Renderer::AllocateGeometry(
+  GeometryKind kind, VkDeviceSize size, VkDeviceSize alignment,
+  std::function<void(std::byte*)> const& write) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+  Expects(size > 0);
+  Expects(alignment > 0);
+
+  auto&& arena = Arena(kind);
+  auto&& allocator = arena.allocator;
+
+  std::uint32_t id = allocator.Allocate(size, alignment);
+  if (id == UINT32_MAX) {
+    // Compacting alone is enough when fragmentation is the problem;
+    // otherwise at least double so growth stays amortized.
+    VkDeviceSize const needed = allocator.bytesUsed + size + alignment;
+    VkDeviceSize capacity =
+      std::max(kInitialArenaCapacity, allocator.capacity);
+    if (needed > capacity / 2) capacity = std::max(capacity * 2, needed);
+
+    if (auto error = CompactArena(arena, capacity); error.code()) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(error);
+    }
+
+    id = allocator.Allocate(size, alignment);
+    Expects(id != UINT32_MAX);
+  }
+
+  if (auto error = QueueBufferWrite(arena.buffer, allocator.ranges[id].offset,
+                                    size, write);
+      error.code()) {
+    allocator.Free(id);
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(error);
+  }
+
+  GeometryRange range;
+  range.kind = kind;
+  range.id = id;
+
+  IRIS_LOG_LEAVE();
+  return std::move(range);
+} // iris::Renderer::AllocateGeometry
+
+VkBuffer iris::Renderer::GeometryBuffer(GeometryKind kind) noexcept {
+  return Arena(kind).buffer;
+} // iris::Renderer::GeometryBuffer
+
+std::uint64_t iris::Renderer::GeometryGeneration() noexcept {
+  return sGeometryGeneration;
+} // iris::Renderer::GeometryGeneration
+
+void iris::Renderer::ReleaseGeometryArenas() noexcept {
+  IRIS_LOG_ENTER();
+
+  for (auto&& arena : sArenas) {
+    GetLogger()->info("{}: {} bytes in use of {} at release", arena.name,
+                      arena.allocator.bytesUsed, arena.allocator.capacity);
+    if (arena.buffer != VK_NULL_HANDLE) {
+      vmaDestroyBuffer(sAllocator, arena.buffer, arena.allocation);
+    }
+
+    arena.buffer = VK_NULL_HANDLE;
+    arena.allocation = VK_NULL_HANDLE;
+    arena.allocator.Reset();
+  }
+
+  // Space still waiting to be reclaimed belonged to the released buffers.
+  sGeometryGeneration++;
+
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::ReleaseGeometryArenas
+
+VkDeviceSize iris::Renderer::GeometryRange::Offset() const noexcept {
+  Expects(id != UINT32_MAX);
+  return Arena(kind).allocator.ranges[id].offset;
+} // iris::Renderer::GeometryRange::Offset
+
+iris::Renderer::GeometryRange::GeometryRange(GeometryRange&& other) noexcept
+  : kind(other.kind)
+  , id(other.id) {
+  other.id = UINT32_MAX;
+} // iris::Renderer::GeometryRange::GeometryRange
+
+iris::Renderer::GeometryRange& iris::Renderer::GeometryRange::
+operator=(GeometryRange&& rhs) noexcept {
+  // Swap so rhs frees the range this held.
+  std::swap(kind, rhs.kind);
+  std::swap(id, rhs.id);
+  return *this;
+} // iris::Renderer::GeometryRange::operator=
+
+iris::Renderer::GeometryRange::~GeometryRange() noexcept {
+  if (id == UINT32_MAX) return;
+
+  auto&& arena = Arena(kind);
+  auto&& ranges = arena.allocator.ranges;
+  if (id >= ranges.size() || !ranges[id].live) return;
+
+  DiscardBufferUploads(arena.buffer, ranges[id].offset, ranges[id].size);
+
+  // Frames in flight may still draw from the range, and with a transfer
+  // queue the copy into a range reusing its space could run while they do.
+  // If the buffer is replaced first, compaction already freed the space.
+  auto const space = arena.allocator.Retire(id);
+  QueueRelease(
+    [arenaKind = kind, space, generation = sGeometryGeneration]() {
+      if (generation == sGeometryGeneration) {
+        Arena(arenaKind).allocator.Reclaim(space.first, space.second);
+      }
+    });
+} // iris::Renderer::GeometryRange::~GeometryRange
@@ -0,0 +1,146 @@
+#ifndef HEV_IRIS_RENDERER_GEOMETRY_ARENA_H_
+#define HEV_IRIS_RENDERER_GEOMETRY_ARENA_H_
+/*! \file
+ * \brief Shared vertex and index buffers that meshes sub-allocate from.
+ *
+ * All mesh vertices live in one vertex buffer and all mesh indices in one
+ * index buffer. A mesh holds a GeometryRange of each and draws with the
+ * range's offset as vertexOffset or firstIndex, so every mesh shares the
+ * same two bindings. When an allocation does not fit, the live ranges are
+ * compacted into a new buffer, growing it if needed, and every range's
+ * offset changes: GeometryGeneration tells users when to re-read them.
+ *
+ * The arenas are only used from the render thread.
+ */
+
+#include "renderer/impl.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace iris::Renderer {
+
+//! \brief Which shared geometry buffer a range comes from.
+enum class GeometryKind {
+  kVertex = 0,
+  kIndex = 1,
+};
+
+/*! \brief The bookkeeping of one shared geometry buffer: where each range
+ * is and the free space between them. It never touches the GPU.
+ *
+ * Free space is kept as a map of offset to size so neighbouring free ranges
+ * can be merged when a range is freed, and allocations take the first free
+ * range they fit in. Range ids index ranges and are reused once freed.
+ */
+struct GeometryAllocator {
+  struct Range {
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    VkDeviceSize alignment{1};
+    bool live{false};
+  }; // struct Range
+
+  VkDeviceSize capacity{0};
+  VkDeviceSize bytesUsed{0};
+  std::map<VkDeviceSize, VkDeviceSize> freeSpace{};
+  std::vector<Range> ranges{};
+  std::vector<std::uint32_t> freeIds{};
+
+  /*! \brief Allocate \p size bytes at an offset that is a multiple of
+   * \p alignment from the first free range they fit in.
+   * \return the id of the new range, or UINT32_MAX if no free range is large
+   * enough.
+   */
+  std::uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment) noexcept;
+
+  //! \brief Free the range \p id, merging its space with the free ranges on
+  //! either side.
+  void Free(std::uint32_t id) noexcept;
+
+  /*! \brief Free the range \p id like Free, but keep its space out of the
+   * free ranges until it is passed to Reclaim, for space the GPU may still
+   * read. Compacting makes the space free without a Reclaim.
+   * \return the offset and size of the space.
+   */
+  std::pair<VkDeviceSize, VkDeviceSize> Retire(std::uint32_t id) noexcept;
+
+  //! \brief Return space from Retire to the free ranges, merging it with the
+  //! free ranges on either side.
+  void Reclaim(VkDeviceSize offset, VkDeviceSize size) noexcept;
+
+  /*! \brief The copies that move every live range to its place when packed
+   * from the start of a buffer in id order, each at its alignment. The
+   * destination offsets are those Compact gives the ranges.
+   */
+  std::vector<VkBufferCopy> CompactionRegions() const;
+
+  /*! \brief Move every live range to its place in CompactionRegions and
+   * make the rest of \p newCapacity bytes one free range. \p newCapacity
+   * must hold the packed ranges.
+   */
+  void Compact(VkDeviceSize newCapacity);
+
+  //! \brief Forget every range and the capacity.
+  void Reset() noexcept;
+}; // struct GeometryAllocator
+
+/*! \brief A range of one of the shared geometry buffers. The range is
+ * returned to its arena when destroyed, and its space is reused once the
+ * frames in flight that may still draw from it have completed.
+ */
+struct GeometryRange {
+  GeometryKind kind{GeometryKind::kVertex};
+  std::uint32_t id{UINT32_MAX};
+
+  //! \brief The current offset of the range in bytes; changes when the arena
+  //! is compacted.
+  VkDeviceSize Offset() const noexcept;
+
+  explicit operator bool() const noexcept { return id != UINT32_MAX; }
+
+  GeometryRange() = default;
+  GeometryRange(GeometryRange const&) = delete;
+  GeometryRange(GeometryRange&& other) noexcept;
+  GeometryRange& operator=(GeometryRange const&) = delete;
+  GeometryRange& operator=(GeometryRange&& rhs) noexcept;
+  ~GeometryRange() noexcept;
+}; // struct GeometryRange
+
+/*! \brief Allocate \p size bytes of the \p kind buffer at an offset that is a
+ * multiple of \p alignment and queue an upload of \p data to them.
+ *
+ * Vertex ranges should be aligned to the vertex stride and index ranges to
+ * the index size so their offsets convert exactly to vertexOffset and
+ * firstIndex.
+ */
+[[nodiscard]] tl::expected<GeometryRange, std::system_error>
+AllocateGeometry(GeometryKind kind, VkDeviceSize size, VkDeviceSize alignment,
+                 gsl::not_null<void const*> data) noexcept;
+
+/*! \brief Allocate like AllocateGeometry, but have \p write fill the range
+ * directly in staging memory instead of copying prepared data.
+ */
+[[nodiscard]] tl::expected<GeometryRange, std::system_error>
+AllocateGeometry(GeometryKind kind, VkDeviceSize size, VkDeviceSize alignment,
+                 std::function<void(std::byte*)> const& write) noexcept;
+
+//! \brief The shared buffer of \p kind, or VK_NULL_HANDLE before the first
+//! allocation.
+VkBuffer GeometryBuffer(GeometryKind kind) noexcept;
+
+//! \brief Incremented whenever a shared buffer is replaced or released and
+//! the offsets of existing ranges change.
+std::uint64_t GeometryGeneration() noexcept;
+
+//! \brief Destroy the shared buffers; must be called after every range has
+//! been destroyed and before the device is destroyed.
+void ReleaseGeometryArenas() noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_GEOMETRY_ARENA_H_
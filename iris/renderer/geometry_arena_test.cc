@@ -0,0 +1,164 @@
+#include "renderer/geometry_arena.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <map>
+
+using iris::Renderer::GeometryAllocator;
+
+static GeometryAllocator MakeAllocator(VkDeviceSize capacity) {
+  GeometryAllocator allocator;
+  allocator.Compact(capacity);
+  return allocator;
+} // MakeAllocator
+
+TEST(GeometryAllocator, StartsWithoutSpace) {
+  GeometryAllocator allocator;
+  EXPECT_EQ(allocator.Allocate(4, 4), UINT32_MAX);
+}
+
+TEST(GeometryAllocator, AllocatesFirstFit) {
+  auto allocator = MakeAllocator(1024);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  std::uint32_t const b = allocator.Allocate(200, 4);
+  std::uint32_t const c = allocator.Allocate(100, 4);
+  ASSERT_NE(a, UINT32_MAX);
+  ASSERT_NE(b, UINT32_MAX);
+  ASSERT_NE(c, UINT32_MAX);
+  EXPECT_EQ(allocator.ranges[a].offset, 0u);
+  EXPECT_EQ(allocator.ranges[b].offset, 100u);
+  EXPECT_EQ(allocator.ranges[c].offset, 300u);
+  EXPECT_EQ(allocator.bytesUsed, 400u);
+
+  // The hole b leaves is the first free range a small allocation fits in.
+  allocator.Free(b);
+  std::uint32_t const d = allocator.Allocate(50, 4);
+  EXPECT_EQ(d, b); // ids are reused
+  EXPECT_EQ(allocator.ranges[d].offset, 100u);
+
+  // One that does not fit in the rest of the hole goes after c.
+  std::uint32_t const e = allocator.Allocate(200, 4);
+  EXPECT_EQ(allocator.ranges[e].offset, 400u);
+
+  std::map<VkDeviceSize, VkDeviceSize> const expected{{150, 150},
+                                                      {600, 424}};
+  EXPECT_EQ(allocator.freeSpace, expected);
+}
+
+TEST(GeometryAllocator, AlignsOffsets) {
+  auto allocator = MakeAllocator(1024);
+
+  std::uint32_t const a = allocator.Allocate(10, 1);
+  std::uint32_t const b = allocator.Allocate(12, 12);
+  EXPECT_EQ(allocator.ranges[a].offset, 0u);
+  EXPECT_EQ(allocator.ranges[b].offset, 12u);
+
+  // The padding before b stays free.
+  std::map<VkDeviceSize, VkDeviceSize> const expected{{10, 2}, {24, 1000}};
+  EXPECT_EQ(allocator.freeSpace, expected);
+}
+
+TEST(GeometryAllocator, FailsWhenNothingFits) {
+  auto allocator = MakeAllocator(256);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  allocator.Allocate(100, 4);
+  allocator.Free(a);
+
+  // 156 bytes are free, but in two ranges.
+  EXPECT_EQ(allocator.Allocate(120, 4), UINT32_MAX);
+  EXPECT_EQ(allocator.bytesUsed, 100u);
+}
+
+TEST(GeometryAllocator, CoalescesFreedNeighbours) {
+  auto allocator = MakeAllocator(400);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  std::uint32_t const b = allocator.Allocate(100, 4);
+  std::uint32_t const c = allocator.Allocate(100, 4);
+  std::uint32_t const d = allocator.Allocate(100, 4);
+  EXPECT_TRUE(allocator.freeSpace.empty());
+
+  allocator.Free(a);
+  allocator.Free(c);
+  std::map<VkDeviceSize, VkDeviceSize> const separate{{0, 100}, {200, 100}};
+  EXPECT_EQ(allocator.freeSpace, separate);
+
+  // b merges with the free ranges on both sides.
+  allocator.Free(b);
+  std::map<VkDeviceSize, VkDeviceSize> const merged{{0, 300}};
+  EXPECT_EQ(allocator.freeSpace, merged);
+
+  allocator.Free(d);
+  std::map<VkDeviceSize, VkDeviceSize> const all{{0, 400}};
+  EXPECT_EQ(allocator.freeSpace, all);
+  EXPECT_EQ(allocator.bytesUsed, 0u);
+}
+
+TEST(GeometryAllocator, CompactsLiveRangesInIdOrder) {
+  auto allocator = MakeAllocator(1024);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  std::uint32_t const b = allocator.Allocate(100, 4);
+  std::uint32_t const c = allocator.Allocate(10, 1);
+  std::uint32_t const d = allocator.Allocate(24, 12);
+  ASSERT_EQ(allocator.ranges[d].offset, 216u);
+  allocator.Free(b);
+
+  auto const regions = allocator.CompactionRegions();
+  ASSERT_EQ(regions.size(), 3u);
+  EXPECT_EQ(regions[0].srcOffset, 0u);
+  EXPECT_EQ(regions[0].dstOffset, 0u);
+  EXPECT_EQ(regions[0].size, 100u);
+  EXPECT_EQ(regions[1].srcOffset, 200u);
+  EXPECT_EQ(regions[1].dstOffset, 100u);
+  EXPECT_EQ(regions[1].size, 10u);
+  // d keeps its alignment: 110 rounds up to 120.
+  EXPECT_EQ(regions[2].srcOffset, 216u);
+  EXPECT_EQ(regions[2].dstOffset, 120u);
+  EXPECT_EQ(regions[2].size, 24u);
+
+  allocator.Compact(2048);
+  EXPECT_EQ(allocator.capacity, 2048u);
+  EXPECT_EQ(allocator.ranges[a].offset, 0u);
+  EXPECT_EQ(allocator.ranges[c].offset, 100u);
+  EXPECT_EQ(allocator.ranges[d].offset, 120u);
+  EXPECT_EQ(allocator.bytesUsed, 134u);
+
+  std::map<VkDeviceSize, VkDeviceSize> const expected{{144, 1904}};
+  EXPECT_EQ(allocator.freeSpace, expected);
+}
+
+TEST(GeometryAllocator, HoldsRetiredSpaceUntilReclaimed) {
+  auto allocator = MakeAllocator(300);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  allocator.Allocate(100, 4);
+
+  auto const space = allocator.Retire(a);
+  EXPECT_EQ(space.first, 0u);
+  EXPECT_EQ(space.second, 100u);
+  EXPECT_EQ(allocator.bytesUsed, 100u);
+
+  // Only the space after b is free, so a's space is not reused yet.
+  std::uint32_t const c = allocator.Allocate(100, 4);
+  EXPECT_EQ(allocator.ranges[c].offset, 200u);
+  EXPECT_EQ(allocator.Allocate(4, 4), UINT32_MAX);
+
+  allocator.Reclaim(space.first, space.second);
+  std::uint32_t const d = allocator.Allocate(100, 4);
+  EXPECT_EQ(allocator.ranges[d].offset, 0u);
+}
+
+TEST(GeometryAllocator, CompactionFreesRetiredSpace) {
+  auto allocator = MakeAllocator(300);
+
+  std::uint32_t const a = allocator.Allocate(100, 4);
+  std::uint32_t const b = allocator.Allocate(100, 4);
+  allocator.Retire(a);
+
+  allocator.Compact(300);
+  EXPECT_EQ(allocator.ranges[b].offset, 0u);
+  std::map<VkDeviceSize, VkDeviceSize> const expected{{100, 200}};
+  EXPECT_EQ(allocator.freeSpace, expected);
+}
@@ -0,0 +1,400 @@
+#include "renderer/gpu_culling.h"
+#include "renderer/descriptor_sets.h"
+#include "renderer/pipeline.h"
+#include "renderer/shader.h"
+#include "logging.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iris::Renderer {
+
+//! \brief The push constants of assets/shaders/cull.comp.
+struct CullPushConstants {
+  std::array<glm::vec4, 6> planes;
+  glm::vec4 levelOfDetail;
+  std::uint32_t numMeshes;
+  std::uint32_t commandOffset;
+  std::uint32_t countIndex;
+}; // struct CullPushConstants
+
+static_assert(sizeof(CullPushConstants) <= 128,
+              "push constants exceed the guaranteed maxPushConstantsSize");
+
+static constexpr std::uint32_t const kCullWorkGroupSize{64};
+static constexpr std::uint32_t const kInitialNumMeshes{256};
+static constexpr std::uint32_t const kInitialNumViews{8};
+
+static std::shared_ptr<Shader const> sCullShader;
+static std::unique_ptr<Pipeline> sCullPipeline;
+static DescriptorSets sCullDescriptorSets{1};
+
+// sMeshCullBuffer holds one MeshCullData per mesh and stays persistently
+// mapped. sDrawCommandBuffer holds a region of sMeshCapacity slots for each
+// view in each frame in flight, and sDrawCountBuffer one count of drawn
+// meshes for each view in each frame in flight, read back by the host.
+static std::vector<MeshCullData> sMeshes;
+static std::size_t sNumMeshesUploaded{0};
+static std::uint32_t sMeshCapacity{0};
+static std::uint32_t sViewCapacity{0};
+
+static VkBuffer sMeshCullBuffer{VK_NULL_HANDLE};
+static VmaAllocation sMeshCullBufferAllocation{VK_NULL_HANDLE};
+static MeshCullData* sMeshCullBufferData{nullptr};
+static VkBuffer sDrawCommandBuffer{VK_NULL_HANDLE};
+static VmaAllocation sDrawCommandBufferAllocation{VK_NULL_HANDLE};
+static VkBuffer sDrawCountBuffer{VK_NULL_HANDLE};
+static VmaAllocation sDrawCountBufferAllocation{VK_NULL_HANDLE};
+static std::uint32_t* sDrawCountBufferData{nullptr};
+
+[[nodiscard]] static std::system_error
+CreateBuffer(VkDeviceSize size, VkBufferUsageFlags bufferUsage,
+             VmaMemoryUsage memoryUsage, std::string name, VkBuffer& buffer,
+             VmaAllocation& allocation, void** mappedData) noexcept {
+  VkBufferCreateInfo bufferCI = {};
+  bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCI.size = size;
+  bufferCI.usage = bufferUsage;
+
+  VmaAllocationCreateInfo allocationCI = {};
+  allocationCI.usage = memoryUsage;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+  if (mappedData) allocationCI.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  allocationCI.pUserData = name.data();
+
+  VmaAllocationInfo allocationInfo;
+  if (auto result = vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI,
+                                    &buffer, &allocation, &allocationInfo);
+      result != VK_SUCCESS) {
+    return {make_error_code(result), "Error creating " + name};
+  }
+
+  NameObject(VK_OBJECT_TYPE_BUFFER, buffer, name.c_str());
+  if (mappedData) *mappedData = allocationInfo.pMappedData;
+
+  return {Error::kNone};
+} // CreateBuffer
+
+static void DestroyBuffers() noexcept {
+  if (sMeshCullBuffer != VK_NULL_HANDLE) {
+    vmaDestroyBuffer(sAllocator, sMeshCullBuffer, sMeshCullBufferAllocation);
+  }
+  if (sDrawCommandBuffer != VK_NULL_HANDLE) {
+    vmaDestroyBuffer(sAllocator, sDrawCommandBuffer,
+                     sDrawCommandBufferAllocation);
+  }
+  if (sDrawCountBuffer != VK_NULL_HANDLE) {
+    vmaDestroyBuffer(sAllocator, sDrawCountBuffer, sDrawCountBufferAllocation);
+  }
+
+  sMeshCullBuffer = sDrawCommandBuffer = sDrawCountBuffer = VK_NULL_HANDLE;
+  sMeshCullBufferAllocation = sDrawCommandBufferAllocation =
+    sDrawCountBufferAllocation = VK_NULL_HANDLE;
+  sMeshCullBufferData = nullptr;
+  sDrawCountBufferData = nullptr;
+  sMeshCapacity = sViewCapacity = 0;
+} // DestroyBuffers
+
+/*! \brief Create the buffers with room for \p meshCapacity meshes in
+ * \p viewCapacity views, copy every mesh into sMeshCullBuffer and point the
+ * culling descriptor set at them.
+ */
+[[nodiscard]] static std::system_error
+CreateBuffers(std::uint32_t meshCapacity,
+              std::uint32_t viewCapacity) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sMeshCullBuffer == VK_NULL_HANDLE);
+  Expects(meshCapacity >= sMeshes.size());
+
+  std::uint32_t const numRegions = viewCapacity * sNumFramesInFlight;
+  void* meshCullBufferData;
+  void* drawCountBufferData;
+
+  if (auto error =
+        CreateBuffer(sizeof(MeshCullData) * meshCapacity,
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     VMA_MEMORY_USAGE_CPU_TO_GPU, "sMeshCullBuffer",
+                     sMeshCullBuffer, sMeshCullBufferAllocation,
+                     &meshCullBufferData);
+      error.code()) {
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  // Transfers out of it let the commands be read back and checked.
+  if (auto error = CreateBuffer(
+        kDrawCommandStride * meshCapacity * numRegions,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY, "sDrawCommandBuffer", sDrawCommandBuffer,
+        sDrawCommandBufferAllocation, nullptr);
+      error.code()) {
+    DestroyBuffers();
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  if (auto error = CreateBuffer(
+        sizeof(std::uint32_t) * numRegions,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_TO_CPU, "sDrawCountBuffer", sDrawCountBuffer,
+        sDrawCountBufferAllocation, &drawCountBufferData);
+      error.code()) {
+    DestroyBuffers();
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  sMeshCullBufferData = static_cast<MeshCullData*>(meshCullBufferData);
+  sDrawCountBufferData = static_cast<std::uint32_t*>(drawCountBufferData);
+  sMeshCapacity = meshCapacity;
+  sViewCapacity = viewCapacity;
+
+  std::copy(sMeshes.begin(), sMeshes.end(), sMeshCullBufferData);
+  vmaFlushAllocation(sAllocator, sMeshCullBufferAllocation, 0, VK_WHOLE_SIZE);
+  sNumMeshesUploaded = sMeshes.size();
+
+  std::fill_n(sDrawCountBufferData, numRegions, 0);
+  vmaFlushAllocation(sAllocator, sDrawCountBufferAllocation, 0, VK_WHOLE_SIZE);
+
+  VkDescriptorBufferInfo meshCullBufferInfo = {sMeshCullBuffer, 0,
+                                               VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo drawCommandBufferInfo = {sDrawCommandBuffer, 0,
+                                                  VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo drawCountBufferInfo = {sDrawCountBuffer, 0,
+                                                VK_WHOLE_SIZE};
+
+  absl::FixedArray<VkWriteDescriptorSet> writeDescriptorSets(3);
+  for (std::uint32_t i = 0; i < 3; ++i) {
+    writeDescriptorSets[i] = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,                           // pNext
+      sCullDescriptorSets.sets[0],       // dstSet
+      i,                                 // dstBinding
+      0,                                 // dstArrayElement
+      1,                                 // descriptorCount
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // descriptorType
+      nullptr,                           // pImageInfo
+      nullptr,                           // pBufferInfo
+      nullptr                            // pTexelBufferView
+    };
+  }
+  writeDescriptorSets[0].pBufferInfo = &meshCullBufferInfo;
+  writeDescriptorSets[1].pBufferInfo = &drawCommandBufferInfo;
+  writeDescriptorSets[2].pBufferInfo = &drawCountBufferInfo;
+
+  UpdateDescriptorSets(writeDescriptorSets);
+
+  Ensures(sMeshCullBufferData != nullptr);
+  Ensures(sDrawCountBufferData != nullptr);
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // CreateBuffers
+
+} // namespace iris::Renderer
+
+std::system_error iris::Renderer::InitializeGPUCulling() noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+
+  if (auto cs = GetShaderVariant("assets/shaders/cull.comp",
+                                 VK_SHADER_STAGE_COMPUTE_BIT)) {
+    sCullShader = std::move(*cs);
+  } else {
+    IRIS_LOG_LEAVE();
+    return cs.error();
+  }
+
+  absl::FixedArray<VkDescriptorSetLayoutBinding> bindings(3);
+  for (std::uint32_t i = 0; i < 3; ++i) {
+    bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                   VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+  }
+
+  if (auto d = AllocateDescriptorSets(bindings, 1, "sCullDescriptorSets")) {
+    sCullDescriptorSets = std::move(*d);
+  } else {
+    IRIS_LOG_LEAVE();
+    return d.error();
+  }
+
+  VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                           sizeof(CullPushConstants)};
+
+  if (auto p = Pipeline::CreateCompute(
+        gsl::make_span(&sCullDescriptorSets.layout, 1),
+        gsl::make_span(&pushConstantRange, 1), *sCullShader,
+        "sCullPipeline")) {
+    sCullPipeline = std::make_unique<Pipeline>(std::move(*p));
+  } else {
+    IRIS_LOG_LEAVE();
+    return p.error();
+  }
+
+  if (auto error = CreateBuffers(kInitialNumMeshes, kInitialNumViews);
+      error.code()) {
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::InitializeGPUCulling
+
+void iris::Renderer::AddGPUCullingMesh(MeshCullData const& data) noexcept {
+  sMeshes.push_back(data);
+} // iris::Renderer::AddGPUCullingMesh
+
+void iris::Renderer::UpdateGPUCullingMesh(std::size_t index,
+                                          MeshCullData const& data) noexcept {
+  Expects(index < sMeshes.size());
+  sMeshes[index] = data;
+  sNumMeshesUploaded = std::min(sNumMeshesUploaded, index);
+} // iris::Renderer::UpdateGPUCullingMesh
+
+tl::expected<bool, std::system_error>
+iris::Renderer::PrepareGPUCulling(std::uint32_t numViews) noexcept {
+  if (sMeshes.size() <= sMeshCapacity && numViews <= sViewCapacity) {
+    if (sNumMeshesUploaded == sMeshes.size()) return false;
+
+    // In-flight frames only read the slots of meshes they were recorded
+    // with, so new meshes can be written behind them.
+    std::copy(sMeshes.begin() + sNumMeshesUploaded, sMeshes.end(),
+              sMeshCullBufferData + sNumMeshesUploaded);
+    vmaFlushAllocation(sAllocator, sMeshCullBufferAllocation,
+                       sizeof(MeshCullData) * sNumMeshesUploaded,
+                       sizeof(MeshCullData) *
+                         (sMeshes.size() - sNumMeshesUploaded));
+    sNumMeshesUploaded = sMeshes.size();
+    return false;
+  }
+
+  IRIS_LOG_ENTER();
+
+  std::uint32_t const numMeshes =
+    gsl::narrow_cast<std::uint32_t>(sMeshes.size());
+  std::uint32_t const meshCapacity =
+    numMeshes > sMeshCapacity ? std::max(numMeshes, sMeshCapacity * 2)
+                              : sMeshCapacity;
+  std::uint32_t const viewCapacity =
+    numViews > sViewCapacity ? std::max(numViews, sViewCapacity * 2)
+                             : sViewCapacity;
+
+  vkDeviceWaitIdle(sDevice);
+  DestroyBuffers();
+
+  if (auto error = CreateBuffers(meshCapacity, viewCapacity); error.code()) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(error);
+  }
+
+  GetLogger()->debug("GPU culling buffers grown to {} meshes in {} views",
+                     meshCapacity, viewCapacity);
+  IRIS_LOG_LEAVE();
+  return true;
+} // iris::Renderer::PrepareGPUCulling
+
+void iris::Renderer::RecordGPUCulling(
+  VkCommandBuffer commandBuffer,
+  gsl::span<std::array<glm::vec4, 6> const> viewFrustumPlanes,
+  gsl::span<glm::vec4 const> viewLevelsOfDetail) noexcept {
+  Expects(sCullPipeline);
+  Expects(viewFrustumPlanes.size() <= sViewCapacity);
+  Expects(viewLevelsOfDetail.size() == viewFrustumPlanes.size());
+  Expects(sNumMeshesUploaded == sMeshes.size());
+
+  std::uint32_t const numViews =
+    gsl::narrow_cast<std::uint32_t>(viewFrustumPlanes.size());
+  std::uint32_t const numMeshes =
+    gsl::narrow_cast<std::uint32_t>(sMeshes.size());
+  if (numViews == 0) return;
+
+  std::uint32_t const firstRegion = sViewCapacity * sFrameIndex;
+  vkCmdFillBuffer(commandBuffer, sDrawCountBuffer,
+                  sizeof(std::uint32_t) * firstRegion,
+                  sizeof(std::uint32_t) * numViews, 0);
+
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask =
+    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+
+  if (numMeshes > 0) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      *sCullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            sCullPipeline->layout, 0, 1,
+                            sCullDescriptorSets.sets.data(), 0, nullptr);
+
+    std::uint32_t const numWorkGroups =
+      (numMeshes + kCullWorkGroupSize - 1) / kCullWorkGroupSize;
+
+    for (std::uint32_t i = 0; i < numViews; ++i) {
+      CullPushConstants pushConstants;
+      pushConstants.planes = viewFrustumPlanes[i];
+      pushConstants.levelOfDetail = viewLevelsOfDetail[i];
+      pushConstants.numMeshes = numMeshes;
+      pushConstants.commandOffset = (firstRegion + i) * sMeshCapacity;
+      pushConstants.countIndex = firstRegion + i;
+
+      vkCmdPushConstants(commandBuffer, sCullPipeline->layout,
+                         VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                         sizeof(CullPushConstants), &pushConstants);
+      vkCmdDispatch(commandBuffer, numWorkGroups, 1, 1);
+    }
+  }
+
+  // The draw commands are consumed by this frame's indirect draws and the
+  // counts by the host once the frame's fence has signaled.
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask =
+    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+  vkCmdPipelineBarrier(
+    commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+    &barrier, 0, nullptr, 0, nullptr);
+} // iris::Renderer::RecordGPUCulling
+
+VkBuffer iris::Renderer::GPUCullingDrawCommandBuffer() noexcept {
+  return sDrawCommandBuffer;
+} // iris::Renderer::GPUCullingDrawCommandBuffer
+
+VkDeviceSize
+iris::Renderer::GPUCullingDrawCommandOffset(std::uint32_t frameIndex,
+                                            std::uint32_t viewIndex) noexcept {
+  Expects(viewIndex < sViewCapacity);
+  return kDrawCommandStride * sMeshCapacity *
+         (sViewCapacity * frameIndex + viewIndex);
+} // iris::Renderer::GPUCullingDrawCommandOffset
+
+std::uint32_t
+iris::Renderer::GPUCullingNumDrawn(std::uint32_t viewIndex) noexcept {
+  if (viewIndex >= sViewCapacity || sDrawCountBufferData == nullptr) return 0;
+  std::uint32_t const countIndex = sViewCapacity * sFrameIndex + viewIndex;
+
+  vmaInvalidateAllocation(sAllocator, sDrawCountBufferAllocation,
+                          sizeof(std::uint32_t) * countIndex,
+                          sizeof(std::uint32_t));
+  return sDrawCountBufferData[countIndex];
+} // iris::Renderer::GPUCullingNumDrawn
+
+void iris::Renderer::ShutdownGPUCulling() noexcept {
+  IRIS_LOG_ENTER();
+
+  DestroyBuffers();
+  sCullPipeline.reset();
+  sCullShader.reset();
+  sCullDescriptorSets = DescriptorSets(1);
+  sMeshes.clear();
+  sNumMeshesUploaded = 0;
+
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::ShutdownGPUCulling
@@ -0,0 +1,118 @@
+#ifndef HEV_IRIS_RENDERER_GPU_CULLING_H_
+#define HEV_IRIS_RENDERER_GPU_CULLING_H_
+/*! \file
+ * \brief GPU frustum culling that writes indirect draw commands.
+ *
+ * Every mesh has one fixed slot per view and frame in flight in a buffer of
+ * indirect draw commands. A compute pass tests each mesh against each view's
+ * frustum and fills in its slot, with an instance count of zero when the mesh
+ * is culled and the index range of the level of detail it needs from that
+ * view otherwise. Secondary command buffers draw every mesh indirectly from
+ * its slot, so they only change when the scene does.
+ *
+ * The commands are not compacted into a count-driven multi-draw: every mesh
+ * binds its own descriptor set between draws, so such a draw could only
+ * ever cover one mesh.
+ */
+
+#include "glm/vec4.hpp"
+#include "renderer/impl.h"
+#include "renderer/mesh.h"
+#include <array>
+#include <cstdint>
+#include <system_error>
+
+namespace iris::Renderer {
+
+//! \brief A level of detail in MeshCullData; matches LevelCullData in
+//! assets/shaders/cull.comp.
+struct LevelCullData {
+  std::uint32_t firstIndex{0}; // relative to MeshCullData::firstIndex
+  std::uint32_t numIndices{0};
+  float error{0.f};
+  std::uint32_t pad0{0};
+}; // struct LevelCullData
+
+static_assert(sizeof(LevelCullData) == 16,
+              "LevelCullData must match the std430 layout in cull.comp");
+
+//! \brief Per-mesh input to the culling shader; matches MeshCullData in
+//! assets/shaders/cull.comp.
+struct MeshCullData {
+  glm::vec4 boundingSphere{0.f, 0.f, 0.f, 0.f};
+  std::uint32_t numIndices{0};
+  std::uint32_t numVertices{0};
+  std::uint32_t numInstances{1};
+  std::uint32_t firstIndex{0};
+  std::int32_t vertexOffset{0};
+  std::uint32_t numLevels{0};
+  std::uint32_t pad0{0};
+  std::uint32_t pad1{0};
+  //! Mesh::levelsOfDetail, as many as fit.
+  std::array<LevelCullData, MeshData::kMaxLevelsOfDetail> levels{};
+}; // struct MeshCullData
+
+// std430: the sphere, eight 32-bit words and kMaxLevelsOfDetail levels.
+static_assert(sizeof(MeshCullData) == 144,
+              "MeshCullData must match the std430 layout in cull.comp");
+
+//! The distance in bytes between consecutive mesh slots in the draw command
+//! buffer; large enough for either kind of indirect draw command.
+constexpr VkDeviceSize kDrawCommandStride{
+  sizeof(VkDrawIndexedIndirectCommand)};
+
+/*! \brief Create the culling pipeline and buffers. Must be called after the
+ * descriptor pools and pipeline cache have been created.
+ */
+[[nodiscard]] std::system_error InitializeGPUCulling() noexcept;
+
+//! \brief Append a mesh; meshes are culled in the order they are added.
+void AddGPUCullingMesh(MeshCullData const& data) noexcept;
+
+//! \brief Replace the data of the mesh at \p index, for example after its
+//! geometry moved. Must not be called while frames in flight still cull it.
+void UpdateGPUCullingMesh(std::size_t index, MeshCullData const& data) noexcept;
+
+/*! \brief Upload meshes added or updated since the last call and make sure
+ * the buffers have room for every mesh in \p numViews views. Growing the
+ * buffers waits for the device to go idle and moves every slot.
+ * \return true if the buffers were recreated, which invalidates recorded
+ * indirect draws.
+ */
+[[nodiscard]] tl::expected<bool, std::system_error>
+PrepareGPUCulling(std::uint32_t numViews) noexcept;
+
+/*! \brief Record the culling pass of the current frame in flight into
+ * \p commandBuffer, one dispatch per view in \p viewFrustumPlanes. Each
+ * entry of \p viewLevelsOfDetail holds the view position in xyz and the
+ * scale that projects level of detail errors to pixel thresholds in w.
+ * Must be recorded outside of a render pass; the draw commands are ready
+ * for indirect draws recorded after it.
+ */
+void RecordGPUCulling(
+  VkCommandBuffer commandBuffer,
+  gsl::span<std::array<glm::vec4, 6> const> viewFrustumPlanes,
+  gsl::span<glm::vec4 const> viewLevelsOfDetail) noexcept;
+
+//! \brief The buffer holding the indirect draw commands.
+VkBuffer GPUCullingDrawCommandBuffer() noexcept;
+
+//! \brief The offset of the first slot of view \p viewIndex in frame in
+//! flight \p frameIndex; a mesh's slot is kDrawCommandStride * its index
+//! past this.
+VkDeviceSize GPUCullingDrawCommandOffset(std::uint32_t frameIndex,
+                                         std::uint32_t viewIndex) noexcept;
+
+/*! \brief The number of meshes drawn in view \p viewIndex the last time the
+ * current frame in flight was rendered. Only valid after that frame's fence
+ * has signaled.
+ */
+std::uint32_t GPUCullingNumDrawn(std::uint32_t viewIndex) noexcept;
+
+//! \brief Destroy the culling pipeline and buffers; must be called before
+//! the device is destroyed.
+void ShutdownGPUCulling() noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_GPU_CULLING_H_
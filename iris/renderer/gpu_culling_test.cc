@@ -0,0 +1,157 @@
+#include "renderer/gpu_culling.h"
+#include "renderer/buffer.h"
+#include "renderer/renderer.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using iris::Renderer::Buffer;
+using iris::Renderer::GPUCullingDrawCommandBuffer;
+using iris::Renderer::GPUCullingDrawCommandOffset;
+using iris::Renderer::GPUCullingNumDrawn;
+using iris::Renderer::kDrawCommandStride;
+using iris::Renderer::MeshCullData;
+
+//! The normalized planes of the view volume [-1, 1]^3.
+static std::array<glm::vec4, 6> const kUnitBoxPlanes{{{1.f, 0.f, 0.f, 1.f},
+                                                      {-1.f, 0.f, 0.f, 1.f},
+                                                      {0.f, 1.f, 0.f, 1.f},
+                                                      {0.f, -1.f, 0.f, 1.f},
+                                                      {0.f, 0.f, 1.f, 1.f},
+                                                      {0.f, 0.f, -1.f, 1.f}}};
+
+//! \brief An indexed mesh of 300 indices bounded by \p sphere.
+static MeshCullData Indexed(glm::vec4 sphere, std::uint32_t numInstances) {
+  MeshCullData data;
+  data.boundingSphere = sphere;
+  data.numIndices = 300;
+  data.numVertices = 100;
+  data.numInstances = numInstances;
+  data.firstIndex = 1000;
+  data.vertexOffset = 50;
+  return data;
+} // Indexed
+
+using DrawCommand = std::array<std::uint32_t, 5>;
+
+/*! \brief Cull the meshes added so far in one view per entry of
+ * \p viewLevelsOfDetail, all with kUnitBoxPlanes, and read back the
+ * \p numMeshes draw commands each view got.
+ */
+static std::vector<std::vector<DrawCommand>>
+Cull(std::vector<glm::vec4> const& viewLevelsOfDetail, std::size_t numMeshes) {
+  using namespace iris::Renderer;
+  std::size_t const numViews = viewLevelsOfDetail.size();
+  std::vector<std::vector<DrawCommand>> commands(numViews);
+
+  auto grown = PrepareGPUCulling(gsl::narrow_cast<std::uint32_t>(numViews));
+  EXPECT_TRUE(grown) << grown.error().what();
+  if (!grown) return commands;
+
+  VkDeviceSize const regionSize = kDrawCommandStride * numMeshes;
+  auto readback =
+    Buffer::Create(regionSize * numViews, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                   VMA_MEMORY_USAGE_GPU_TO_CPU, "readback");
+  EXPECT_TRUE(readback) << readback.error().what();
+  if (!readback) return commands;
+
+  auto commandBuffer = BeginOneTimeSubmit();
+  EXPECT_TRUE(commandBuffer) << commandBuffer.error().what();
+  if (!commandBuffer) return commands;
+
+  std::vector<std::array<glm::vec4, 6>> const planes(numViews,
+                                                     kUnitBoxPlanes);
+  RecordGPUCulling(*commandBuffer, planes, viewLevelsOfDetail);
+
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(*commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+
+  std::vector<VkBufferCopy> regions(numViews);
+  for (std::size_t i = 0; i < numViews; ++i) {
+    regions[i] = {GPUCullingDrawCommandOffset(
+                    sFrameIndex, gsl::narrow_cast<std::uint32_t>(i)),
+                  regionSize * i, regionSize};
+  }
+  vkCmdCopyBuffer(*commandBuffer, GPUCullingDrawCommandBuffer(), *readback,
+                  gsl::narrow_cast<std::uint32_t>(regions.size()),
+                  regions.data());
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(*commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr,
+                       0, nullptr);
+
+  auto const error = EndOneTimeSubmit(*commandBuffer);
+  EXPECT_FALSE(error.code()) << error.what();
+  if (error.code()) return commands;
+
+  auto data = readback->Map<DrawCommand const*>();
+  EXPECT_TRUE(data) << data.error().what();
+  if (!data) return commands;
+
+  vmaInvalidateAllocation(sAllocator, readback->allocation, 0, VK_WHOLE_SIZE);
+  for (std::size_t i = 0; i < numViews; ++i) {
+    commands[i].assign(*data + numMeshes * i, *data + numMeshes * (i + 1));
+  }
+  readback->Unmap(0, 0);
+
+  return commands;
+} // Cull
+
+TEST(GPUCulling, WritesDrawCommandsOfEveryMesh) {
+  if (auto error = iris::Renderer::Initialize(
+        "gpu_culling_test", iris::Renderer::Options::kGPUCulling);
+      error.code()) {
+    GTEST_SKIP() << "No usable Vulkan device: " << error.what();
+  }
+
+  // Inside, with two coarser levels of detail.
+  MeshCullData withLevels = Indexed({0.5f, 0.f, 0.f, 0.1f}, 4);
+  withLevels.numLevels = 2;
+  withLevels.levels[0] = {300, 120, 0.1f};
+  withLevels.levels[1] = {420, 30, 1.f};
+  iris::Renderer::AddGPUCullingMesh(withLevels);
+
+  // Outside, and straddling the +x plane.
+  iris::Renderer::AddGPUCullingMesh(Indexed({5.f, 0.f, 0.f, 0.5f}, 1));
+  iris::Renderer::AddGPUCullingMesh(Indexed({1.05f, 0.f, 0.f, 0.1f}, 2));
+
+  // Non-indexed, around the view position.
+  MeshCullData nonIndexed;
+  nonIndexed.boundingSphere = {0.f, 0.f, 0.f, 0.2f};
+  nonIndexed.numVertices = 36;
+  nonIndexed.numInstances = 3;
+  nonIndexed.vertexOffset = 7;
+  iris::Renderer::AddGPUCullingMesh(nonIndexed);
+
+  // Both views are at the origin; from the second every level of detail
+  // error projects ten times larger.
+  auto const commands = Cull({{0.f, 0.f, 0.f, 1.f}, {0.f, 0.f, 0.f, 10.f}}, 4);
+  ASSERT_EQ(commands.size(), 2u);
+  ASSERT_EQ(commands[0].size(), 4u);
+  ASSERT_EQ(commands[1].size(), 4u);
+
+  // 0.4 away, the first level's error of 0.1 is under the threshold and the
+  // second's of 1 is not.
+  EXPECT_EQ(commands[0][0], (DrawCommand{120, 4, 1300, 50, 0}));
+  EXPECT_EQ(commands[0][1], (DrawCommand{300, 0, 1000, 50, 0}));
+  EXPECT_EQ(commands[0][2], (DrawCommand{300, 2, 1000, 50, 0}));
+  EXPECT_EQ(commands[0][3], (DrawCommand{36, 3, 7, 0, 0}));
+
+  EXPECT_EQ(commands[1][0], (DrawCommand{300, 4, 1000, 50, 0}));
+  EXPECT_EQ(commands[1][1], commands[0][1]);
+  EXPECT_EQ(commands[1][2], commands[0][2]);
+  EXPECT_EQ(commands[1][3], commands[0][3]);
+
+  EXPECT_EQ(GPUCullingNumDrawn(0), 3u);
+  EXPECT_EQ(GPUCullingNumDrawn(1), 3u);
+
+  iris::Renderer::Shutdown();
+}
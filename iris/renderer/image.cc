@@ -1,6 +1,6 @@
 #include "renderer/image.h"
 #include "logging.h"
-#include "renderer/buffer.h"
+#include "renderer/upload.h"
 
 tl::expected<iris::Renderer::ImageView, std::system_error>
 iris::Renderer::ImageView::Create(
@@ -118,6 +118,7 @@ iris::Renderer::Image::Create(VkImageType type, VkFormat format,
 
   image.type = type;
   image.format = format;
+  image.mipLevels = mipLevels;
   image.name = std::move(name);
 
   Ensures(image.handle != VK_NULL_HANDLE);
@@ -130,15 +131,17 @@ iris::Renderer::Image::CreateFromMemory(
   VkImageType type, VkFormat format, VkExtent3D extent, VkImageUsageFlags usage,
   VmaMemoryUsage memoryUsage, gsl::not_null<std::byte*> pixels,
   std::uint32_t bytesPerPixel, std::string name,
-  VkCommandPool commandPool) noexcept {
+  std::uint32_t mipLevels) noexcept {
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
+  Expects(mipLevels > 0);
 
   Image image;
   VkDeviceSize imageSize;
 
   switch(format) {
   case VK_FORMAT_R8G8B8A8_UNORM:
+  case VK_FORMAT_R8G8B8A8_SRGB:
     Expects(bytesPerPixel == sizeof(char) * 4);
     imageSize = extent.width * extent.height * extent.depth * sizeof(char) * 4;
     break;
@@ -153,37 +156,18 @@ iris::Renderer::Image::CreateFromMemory(
       std::terminate();
   }
 
-  Buffer stagingBuffer;
-  if (auto sb = Buffer::Create(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                               VMA_MEMORY_USAGE_CPU_TO_GPU)) {
-    stagingBuffer = std::move(*sb);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(
-      std::system_error(sb.error().code(), "Cannot create staging buffer"));
-  }
-
-  if (auto p = stagingBuffer.Map<unsigned char*>()) {
-    std::memcpy(*p, pixels, imageSize);
-  } else {
-    using namespace std::string_literals;
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(std::system_error(
-      p.error().code(), "Cannot map staging buffer: "s + p.error().what()));
-  }
-
-  stagingBuffer.Unmap();
-
   VkImageCreateInfo imageCI = {};
   imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageCI.imageType = type;
   imageCI.format = format;
   imageCI.extent = extent;
-  imageCI.mipLevels = 1;
+  imageCI.mipLevels = mipLevels;
   imageCI.arrayLayers = 1;
   imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
   imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
   imageCI.usage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  // The other levels are blitted from the first.
+  if (mipLevels > 1) imageCI.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
   imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
@@ -203,45 +187,12 @@ iris::Renderer::Image::CreateFromMemory(
       std::system_error(make_error_code(result), "Cannot create image"));
   }
 
-  if (auto error = image.Transition(VK_IMAGE_LAYOUT_UNDEFINED,
-                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, 1,
-                                    commandPool);
-      error.code()) {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(error);
-  }
-
-  VkCommandBuffer commandBuffer;
-  if (auto cb = BeginOneTimeSubmit(commandPool)) {
-    commandBuffer = *cb;
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(cb.error());
-  }
-
-  VkBufferImageCopy region = {};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = extent;
-
-  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.handle, image.handle,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-  if (auto error = EndOneTimeSubmit(commandBuffer, commandPool);
-      error.code()) {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(error);
-  }
-
-  if (auto error =
-        image.Transition(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                         (memoryUsage == VMA_MEMORY_USAGE_GPU_ONLY
-                            ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-                            : VK_IMAGE_LAYOUT_GENERAL),
-                         1, 1, commandPool);
+  if (auto error = QueueImageUpload(
+        image.handle, extent,
+        (memoryUsage == VMA_MEMORY_USAGE_GPU_ONLY
+           ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+           : VK_IMAGE_LAYOUT_GENERAL),
+        imageSize, pixels, mipLevels);
       error.code()) {
     IRIS_LOG_LEAVE();
     return tl::unexpected(error);
@@ -253,6 +204,7 @@ iris::Renderer::Image::CreateFromMemory(
 
   image.type = type;
   image.format = format;
+  image.mipLevels = mipLevels;
   image.name = std::move(name);
 
   Ensures(image.handle != VK_NULL_HANDLE);
@@ -261,7 +213,7 @@ iris::Renderer::Image::CreateFromMemory(
 } // iris::Renderer::Image::CreateFromMemory
 
 std::system_error iris::Renderer::Image::Transition(
-  VkImageLayout oldLayout, VkImageLayout newLayout, std::uint32_t mipLevels,
+  VkImageLayout oldLayout, VkImageLayout newLayout, std::uint32_t mipLevels_,
   std::uint32_t arrayLayers, VkCommandPool commandPool) noexcept {
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
@@ -275,7 +227,7 @@ std::system_error iris::Renderer::Image::Transition(
   barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
   barrier.image = handle;
   barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = mipLevels;
+  barrier.subresourceRange.levelCount = mipLevels_;
   barrier.subresourceRange.baseArrayLayer = 0;
   barrier.subresourceRange.layerCount = arrayLayers;
 
@@ -344,6 +296,7 @@ std::system_error iris::Renderer::Image::Transition(
 iris::Renderer::Image::Image(Image&& other) noexcept
   : type(other.type)
   , format(other.format)
+  , mipLevels(other.mipLevels)
   , handle(other.handle)
   , allocation(other.allocation)
   , name(std::move(other.name)) {
@@ -356,6 +309,7 @@ iris::Renderer::Image& iris::Renderer::Image::operator=(Image&& rhs) noexcept {
 
   type = rhs.type;
   format = rhs.format;
+  mipLevels = rhs.mipLevels;
   handle = rhs.handle;
   allocation = rhs.allocation;
   name = std::move(rhs.name);
@@ -371,6 +325,7 @@ iris::Renderer::Image::~Image() noexcept {
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
 
+  DiscardImageUploads(handle);
   vmaDestroyImage(sAllocator, handle, allocation);
 
   IRIS_LOG_LEAVE();
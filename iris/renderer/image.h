@@ -40,12 +40,16 @@ struct Image {
          VkSampleCountFlagBits samples, VkImageUsageFlags usage,
          VmaMemoryUsage memoryUsage, std::string name = {}) noexcept;
 
+  /*! \brief Create an image and queue an upload of \p pixels to it; see
+   * QueueImageUpload for when it may be used. If \p mipLevels is greater
+   * than 1 the other levels are generated on the GPU as part of the upload.
+   */
   static tl::expected<Image, std::system_error>
   CreateFromMemory(VkImageType imageType, VkFormat format, VkExtent3D extent,
                    VkImageUsageFlags usage, VmaMemoryUsage memoryUsage,
                    gsl::not_null<std::byte*> pixels,
                    std::uint32_t bytesPerPixel, std::string name = {},
-                   VkCommandPool commandPool = VK_NULL_HANDLE) noexcept;
+                   std::uint32_t mipLevels = 1) noexcept;
 
   tl::expected<ImageView, std::system_error> CreateImageView(
     VkImageViewType type_, VkImageSubresourceRange imageSubresourceRange,
@@ -59,11 +63,12 @@ struct Image {
 
   [[nodiscard]] std::system_error
   Transition(VkImageLayout oldLayout, VkImageLayout newLayout,
-             std::uint32_t mipLevels = 1, std::uint32_t arrayLayers = 1,
+             std::uint32_t mipLevels_ = 1, std::uint32_t arrayLayers = 1,
              VkCommandPool commandPool = VK_NULL_HANDLE) noexcept;
 
   VkImageType type;
   VkFormat format{VK_FORMAT_UNDEFINED};
+  std::uint32_t mipLevels{1};
   VkImage handle{VK_NULL_HANDLE};
   VmaAllocation allocation{VK_NULL_HANDLE};
 
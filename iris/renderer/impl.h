@@ -9,6 +9,7 @@
 #include "renderer/renderer.h"
 #include "renderer/vulkan.h"
 #include <cstdint>
+#include <string>
 #include <system_error>
 #include <vector>
 
@@ -19,9 +20,28 @@ extern VkPhysicalDevice sPhysicalDevice;
 extern std::uint32_t sGraphicsQueueFamilyIndex;
 extern VkDevice sDevice;
 extern VkQueue sGraphicsCommandQueue;
-extern VkFence sFrameComplete;
+
+//! The queue uploads are submitted to and its family. It is
+//! sGraphicsCommandQueue when the device has no other queue to spare.
+extern std::uint32_t sTransferQueueFamilyIndex;
+extern VkQueue sTransferCommandQueue;
+
 extern VmaAllocator sAllocator;
 
+//! Whether loaders reorder triangles to reduce overdraw; see
+//! MeshData::Optimize.
+extern bool sReduceOverdraw;
+
+//! The most frames the CPU may record ahead of the GPU.
+constexpr std::uint32_t kMaxFramesInFlight = 3;
+
+//! The number of frames in flight, at most kMaxFramesInFlight.
+extern std::uint32_t sNumFramesInFlight;
+
+//! The frame in flight currently being recorded, in [0, sNumFramesInFlight).
+//! Per-frame resources indexed by it are no longer in use by the GPU.
+extern std::uint32_t sFrameIndex;
+
 // These are the desired properties of all surfaces for the renderer.
 extern VkSurfaceFormatKHR sSurfaceColorFormat;
 extern VkFormat sSurfaceDepthStencilFormat;
@@ -35,6 +55,7 @@ extern std::uint32_t sDepthStencilTargetAttachmentIndex;
 extern std::uint32_t sDepthStencilResolveAttachmentIndex;
 
 extern VkRenderPass sRenderPass;
+extern VkPipelineCache sPipelineCache;
 extern VkDescriptorSetLayout sBaseDescriptorSetLayout;
 
 // FIXME: putting this here for now; ugly ugly
@@ -67,9 +88,12 @@ struct DescriptorSets;
 AllocateDescriptorSets(gsl::span<VkDescriptorSetLayoutBinding> bindings,
                        std::uint32_t numSets, std::string name = {}) noexcept;
 
-struct MeshData;
+struct SceneDataView;
+//! \brief Create the materials and then the meshes of \p sceneData; meshes
+//! without a material get the glTF default material. \p name names the
+//! materials and textures.
 [[nodiscard]] std::system_error
-CreateMeshes(gsl::span<const MeshData> meshData) noexcept;
+CreateScene(SceneDataView const& sceneData, std::string const& name) noexcept;
 
 } // namespace iris::Renderer
 
@@ -9,12 +9,29 @@
 #include "logging.h"
 #include "nlohmann/json.hpp"
 #include "renderer/impl.h"
+#include "renderer/io/map_file.h"
 #include "renderer/io/read_file.h"
+#include "renderer/io/scene_cache.h"
 #include "renderer/mesh.h"
+#include "renderer/simd.h"
 #include "stb_image.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+#include "tbb/task_group.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace nlohmann {
@@ -507,16 +524,34 @@ struct GLTF {
   std::optional<std::vector<Scene>> scenes;
   std::optional<std::vector<Texture>> textures;
 
-  tl::expected<std::vector<iris::Renderer::MeshData>, std::system_error>
-  ParseNode(int nodeIdx, glm::mat4x4 parentMat, filesystem::path const& path,
-            std::vector<std::vector<std::byte>> const& buffersBytes);
+  //! \brief A single primitive to decode and its place in the scene.
+  struct PrimitiveJob {
+    int nodeIdx;
+    int meshIdx;
+    std::size_t primIdx;
+    glm::mat4x4 matrix;
+  };
+
+  //! \brief Flatten the node hierarchy of the default scene into the list
+  //! of primitives to decode, in depth-first order.
+  tl::expected<std::vector<PrimitiveJob>, std::system_error>
+  FlattenScene() const;
+
+  //! \brief Decode a single primitive; empty if it has no positions.
+  //! Adds the bytes it copied out of \p buffersBytes to \p bytesRead.
+  //! Safe to call concurrently for different jobs.
+  tl::expected<std::optional<iris::Renderer::MeshData>, std::system_error>
+  ParsePrimitive(PrimitiveJob const& job, filesystem::path const& path,
+                 std::vector<gsl::span<std::byte const>> const& buffersBytes,
+                 std::size_t& bytesRead) const;
 }; // struct GLTF
 
 void to_json(json& j, GLTF const& g) {
   j = json{{"asset", g.asset}};
   if (g.accessors) j["accessors"] = *g.accessors;
   if (g.buffers) j["buffers"] = *g.buffers;
-  if (g.images) j["image"] = *g.images;
+  if (g.bufferViews) j["bufferViews"] = *g.bufferViews;
+  if (g.images) j["images"] = *g.images;
   if (g.materials) j["materials"] = *g.materials;
   if (g.meshes) j["meshes"] = *g.meshes;
   if (g.nodes) j["nodes"] = *g.nodes;
@@ -561,6 +596,216 @@ void from_json(json const& j, GLTF& g) {
   }
 }
 
+/*! \brief Fills a GLTF straight from parser events.
+ *
+ * Going through a DOM keeps two copies of the whole document alive at once
+ * and a DOM node is several times the size of the field it becomes. Here
+ * only a single element of a top-level array (one node, one mesh, ...) is
+ * held as JSON at a time: it is converted with its from_json and dropped as
+ * soon as it closes. Top-level members the GLTF does not hold are skipped
+ * without being built at all.
+ */
+class StreamingParser final : public json::json_sax_t {
+public:
+  explicit StreamingParser(GLTF& g) noexcept
+    : g_(g) {}
+
+  //! \brief The error that stopped parsing; empty if parsing did not stop.
+  std::string const& error() const noexcept { return error_; }
+
+  //! \brief Check the document had the members the GLTF requires.
+  bool Finish() {
+    if (!hasAsset_) return Fail("key 'asset' not found");
+    return true;
+  }
+
+  bool null() override { return Scalar(nullptr); }
+  bool boolean(bool b) override { return Scalar(b); }
+
+  bool number_integer(json::number_integer_t i) override {
+    return Scalar(i);
+  }
+
+  bool number_unsigned(json::number_unsigned_t u) override {
+    return Scalar(u);
+  }
+
+  bool number_float(json::number_float_t f, json::string_t const&) override {
+    return Scalar(f);
+  }
+
+  bool string(json::string_t& s) override { return Scalar(std::move(s)); }
+
+  bool binary(json::binary_t&) override {
+    return Fail("binary values are not JSON");
+  }
+
+  bool start_object(std::size_t) override {
+    return Start(json::value_t::object);
+  }
+
+  bool key(json::string_t& k) override {
+    if (depth_ == 1) {
+      SelectMember(k);
+    } else if (!stack_.empty()) {
+      key_ = std::move(k);
+    }
+    return true;
+  }
+
+  bool end_object() override { return End(); }
+
+  bool start_array(std::size_t) override {
+    return Start(json::value_t::array);
+  }
+
+  bool end_array() override { return End(); }
+
+  bool parse_error(std::size_t, std::string const&,
+                   nlohmann::detail::exception const& e) override {
+    return Fail(e.what());
+  }
+
+private:
+  GLTF& g_;
+  //! The number of containers currently open in the document.
+  int depth_{0};
+  //! Receives each complete element of the current top-level member; null
+  //! if the member is skipped.
+  std::function<void(json const&)> sink_{};
+  //! True if the current top-level member is an array of elements.
+  bool isArray_{false};
+  bool hasAsset_{false};
+  //! The element being built and its currently open containers.
+  json element_{};
+  std::vector<json*> stack_{};
+  //! The key of the next value in the innermost open object.
+  std::string key_{};
+  std::string error_{};
+
+  template <class T>
+  void SelectArray(std::optional<std::vector<T>>& member) {
+    member.emplace();
+    sink_ = [&member](json const& j) { member->push_back(j.get<T>()); };
+    isArray_ = true;
+  }
+
+  void SelectMember(std::string const& name) {
+    sink_ = nullptr;
+    isArray_ = false;
+
+    if (name == "accessors") SelectArray(g_.accessors);
+    else if (name == "buffers") SelectArray(g_.buffers);
+    else if (name == "bufferViews") SelectArray(g_.bufferViews);
+    else if (name == "images") SelectArray(g_.images);
+    else if (name == "materials") SelectArray(g_.materials);
+    else if (name == "meshes") SelectArray(g_.meshes);
+    else if (name == "nodes") SelectArray(g_.nodes);
+    else if (name == "samplers") SelectArray(g_.samplers);
+    else if (name == "scenes") SelectArray(g_.scenes);
+    else if (name == "textures") SelectArray(g_.textures);
+    else if (name == "asset") {
+      sink_ = [this](json const& j) {
+        g_.asset = j.get<Asset>();
+        hasAsset_ = true;
+      };
+    } else if (name == "scene") {
+      sink_ = [this](json const& j) { g_.scene = j.get<int>(); };
+    }
+  }
+
+  bool Fail(std::string message) {
+    error_ = std::move(message);
+    return false;
+  }
+
+  //! \brief Add \p value to the innermost open container of the element.
+  json& Insert(json&& value) {
+    json& parent = *stack_.back();
+    if (parent.is_array()) {
+      parent.push_back(std::move(value));
+      return parent.back();
+    }
+    return parent[key_] = std::move(value);
+  }
+
+  bool Scalar(json&& value) {
+    if (depth_ == 0) return Fail("document is not an object");
+    if (!sink_) return true;
+
+    if (!stack_.empty()) {
+      Insert(std::move(value));
+    } else if (isArray_ && depth_ == 1) {
+      return Fail("top-level member is not an array");
+    } else {
+      sink_(value);
+    }
+    return true;
+  }
+
+  bool Start(json::value_t type) {
+    if (depth_++ == 0) {
+      if (type != json::value_t::object) {
+        return Fail("document is not an object");
+      }
+      return true;
+    }
+    if (!sink_) return true;
+
+    if (!stack_.empty()) {
+      stack_.push_back(&Insert(json(type)));
+    } else if (isArray_ && depth_ == 2) {
+      if (type != json::value_t::array) {
+        return Fail("top-level member is not an array");
+      }
+    } else {
+      element_ = json(type);
+      stack_.push_back(&element_);
+    }
+    return true;
+  }
+
+  bool End() {
+    --depth_;
+    if (stack_.empty()) return true;
+
+    stack_.pop_back();
+    if (stack_.empty()) {
+      sink_(element_);
+      element_ = nullptr;
+    }
+    return true;
+  }
+}; // class StreamingParser
+
+/*! \brief Parse the glTF JSON in \p bytes, streaming it into the GLTF or, if
+ * \p dom is true, through a DOM of the whole document.
+ */
+tl::expected<GLTF, std::system_error>
+ParseJSON(gsl::span<std::byte const> bytes, bool dom) {
+  auto const chars = reinterpret_cast<char const*>(bytes.data());
+  GLTF g;
+
+  try {
+    if (dom) {
+      g = json::parse(chars, chars + bytes.size()).get<GLTF>();
+    } else {
+      StreamingParser parser(g);
+      if (!json::sax_parse(chars, chars + bytes.size(), &parser) ||
+          !parser.Finish()) {
+        return tl::unexpected(std::system_error(
+          Error::kFileParseFailed,
+          fmt::format("Parsing failed: {}", parser.error())));
+      }
+    }
+  } catch (std::exception const& e) {
+    return tl::unexpected(std::system_error(
+      Error::kFileParseFailed, fmt::format("Parsing failed: {}", e.what())));
+  }
+
+  return g;
+} // ParseJSON
+
 inline int AccessorTypeCount(std::string const& type) {
   if (type == "SCALAR") return 1;
   if (type == "VEC2") return 2;
@@ -574,86 +819,245 @@ inline int AccessorTypeCount(std::string const& type) {
 
 inline std::size_t AccessorComponentTypeSize(int type) {
   switch (type) {
-  case 5120: return sizeof(unsigned char);
-  case 5121: return sizeof(char);
-  case 5122: return sizeof(unsigned short);
-  case 5123: return sizeof(short);
-  case 5125: return sizeof(unsigned int);
+  case 5120: return sizeof(std::int8_t);
+  case 5121: return sizeof(std::uint8_t);
+  case 5122: return sizeof(std::int16_t);
+  case 5123: return sizeof(std::uint16_t);
+  case 5125: return sizeof(std::uint32_t);
   case 5126: return sizeof(float);
   default: return 0;
   }
 }
 
-template <class T, class U>
-T GetAccessorDataComponent(gsl::not_null<U*>) {
-  iris::GetLogger()->critical("Not implemented");
-  std::terminate();
+//! \brief Convert a normalized integer component to float as per the glTF
+//! 2.0 spec: signed types map to [-1, 1] and unsigned types to [0, 1].
+template <class U>
+inline float NormalizeComponent(U c) noexcept {
+  if constexpr (std::is_floating_point_v<U>) {
+    return static_cast<float>(c);
+  } else if constexpr (std::is_signed_v<U>) {
+    return std::max(static_cast<float>(c) / std::numeric_limits<U>::max(),
+                    -1.f);
+  } else {
+    return static_cast<float>(c) / std::numeric_limits<U>::max();
+  }
 }
 
-template <>
-inline unsigned char
-GetAccessorDataComponent(gsl::not_null<unsigned char*> bytes) {
-  return *bytes;
-}
+//! \brief Decode a single element of type \p T stored as components of type
+//! \p U. The bytes need not be aligned.
+template <class T, class U, bool Normalized>
+T DecodeAccessorElement(std::byte const* bytes) noexcept {
+  if constexpr (std::is_arithmetic_v<T>) {
+    U c;
+    std::memcpy(&c, bytes, sizeof(U));
+    return static_cast<T>(c);
+  } else {
+    std::array<U, T::length()> c;
+    std::memcpy(c.data(), bytes, sizeof(c));
 
-template <>
-inline unsigned short
-GetAccessorDataComponent(gsl::not_null<unsigned char*> bytes) {
-  return static_cast<unsigned short>(*bytes);
+    T t;
+    for (typename T::length_type i = 0; i < T::length(); ++i) {
+      if constexpr (Normalized) {
+        t[i] = NormalizeComponent(c[i]);
+      } else {
+        t[i] = static_cast<typename T::value_type>(c[i]);
+      }
+    }
+    return t;
+  }
 }
 
-template <>
-inline unsigned int
-GetAccessorDataComponent(gsl::not_null<unsigned char*> bytes) {
-  return static_cast<unsigned int>(*bytes);
+template <class T, class U>
+inline T (*SelectAccessorDecoder(bool normalized))(std::byte const*) {
+  if (normalized) return DecodeAccessorElement<T, U, true>;
+  return DecodeAccessorElement<T, U, false>;
 }
 
-template <>
-inline unsigned short
-GetAccessorDataComponent(gsl::not_null<unsigned short*> bytes) {
-  return *bytes;
-}
+//! \brief Copy \p count float vectors of \p N components between strided
+//! arrays.
+template <int N>
+void CopyStridedFloats(std::byte const* src, std::size_t srcStride,
+                       std::byte* dst, std::size_t dstStride,
+                       std::size_t count) noexcept {
+  std::size_t i = 0;
+
+#if IRIS_RENDERER_HAS_SSE2
+  if constexpr (N == 4) {
+    for (; i < count; ++i, src += srcStride, dst += dstStride) {
+      _mm_storeu_ps(reinterpret_cast<float*>(dst),
+                    _mm_loadu_ps(reinterpret_cast<float const*>(src)));
+    }
+  } else if constexpr (N == 3) {
+    // A 16-byte load of any element but the last stays within the next
+    // element, but only 12 bytes may be stored.
+    for (; i + 1 < count; ++i, src += srcStride, dst += dstStride) {
+      __m128 const v = _mm_loadu_ps(reinterpret_cast<float const*>(src));
+      _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+      _mm_store_ss(reinterpret_cast<float*>(dst) + 2,
+                   _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)));
+    }
+  }
+#endif
 
-template <>
-inline unsigned int
-GetAccessorDataComponent(gsl::not_null<unsigned short*> bytes) {
-  return static_cast<unsigned int>(*bytes);
+  for (; i < count; ++i, src += srcStride, dst += dstStride) {
+    std::memcpy(dst, src, N * sizeof(float));
+  }
 }
 
-template <>
-inline unsigned int
-GetAccessorDataComponent(gsl::not_null<unsigned int*> bytes) {
-  return *bytes;
-}
+//! \brief Widen \p count unsigned short indices to unsigned int.
+inline void WidenIndices(std::byte const* src, std::size_t srcStride,
+                         std::byte* dst, std::size_t dstStride,
+                         std::size_t count) noexcept {
+  std::size_t i = 0;
+
+#if IRIS_RENDERER_HAS_SSE2
+  if (srcStride == sizeof(unsigned short) &&
+      dstStride == sizeof(unsigned int)) {
+    __m128i const zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8, src += 16, dst += 32) {
+      __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                       _mm_unpacklo_epi16(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                       _mm_unpackhi_epi16(v, zero));
+    }
+  }
+#endif
 
-template <>
-inline glm::vec2 GetAccessorDataComponent(gsl::not_null<float*> bytes) {
-  return {*bytes, *(bytes.get() + 1)};
+  for (; i < count; ++i, src += srcStride, dst += dstStride) {
+    unsigned short c;
+    std::memcpy(&c, src, sizeof(c));
+    unsigned int const index = c;
+    std::memcpy(dst, &index, sizeof(index));
+  }
 }
 
-template <>
-inline glm::vec3 GetAccessorDataComponent(gsl::not_null<float*> bytes) {
-  return {*bytes, *(bytes.get() + 1), *(bytes.get() + 2)};
-}
+/*! \brief A typed, strided, non-owning view of the elements of an Accessor.
+ *
+ * The view references the loaded buffer bytes directly and decodes each
+ * element to \p T when it is accessed, so reading an accessor never copies
+ * the underlying buffer. An accessor without a bufferView is a view of
+ * \ref count zero-initialized elements.
+ */
+template <class T>
+struct AccessorView {
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    Iterator(AccessorView const& view, std::size_t index) noexcept
+      : view_(&view)
+      , index_(index) {}
+
+    T operator*() const { return (*view_)[index_]; }
+
+    Iterator& operator++() noexcept {
+      ++index_;
+      return *this;
+    }
 
-template <>
-inline glm::vec4 GetAccessorDataComponent(gsl::not_null<float*> bytes) {
-  return {*bytes, *(bytes.get() + 1), *(bytes.get() + 2), *(bytes.get() + 3)};
-}
+    Iterator operator++(int) noexcept {
+      Iterator tmp(*this);
+      ++index_;
+      return tmp;
+    }
+
+    bool operator==(Iterator const& other) const noexcept {
+      return view_ == other.view_ && index_ == other.index_;
+    }
+
+    bool operator!=(Iterator const& other) const noexcept {
+      return !(*this == other);
+    }
+
+  private:
+    AccessorView const* view_;
+    std::size_t index_;
+  }; // class Iterator
+
+  //! The referenced bytes; null if the accessor has no bufferView.
+  std::byte const* bytes{nullptr};
+  //! The distance in bytes between the start of consecutive elements.
+  std::size_t byteStride{0};
+  //! The size in bytes of a single element in the buffer.
+  std::size_t elementSize{0};
+  //! The number of elements.
+  std::size_t count{0};
+  //! The glTF componentType of the stored elements.
+  int componentType{0};
+  //! The decoder selected from componentType and normalized.
+  T (*decode)(std::byte const*){nullptr};
+
+  std::size_t size() const noexcept { return count; }
+
+  //! \brief The number of bytes referenced in the underlying buffer.
+  std::size_t sizeBytes() const noexcept {
+    return bytes ? count * elementSize : 0;
+  }
+
+  T operator[](std::size_t i) const {
+    return bytes ? decode(bytes + i * byteStride) : T{};
+  }
+
+  Iterator begin() const noexcept { return Iterator(*this, 0); }
+  Iterator end() const noexcept { return Iterator(*this, count); }
+
+  /*! \brief Decode every element into \p dst.
+   *
+   * \p dstStride is the distance in bytes between consecutive destination
+   * elements, so an attribute can be written directly into an array of
+   * interleaved vertices. Unconverted float vectors and unsigned short
+   * indices take vectorized paths.
+   */
+  void CopyTo(T* dst, std::size_t dstStride = sizeof(T)) const noexcept {
+    auto out = reinterpret_cast<std::byte*>(dst);
+
+    if (!bytes) {
+      for (std::size_t i = 0; i < count; ++i, out += dstStride) {
+        *reinterpret_cast<T*>(out) = T{};
+      }
+      return;
+    }
+
+    if constexpr (std::is_arithmetic_v<T>) {
+      if (componentType == 5123) {
+        WidenIndices(bytes, byteStride, out, dstStride, count);
+        return;
+      }
+    } else if constexpr (std::is_same_v<typename T::value_type, float>) {
+      if (componentType == 5126) {
+        CopyStridedFloats<T::length()>(bytes, byteStride, out, dstStride,
+                                       count);
+        return;
+      }
+    }
+
+    std::byte const* in = bytes;
+    for (std::size_t i = 0; i < count;
+         ++i, in += byteStride, out += dstStride) {
+      *reinterpret_cast<T*>(out) = decode(in);
+    }
+  }
+}; // struct AccessorView
 
 template <class T>
-tl::expected<std::vector<T>, std::system_error>
-GetAccessorData(int index, std::string const& accessorType,
+tl::expected<AccessorView<T>, std::system_error>
+GetAccessorView(int index, std::string const& accessorType,
                 gsl::span<int> requiredComponentTypes, bool canBeZero,
-                std::optional<std::vector<Accessor>> accessors,
-                std::optional<std::vector<BufferView>> bufferViews,
-                std::vector<std::vector<std::byte>> buffersBytes) {
-  std::vector<T> data;
+                std::optional<std::vector<Accessor>> const& accessors,
+                std::optional<std::vector<BufferView>> const& bufferViews,
+                std::vector<gsl::span<std::byte const>> const& buffersBytes) {
+  AccessorView<T> view;
 
   if (!accessors || accessors->empty()) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "no accessors"));
-  } else if (accessors->size() < static_cast<std::size_t>(index)) {
+  } else if (index < 0 ||
+             accessors->size() <= static_cast<std::size_t>(index)) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "too few accessors"));
   }
@@ -679,6 +1083,37 @@ GetAccessorData(int index, std::string const& accessorType,
     }
   }
 
+  bool const normalized = accessor.normalized.value_or(false);
+  switch (accessor.componentType) {
+  case 5120:
+    view.decode = SelectAccessorDecoder<T, std::int8_t>(normalized);
+    break;
+  case 5121:
+    view.decode = SelectAccessorDecoder<T, std::uint8_t>(normalized);
+    break;
+  case 5122:
+    view.decode = SelectAccessorDecoder<T, std::int16_t>(normalized);
+    break;
+  case 5123:
+    view.decode = SelectAccessorDecoder<T, std::uint16_t>(normalized);
+    break;
+  case 5125:
+    view.decode = SelectAccessorDecoder<T, std::uint32_t>(normalized);
+    break;
+  case 5126:
+    view.decode = SelectAccessorDecoder<T, float>(normalized);
+    break;
+  default:
+    return tl::unexpected(
+      std::system_error(iris::Error::kFileParseFailed,
+                        "Invalid combination of type and componentType"));
+  }
+
+  view.componentType = accessor.componentType;
+  view.count = static_cast<std::size_t>(accessor.count);
+  view.elementSize = AccessorTypeCount(accessorType) *
+                     AccessorComponentTypeSize(accessor.componentType);
+
   // The index of the bufferView. When not defined, accessor must be
   // initialized with zeros; sparse property or extensions could override
   // zeros with actual values.
@@ -687,17 +1122,15 @@ GetAccessorData(int index, std::string const& accessorType,
       return tl::unexpected(std::system_error(iris::Error::kFileParseFailed,
                                               "accessor has no bufferView"));
     }
-
-    data.resize(accessor.count);
-    std::fill_n(std::begin(data), accessor.count, T{});
-    return data;
+    return view;
   }
 
   if (!bufferViews || bufferViews->empty()) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "no bufferViews"));
-  } else if (bufferViews->size() <
-             static_cast<std::size_t>(*accessor.bufferView)) {
+  } else if (*accessor.bufferView < 0 ||
+             bufferViews->size() <=
+               static_cast<std::size_t>(*accessor.bufferView)) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "too few bufferViews"));
   }
@@ -705,88 +1138,45 @@ GetAccessorData(int index, std::string const& accessorType,
   auto&& bufferView = (*bufferViews)[*accessor.bufferView];
   iris::GetLogger()->trace("bufferView: {}", json(bufferView).dump());
 
-  if (buffersBytes.size() < static_cast<std::size_t>(bufferView.buffer)) {
+  if (bufferView.buffer < 0 ||
+      buffersBytes.size() <= static_cast<std::size_t>(bufferView.buffer)) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "too few buffers"));
   }
 
-  int const componentCount = AccessorTypeCount(accessorType);
-  std::size_t const componentTypeSize =
-    AccessorComponentTypeSize(accessor.componentType);
-  int const byteOffset =
+  view.byteStride = bufferView.byteStride
+                      ? static_cast<std::size_t>(*bufferView.byteStride)
+                      : view.elementSize;
+  if (view.byteStride < view.elementSize) {
+    return tl::unexpected(std::system_error(
+      iris::Error::kFileParseFailed, "bufferView byteStride too small"));
+  }
+
+  std::size_t const byteOffset =
     bufferView.byteOffset.value_or(0) + accessor.byteOffset.value_or(0);
+  std::size_t const byteLength =
+    view.count > 0 ? (view.count - 1) * view.byteStride + view.elementSize : 0;
 
   auto&& bufferBytes = buffersBytes[bufferView.buffer];
-  if (bufferBytes.size() < byteOffset + componentTypeSize * accessor.count) {
+  if (static_cast<std::size_t>(bufferBytes.size()) < byteOffset + byteLength) {
     return tl::unexpected(
       std::system_error(iris::Error::kFileParseFailed, "buffer too small"));
   }
 
-  std::byte* bytes = bufferBytes.data() + byteOffset;
-  data.resize(accessor.count);
-
-  switch (accessor.componentType) {
-  case 5120: {
-    auto p = reinterpret_cast<char*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  case 5121: {
-    auto p = reinterpret_cast<unsigned char*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  case 5122: {
-    auto p = reinterpret_cast<short*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  case 5123: {
-    auto p = reinterpret_cast<unsigned short*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  case 5125: {
-    auto p = reinterpret_cast<unsigned int*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  case 5126: {
-    auto p = reinterpret_cast<float*>(bytes);
-    for (int i = 0; i < accessor.count; ++i, p += componentCount) {
-      data[i] = GetAccessorDataComponent<T>(gsl::not_null(p));
-    }
-  } break;
-
-  default:
-    return tl::unexpected(
-      std::system_error(iris::Error::kFileParseFailed,
-                        "Invalid combination of type and componentType"));
-  }
-
-  return data;
-} // GetAccessorData
+  view.bytes = bufferBytes.data() + byteOffset;
+  return view;
+} // GetAccessorView
 
 template <class T>
-tl::expected<std::vector<T>, std::system_error>
-GetAccessorData(int index, std::string const& accessorType,
+tl::expected<AccessorView<T>, std::system_error>
+GetAccessorView(int index, std::string const& accessorType,
                 int requiredComponentTypes, bool canBeZero,
-                std::optional<std::vector<Accessor>> accessors,
-                std::optional<std::vector<BufferView>> bufferViews,
-                std::vector<std::vector<std::byte>> buffersBytes) {
-  return GetAccessorData<T>(index, accessorType, {&requiredComponentTypes, 1},
+                std::optional<std::vector<Accessor>> const& accessors,
+                std::optional<std::vector<BufferView>> const& bufferViews,
+                std::vector<gsl::span<std::byte const>> const& buffersBytes) {
+  return GetAccessorView<T>(index, accessorType, {&requiredComponentTypes, 1},
                             canBeZero, accessors, bufferViews, buffersBytes);
-} // GetAccessorData
+} // GetAccessorView
 
 inline tl::expected<VkPrimitiveTopology, std::system_error>
 ModeToVkPrimitiveTopology(std::optional<int> mode) {
@@ -805,313 +1195,605 @@ ModeToVkPrimitiveTopology(std::optional<int> mode) {
     std::system_error(iris::Error::kFileParseFailed, "unknown primitive mode"));
 } // glTFModeToVkPrimitiveTopology
 
-tl::expected<std::vector<iris::Renderer::MeshData>, std::system_error>
-GLTF::ParseNode(int nodeIdx, glm::mat4x4 parentMat,
-                filesystem::path const& path,
-                std::vector<std::vector<std::byte>> const& buffersBytes) {
+tl::expected<std::vector<GLTF::PrimitiveJob>, std::system_error>
+GLTF::FlattenScene() const {
   IRIS_LOG_ENTER();
-  std::vector<iris::Renderer::MeshData> primitiveData;
+  std::vector<PrimitiveJob> jobs;
 
-  if (!nodes || nodes->size() < static_cast<std::size_t>(nodeIdx)) {
-    return tl::unexpected(
-      std::system_error(iris::Error::kFileParseFailed, "not enough nodes"));
+  if (!nodes || nodes->empty()) {
+    IRIS_LOG_LEAVE();
+    return jobs;
   }
 
-  auto&& node = (*nodes)[nodeIdx];
-  // Node:
-  // std::optional<std::vector<int>> children; // indices into gltf.nodes
-  // std::optional<glm::mat4x4> matrix;
-  // std::optional<int> mesh; // index into gltf.meshes
-  // std::optional<glm::quat> rotation;
-  // std::optional<glm::vec3> scale;
-  // std::optional<glm::vec3> translation;
-  // std::optional<std::string> name;
-
-  iris::GetLogger()->trace("nodeIdx: {} node: {}", nodeIdx, json(node).dump());
-  std::string const nodeName =
-    path.string() + ":" + (node.name ? *node.name : fmt::format("{}", nodeIdx));
-
-  glm::mat4x4 nodeMat = parentMat;
-
-  if (node.matrix) {
-    nodeMat *= *node.matrix;
-    if (node.translation || node.rotation || node.scale) {
-      iris::GetLogger()->warn("node has both matrix and TRS; using matrix");
+  // The root nodes are those of the default scene. Without scenes, fall back
+  // to every node that is not the child of another node.
+  std::vector<int> roots;
+  if (scenes && !scenes->empty()) {
+    int const sceneIdx = scene.value_or(0);
+    if (sceneIdx < 0 || scenes->size() <= static_cast<std::size_t>(sceneIdx)) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(
+        std::system_error(iris::Error::kFileParseFailed, "not enough scenes"));
     }
+    roots = (*scenes)[sceneIdx].nodes.value_or(std::vector<int>{});
   } else {
-    if (node.translation) nodeMat *= glm::translate({}, *node.translation);
-    if (node.rotation) nodeMat *= glm::mat4_cast(*node.rotation);
-    if (node.scale) nodeMat *= glm::scale({}, *node.scale);
+    iris::GetLogger()->warn("no scenes specified; using all root nodes");
+    std::vector<bool> isChild(nodes->size(), false);
+    for (auto&& node : *nodes) {
+      for (auto&& child : node.children.value_or(std::vector<int>{})) {
+        if (child >= 0 && static_cast<std::size_t>(child) < isChild.size()) {
+          isChild[child] = true;
+        }
+      }
+    }
+    for (std::size_t i = 0; i < isChild.size(); ++i) {
+      if (!isChild[i]) roots.push_back(static_cast<int>(i));
+    }
+  }
+
+  // Depth-first traversal with an explicit stack. Jobs are emitted in the
+  // same order as a recursive walk (children before the node's own mesh) so
+  // the decoded primitives keep a stable order.
+  struct Entry {
+    int nodeIdx;
+    glm::mat4x4 matrix;
+    bool childrenVisited;
+  };
+
+  std::vector<Entry> stack;
+  for (auto root = roots.rbegin(); root != roots.rend(); ++root) {
+    stack.push_back({*root, glm::mat4x4(1.f), false});
   }
 
-  auto&& children =
-    node.children.value_or(decltype(gltf::Node::children)::value_type({}));
+  std::size_t numVisited = 0;
+  while (!stack.empty()) {
+    Entry entry = stack.back();
+    stack.pop_back();
 
-  for (auto&& child : children) {
-    if (auto d = ParseNode(child, nodeMat, path, buffersBytes)) {
-      primitiveData.insert(primitiveData.end(), d->begin(), d->end());
-    } else {
+    if (entry.nodeIdx < 0 ||
+        nodes->size() <= static_cast<std::size_t>(entry.nodeIdx)) {
       IRIS_LOG_LEAVE();
-      return tl::unexpected(d.error());
+      return tl::unexpected(
+        std::system_error(iris::Error::kFileParseFailed, "not enough nodes"));
     }
-  }
 
-  if (!node.mesh) {
-    IRIS_LOG_ENTER();
-    return primitiveData;
-  }
+    auto&& node = (*nodes)[entry.nodeIdx];
 
-  if (!meshes || meshes->empty()) {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(std::system_error(
-      iris::Error::kFileParseFailed, "node defines mesh, but no meshes"));
-  }
+    if (entry.childrenVisited) {
+      if (!node.mesh) continue;
 
-  if (meshes->size() < static_cast<std::size_t>(*node.mesh)) {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(
-      std::system_error(iris::Error::kFileParseFailed,
-                        "node defines mesh, but not enough meshes"));
-  }
+      if (!meshes || meshes->empty()) {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(std::system_error(
+          iris::Error::kFileParseFailed, "node defines mesh, but no meshes"));
+      }
 
-  auto&& mesh = (*meshes)[*node.mesh];
-  // Mesh:
-  // std::vector<Primitive> primitives;
+      if (*node.mesh < 0 ||
+          meshes->size() <= static_cast<std::size_t>(*node.mesh)) {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(
+          std::system_error(iris::Error::kFileParseFailed,
+                            "node defines mesh, but not enough meshes"));
+      }
 
-  iris::GetLogger()->trace("mesh: {}", json(mesh).dump());
+      auto&& mesh = (*meshes)[*node.mesh];
+      for (std::size_t i = 0; i < mesh.primitives.size(); ++i) {
+        jobs.push_back({entry.nodeIdx, *node.mesh, i, entry.matrix});
+      }
+      continue;
+    }
 
-  for (std::size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
-    auto&& primitive = mesh.primitives[primIdx];
-    // Primitive:
-    // std::map<std::string, int> attributes; // index into gltf.accessors
-    // std::optional<int> indices;            // index into gltf.accessors
-    // std::optional<int> material;           // index into gltf.materials
-    // std::optional<int> mode;
-    // std::optional<std::vector<int>> targets;
-    //
-    // From the glTF 2.0 spec:
-    //
-    // Implementation note: Each primitive corresponds to one WebGL draw
-    // call (engines are, of course, free to batch draw calls). When a
-    // primitive's indices property is defined, it references the accessor
-    // to use for index data, and GL's drawElements function should be used.
-    // When the indices property is not defined, GL's drawArrays function
-    // should be used with a count equal to the count property of any of the
-    // accessors referenced by the attributes property (they are all equal
-    // for a given primitive).
-    //
-    // Implementation note: When positions are not specified, client
-    // implementations should skip primitive's rendering unless its
-    // positions are provided by other means (e.g., by extension). This
-    // applies to both indexed and non-indexed geometry.
-    //
-    // Implementation note: When normals are not specified, client
-    // implementations should calculate flat normals.
-    //
-    // Implementation note: When tangents are not specified, client
-    // implementations should calculate tangents using default MikkTSpace
-    // algorithms. For best results, the mesh triangles should also be
-    // processed using default MikkTSpace algorithms.
-    //
-    // Implementation note: Vertices of the same triangle should have the
-    // same tangent.w value. When vertices of the same triangle have
-    // different tangent.w values, tangent space is considered undefined.
-    //
-    // Implementation note: When normals and tangents are specified, client
-    // implementations should compute the bitangent by taking the cross
-    // product of the normal and tangent xyz vectors and multiplying against
-    // the w component of the tangent: bitangent = cross(normal,
-    // tangent.xyz) * tangent.w
-
-    iris::Renderer::MeshData meshData;
-    meshData.name =
-      nodeName + ":" + (mesh.name ? *mesh.name : fmt::format("{}", primIdx));
-    meshData.matrix = nodeMat;
-
-    if (auto t = gltf::ModeToVkPrimitiveTopology(primitive.mode)) {
-      meshData.topology = *t;
-    } else {
+    // The node hierarchy must be a set of disjoint strict trees, so a node
+    // can be visited at most once unless the file is malformed.
+    if (++numVisited > nodes->size()) {
       IRIS_LOG_LEAVE();
-      return tl::unexpected(t.error());
+      return tl::unexpected(std::system_error(iris::Error::kFileParseFailed,
+                                              "node hierarchy has a cycle"));
     }
 
-    // First get the indices if present. We're only getting the indices here
-    // to use them for possible normal/tangent generation. That way the
-    // original format of the indices can be used in the draw call.
-    if (primitive.indices) {
-      std::array<int, 3> componentTypes{5123, 5125};
-      if (auto i = gltf::GetAccessorData<unsigned int>(
-            *primitive.indices, "SCALAR", componentTypes, false, accessors,
-            bufferViews, buffersBytes)) {
-        meshData.indices = std::move(*i);
-      } else {
-        IRIS_LOG_LEAVE();
-        return tl::unexpected(i.error());
-      }
-    }
+    iris::GetLogger()->trace("nodeIdx: {} node: {}", entry.nodeIdx,
+                             json(node).dump());
 
-    //
-    // Next get the positions
-    //
-    std::vector<glm::vec3> positions;
-    for (auto&& [semantic, index] : primitive.attributes) {
-      if (semantic == "POSITION") {
-        if (auto p = gltf::GetAccessorData<glm::vec3>(index, "VEC3", 5126, true,
-                                                      accessors, bufferViews,
-                                                      buffersBytes)) {
-          positions = std::move(*p);
-        } else {
-          IRIS_LOG_LEAVE();
-          return tl::unexpected(p.error());
-        }
+    glm::mat4x4 nodeMat = entry.matrix;
+
+    if (node.matrix) {
+      nodeMat *= *node.matrix;
+      if (node.translation || node.rotation || node.scale) {
+        iris::GetLogger()->warn("node has both matrix and TRS; using matrix");
       }
+    } else {
+      glm::mat4x4 const identity(1.f);
+      if (node.translation) {
+        nodeMat *= glm::translate(identity, *node.translation);
+      }
+      if (node.rotation) nodeMat *= glm::mat4_cast(*node.rotation);
+      if (node.scale) nodeMat *= glm::scale(identity, *node.scale);
     }
 
-    // primitives with no positions are "ignored"
-    if (positions.empty()) continue;
-
-    //
-    // Now get texcoords, normals, and tangents
-    //
-    std::vector<glm::vec2> texcoords;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::vec4> tangents;
-
-    for (auto&& [semantic, index] : primitive.attributes) {
-      if (semantic == "TEXCOORD_0") {
-        if (auto t = gltf::GetAccessorData<glm::vec2>(index, "VEC2", 5126, true,
-                                                      accessors, bufferViews,
-                                                      buffersBytes)) {
-          texcoords = std::move(*t);
-        } else {
-          IRIS_LOG_LEAVE();
-          return tl::unexpected(t.error());
-        }
-      } else if (semantic == "NORMAL") {
-        if (auto n = gltf::GetAccessorData<glm::vec3>(index, "VEC3", 5126, true,
-                                                      accessors, bufferViews,
-                                                      buffersBytes)) {
-          normals = std::move(*n);
-        } else {
-          IRIS_LOG_LEAVE();
-          return tl::unexpected(n.error());
-        }
-      } else if (semantic == "TANGENT") {
-        if (auto t = gltf::GetAccessorData<glm::vec4>(index, "VEC4", 5126, true,
-                                                      accessors, bufferViews,
-                                                      buffersBytes)) {
-          tangents = std::move(*t);
-        } else {
-          IRIS_LOG_LEAVE();
-          return tl::unexpected(t.error());
-        }
-      }
+    stack.push_back({entry.nodeIdx, nodeMat, true});
+
+    auto&& children = node.children.value_or(std::vector<int>{});
+    for (auto child = children.rbegin(); child != children.rend(); ++child) {
+      stack.push_back({*child, nodeMat, false});
     }
+  }
 
-    std::size_t const num = positions.size();
-    meshData.vertices.resize(num);
+  IRIS_LOG_LEAVE();
+  return jobs;
+} // GLTF::FlattenScene
+
+tl::expected<std::optional<iris::Renderer::MeshData>, std::system_error>
+GLTF::ParsePrimitive(
+  PrimitiveJob const& job, filesystem::path const& path,
+  std::vector<gsl::span<std::byte const>> const& buffersBytes,
+  std::size_t& bytesRead) const {
+  IRIS_LOG_ENTER();
 
-    for (std::size_t i = 0; i < num; ++i) {
-      meshData.vertices[i].position = positions[i];
+  auto&& node = (*nodes)[job.nodeIdx];
+  auto&& mesh = (*meshes)[job.meshIdx];
+  // Mesh:
+  // std::vector<Primitive> primitives;
+
+  iris::GetLogger()->trace("mesh: {}", json(mesh).dump());
+
+  auto&& primitive = mesh.primitives[job.primIdx];
+  // Primitive:
+  // std::map<std::string, int> attributes; // index into gltf.accessors
+  // std::optional<int> indices;            // index into gltf.accessors
+  // std::optional<int> material;           // index into gltf.materials
+  // std::optional<int> mode;
+  // std::optional<std::vector<int>> targets;
+  //
+  // From the glTF 2.0 spec:
+  //
+  // Implementation note: Each primitive corresponds to one WebGL draw
+  // call (engines are, of course, free to batch draw calls). When a
+  // primitive's indices property is defined, it references the accessor
+  // to use for index data, and GL's drawElements function should be used.
+  // When the indices property is not defined, GL's drawArrays function
+  // should be used with a count equal to the count property of any of the
+  // accessors referenced by the attributes property (they are all equal
+  // for a given primitive).
+  //
+  // Implementation note: When positions are not specified, client
+  // implementations should skip primitive's rendering unless its
+  // positions are provided by other means (e.g., by extension). This
+  // applies to both indexed and non-indexed geometry.
+  //
+  // Implementation note: When normals are not specified, client
+  // implementations should calculate flat normals.
+  //
+  // Implementation note: When tangents are not specified, client
+  // implementations should calculate tangents using default MikkTSpace
+  // algorithms. For best results, the mesh triangles should also be
+  // processed using default MikkTSpace algorithms.
+  //
+  // Implementation note: Vertices of the same triangle should have the
+  // same tangent.w value. When vertices of the same triangle have
+  // different tangent.w values, tangent space is considered undefined.
+  //
+  // Implementation note: When normals and tangents are specified, client
+  // implementations should compute the bitangent by taking the cross
+  // product of the normal and tangent xyz vectors and multiplying against
+  // the w component of the tangent: bitangent = cross(normal,
+  // tangent.xyz) * tangent.w
+
+  iris::Renderer::MeshData meshData;
+  meshData.name =
+    path.string() + ":" +
+    (node.name ? *node.name : fmt::format("{}", job.nodeIdx)) + ":" +
+    (mesh.name ? *mesh.name : fmt::format("{}", job.primIdx));
+  meshData.matrix = job.matrix;
+
+  if (primitive.material) {
+    if (!materials || *primitive.material < 0 ||
+        materials->size() <= static_cast<std::size_t>(*primitive.material)) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(std::system_error(
+        iris::Error::kFileParseFailed,
+        "primitive references invalid material"));
     }
+    meshData.material = *primitive.material;
+  }
 
-    if (!texcoords.empty()) {
-      for (std::size_t i = 0; i < num; ++i) {
-        meshData.vertices[i].texcoord = texcoords[i];
-      }
+  if (auto t = gltf::ModeToVkPrimitiveTopology(primitive.mode)) {
+    meshData.topology = *t;
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(t.error());
+  }
+
+  // First get the indices if present. We're only getting the indices here
+  // to use them for possible normal/tangent generation. That way the
+  // original format of the indices can be used in the draw call.
+  if (primitive.indices) {
+    std::array<int, 3> componentTypes{5121, 5123, 5125};
+    if (auto i = gltf::GetAccessorView<unsigned int>(
+          *primitive.indices, "SCALAR", componentTypes, false, accessors,
+          bufferViews, buffersBytes)) {
+      meshData.indices.resize(i->size());
+      i->CopyTo(meshData.indices.data());
+      bytesRead += i->sizeBytes();
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(i.error());
     }
+  }
 
-    if (!normals.empty()) {
-      for (std::size_t i = 0; i < num; ++i) {
-        meshData.vertices[i].normal = normals[i];
+  //
+  // Next get the positions
+  //
+  std::optional<gltf::AccessorView<glm::vec3>> positions;
+  std::optional<int> positionsIndex;
+  for (auto&& [semantic, index] : primitive.attributes) {
+    if (semantic == "POSITION") {
+      if (auto p = gltf::GetAccessorView<glm::vec3>(index, "VEC3", 5126, true,
+                                                    accessors, bufferViews,
+                                                    buffersBytes)) {
+        positions = std::move(*p);
+        positionsIndex = index;
+      } else {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(p.error());
       }
-    } else {
-      meshData.GenerateNormals();
     }
+  }
+
+  // primitives with no positions are "ignored"
+  if (!positions || positions->size() == 0) {
+    IRIS_LOG_LEAVE();
+    return std::nullopt;
+  }
 
-    if (!tangents.empty()) {
-      for (std::size_t i = 0; i < num; ++i) {
-        meshData.vertices[i].tangent = tangents[i];
+  //
+  // Now get texcoords, normals, and tangents
+  //
+  std::optional<gltf::AccessorView<glm::vec2>> texcoords;
+  std::optional<gltf::AccessorView<glm::vec3>> normals;
+  std::optional<gltf::AccessorView<glm::vec4>> tangents;
+
+  for (auto&& [semantic, index] : primitive.attributes) {
+    if (semantic == "TEXCOORD_0") {
+      std::array<int, 3> componentTypes{5126, 5121, 5123};
+      if (auto t = gltf::GetAccessorView<glm::vec2>(
+            index, "VEC2", componentTypes, true, accessors, bufferViews,
+            buffersBytes)) {
+        texcoords = std::move(*t);
+      } else {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(t.error());
       }
-    } else {
-      if (!meshData.GenerateTangents()) {
+    } else if (semantic == "NORMAL") {
+      if (auto n = gltf::GetAccessorView<glm::vec3>(index, "VEC3", 5126, true,
+                                                    accessors, bufferViews,
+                                                    buffersBytes)) {
+        normals = std::move(*n);
+      } else {
         IRIS_LOG_LEAVE();
-        return tl::unexpected(std::system_error(
-          iris::Error::kFileParseFailed, "Unable to generate tangent space"));
+        return tl::unexpected(n.error());
+      }
+    } else if (semantic == "TANGENT") {
+      if (auto t = gltf::GetAccessorView<glm::vec4>(index, "VEC4", 5126, true,
+                                                    accessors, bufferViews,
+                                                    buffersBytes)) {
+        tangents = std::move(*t);
+      } else {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(t.error());
       }
     }
+  }
 
-    iris::GetLogger()->debug("Primitive has {} vertices",
-                             meshData.vertices.size());
+  // All attributes of a primitive must have the same count.
+  std::size_t const num = positions->size();
+  if ((texcoords && texcoords->size() != num) ||
+      (normals && normals->size() != num) ||
+      (tangents && tangents->size() != num)) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      iris::Error::kFileParseFailed, "primitive attribute counts differ"));
+  }
 
-    meshData.bindingDescriptions.push_back(
-      {0, sizeof(iris::Renderer::MeshData::Vertex),
-       VK_VERTEX_INPUT_RATE_VERTEX});
+  meshData.vertices.resize(num);
 
-    if (texcoords.empty()) {
-      meshData.attributeDescriptions.resize(3);
-    } else {
-      meshData.attributeDescriptions.resize(4);
-    }
+  using Vertex = iris::Renderer::MeshData::Vertex;
+  positions->CopyTo(&meshData.vertices[0].position, sizeof(Vertex));
+  bytesRead += positions->sizeBytes();
 
-    meshData.attributeDescriptions[0] = {
-      0, 0, VK_FORMAT_R32G32B32_SFLOAT,
-      offsetof(iris::Renderer::MeshData::Vertex, position)};
+  if (texcoords) {
+    texcoords->CopyTo(&meshData.vertices[0].texcoord, sizeof(Vertex));
+    bytesRead += texcoords->sizeBytes();
+  }
 
-    meshData.attributeDescriptions[1] = {
-      1, 0, VK_FORMAT_R32G32B32_SFLOAT,
-      offsetof(iris::Renderer::MeshData::Vertex, normal)};
+  if (normals) {
+    normals->CopyTo(&meshData.vertices[0].normal, sizeof(Vertex));
+    bytesRead += normals->sizeBytes();
+  } else {
+    meshData.GenerateNormals();
+  }
 
-    meshData.attributeDescriptions[2] = {
-      2, 0, VK_FORMAT_R32G32B32A32_SFLOAT,
-      offsetof(iris::Renderer::MeshData::Vertex, tangent)};
+  // POSITION accessors are required to carry min and max, but fall back to
+  // a pass over the decoded positions for files that omit them.
+  auto&& positionsAccessor = (*accessors)[*positionsIndex];
+  if (positionsAccessor.min && positionsAccessor.min->size() == 3 &&
+      positionsAccessor.max && positionsAccessor.max->size() == 3) {
+    auto&& min = *positionsAccessor.min;
+    auto&& max = *positionsAccessor.max;
+    meshData.boundsMin = glm::vec3(min[0], min[1], min[2]);
+    meshData.boundsMax = glm::vec3(max[0], max[1], max[2]);
+  } else {
+    meshData.ComputeBounds();
+  }
 
-    if (!texcoords.empty()) {
-      meshData.attributeDescriptions[3] = {
-        3, 0, VK_FORMAT_R32G32_SFLOAT,
-        offsetof(iris::Renderer::MeshData::Vertex, texcoord)};
+  if (tangents) {
+    tangents->CopyTo(&meshData.vertices[0].tangent, sizeof(Vertex));
+    bytesRead += tangents->sizeBytes();
+  } else {
+    if (!meshData.GenerateTangents()) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(std::system_error(
+        iris::Error::kFileParseFailed, "Unable to generate tangent space"));
     }
-
-    primitiveData.push_back(meshData);
   }
 
+  iris::GetLogger()->debug(
+    "Primitive {} has {} vertices and {} indices; decoded {} bytes in place",
+    meshData.name, meshData.vertices.size(), meshData.indices.size(),
+    bytesRead);
+
+  meshData.hasTexCoords = texcoords.has_value();
+
   IRIS_LOG_LEAVE();
-  return primitiveData;
-} // GLTF::ParseNode
+  return meshData;
+} // GLTF::ParsePrimitive
 
 } // namespace gltf
 
 namespace iris::Renderer::io {
 
-tl::expected<std::vector<MeshData>, std::system_error>
-ReadGLTF(filesystem::path const& path) noexcept {
+//! \brief The RGBA8 pixels of a decoded glTF image.
+struct DecodedImage {
+  //! The pixels, left in the allocation stb_image decoded them into.
+  std::unique_ptr<stbi_uc, void (*)(void*)> pixels{nullptr, stbi_image_free};
+  VkExtent3D extent{0, 0, 1};
+  //! The encoded file, kept for the scene cache.
+  std::shared_ptr<std::byte const> encoded{};
+  std::size_t encodedSize{0};
+  //! The time decoding took.
+  float milliseconds{0.f};
+}; // struct DecodedImage
+
+/*! \brief Decode \p image of \p g from its file or buffer view. Safe to call
+ * concurrently for different images.
+ */
+static tl::expected<DecodedImage, std::system_error> DecodeImage(
+  gltf::GLTF const& g, gltf::Image const& image,
+  filesystem::path const& baseDir,
+  std::vector<gsl::span<std::byte const>> const& buffersBytes) noexcept {
   IRIS_LOG_ENTER();
-  using namespace std::string_literals;
+  auto const start = std::chrono::steady_clock::now();
 
-  filesystem::path const baseDir = path.parent_path();
+  int x, y, n;
+  DecodedImage decoded;
+  std::vector<std::byte> encoded;
 
-  json j;
-  if (auto&& bytes = ReadFile(path)) {
-    try {
-      j = json::parse(*bytes);
-    } catch (std::exception const& e) {
+  if (image.uri) {
+    filesystem::path uriPath(*image.uri);
+    if (uriPath.is_relative()) uriPath = baseDir / uriPath;
+    if (auto bytes = ReadFile(uriPath)) {
+      encoded = std::move(*bytes);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(bytes.error());
+    }
+  } else if (image.bufferView) {
+    if (!g.bufferViews || *image.bufferView < 0 ||
+        g.bufferViews->size() <= static_cast<std::size_t>(*image.bufferView)) {
       IRIS_LOG_LEAVE();
       return tl::unexpected(std::system_error(
-        Error::kFileParseFailed, fmt::format("Parsing failed: {}", e.what())));
+        Error::kFileParseFailed, "image references invalid bufferView"));
     }
+
+    auto&& bufferView = (*g.bufferViews)[*image.bufferView];
+    std::size_t const byteOffset = bufferView.byteOffset.value_or(0);
+
+    if (bufferView.buffer < 0 ||
+        buffersBytes.size() <= static_cast<std::size_t>(bufferView.buffer) ||
+        static_cast<std::size_t>(buffersBytes[bufferView.buffer].size()) <
+          byteOffset + bufferView.byteLength) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(std::system_error(
+        Error::kFileParseFailed, "image bufferView outside of buffer"));
+    }
+
+    // Copied so the scene cache can still write it once the buffers are
+    // released; it is the compressed file, not the pixels.
+    std::byte const* begin =
+      buffersBytes[bufferView.buffer].data() + byteOffset;
+    encoded.assign(begin, begin + bufferView.byteLength);
   } else {
     IRIS_LOG_LEAVE();
-    return tl::unexpected(bytes.error());
+    return tl::unexpected(std::system_error(
+      Error::kFileNotSupported, "image with no uri or bufferView"));
   }
 
-  gltf::GLTF g;
-  try {
-    g = j.get<gltf::GLTF>();
-  } catch (std::exception const& e) {
+  if (encoded.size() >
+      static_cast<std::size_t>(std::numeric_limits<int>::max())) {
     IRIS_LOG_LEAVE();
+    return tl::unexpected(
+      std::system_error(Error::kFileNotSupported, "image file too large"));
+  }
+
+  decoded.pixels.reset(stbi_load_from_memory(
+    reinterpret_cast<stbi_uc const*>(encoded.data()),
+    static_cast<int>(encoded.size()), &x, &y, &n, 4));
+
+  if (!decoded.pixels) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(
+      std::system_error(Error::kFileNotSupported, stbi_failure_reason()));
+  }
+
+  decoded.extent = {static_cast<std::uint32_t>(x),
+                    static_cast<std::uint32_t>(y), 1};
+  decoded.encodedSize = encoded.size();
+  auto owner = std::make_shared<std::vector<std::byte>>(std::move(encoded));
+  decoded.encoded = std::shared_ptr<std::byte const>(owner, owner->data());
+  decoded.milliseconds = std::chrono::duration<float, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+  IRIS_LOG_LEAVE();
+  return decoded;
+} // DecodeImage
+
+/*! \brief Convert the texture of \p g at \p index and its sampler, keeping
+ * the glTF defaults for what the sampler leaves out: linear magnification,
+ * trilinear minification and repeating.
+ */
+static tl::expected<TextureData, std::system_error>
+ConvertTexture(gltf::GLTF const& g, std::size_t index) noexcept {
+  auto&& texture = (*g.textures)[index];
+  std::size_t const numImages = g.images ? g.images->size() : 0;
+
+  if (!texture.source || *texture.source < 0 ||
+      numImages <= static_cast<std::size_t>(*texture.source)) {
     return tl::unexpected(std::system_error(
-      Error::kFileParseFailed, fmt::format("Parsing failed: {}", e.what())));
+      Error::kFileParseFailed,
+      fmt::format("texture {} has no valid source", index)));
+  }
+
+  TextureData data;
+  data.image = *texture.source;
+  if (!texture.sampler) return data;
+
+  if (!g.samplers || *texture.sampler < 0 ||
+      g.samplers->size() <= static_cast<std::size_t>(*texture.sampler)) {
+    return tl::unexpected(std::system_error(
+      Error::kFileParseFailed,
+      fmt::format("texture {} references invalid sampler", index)));
+  }
+
+  auto&& sampler = (*g.samplers)[*texture.sampler];
+
+  switch (sampler.magFilter.value_or(9729)) {
+  case 9728: data.magFilter = VK_FILTER_NEAREST; break;
+  case 9729: data.magFilter = VK_FILTER_LINEAR; break;
+  }
+
+  switch (sampler.minFilter.value_or(9987)) {
+  case 9728:
+    data.minFilter = VK_FILTER_NEAREST;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    data.mipmapped = VK_FALSE;
+    break;
+  case 9729:
+    data.minFilter = VK_FILTER_LINEAR;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    data.mipmapped = VK_FALSE;
+    break;
+  case 9984:
+    data.minFilter = VK_FILTER_NEAREST;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    break;
+  case 9985:
+    data.minFilter = VK_FILTER_LINEAR;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    break;
+  case 9986:
+    data.minFilter = VK_FILTER_NEAREST;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    break;
+  case 9987:
+    data.minFilter = VK_FILTER_LINEAR;
+    data.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    break;
+  }
+
+  auto const addressMode = [](int wrap) {
+    switch (wrap) {
+    case 33071: return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    case 33648: return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+    default: return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    }
+  };
+
+  data.addressModeU = addressMode(sampler.wrapS.value_or(10497));
+  data.addressModeV = addressMode(sampler.wrapT.value_or(10497));
+  return data;
+} // ConvertTexture
+
+//! \brief Convert \p material, warning about what is not supported.
+static MaterialData ConvertMaterial(gltf::Material const& material) noexcept {
+  MaterialData data;
+  bool otherTexCoord = false;
+
+  if (material.pbrMetallicRoughness) {
+    auto&& pbr = *material.pbrMetallicRoughness;
+    if (pbr.baseColorFactor) data.baseColorFactor = *pbr.baseColorFactor;
+    data.metallicFactor = static_cast<float>(pbr.metallicFactor.value_or(1.0));
+    data.roughnessFactor =
+      static_cast<float>(pbr.roughnessFactor.value_or(1.0));
+
+    if (pbr.baseColorTexture) {
+      data.texture(MaterialMap::kBaseColor) = pbr.baseColorTexture->index;
+      otherTexCoord |= pbr.baseColorTexture->texCoord.value_or(0) != 0;
+    }
+    if (pbr.metallicRoughnessTexture) {
+      data.texture(MaterialMap::kMetallicRoughness) =
+        pbr.metallicRoughnessTexture->index;
+      otherTexCoord |= pbr.metallicRoughnessTexture->texCoord.value_or(0) != 0;
+    }
+  }
+
+  if (material.normalTexture) {
+    data.texture(MaterialMap::kNormal) = material.normalTexture->index;
+    data.normalScale =
+      static_cast<float>(material.normalTexture->scale.value_or(1.0));
+    otherTexCoord |= material.normalTexture->texCoord.value_or(0) != 0;
+  }
+
+  if (material.occlusionTexture) {
+    data.texture(MaterialMap::kOcclusion) = material.occlusionTexture->index;
+    data.occlusionStrength =
+      static_cast<float>(material.occlusionTexture->strength.value_or(1.0));
+    otherTexCoord |= material.occlusionTexture->texCoord.value_or(0) != 0;
+  }
+
+  if (material.emissiveTexture) {
+    data.texture(MaterialMap::kEmissive) = material.emissiveTexture->index;
+    otherTexCoord |= material.emissiveTexture->texCoord.value_or(0) != 0;
+  }
+  if (material.emissiveFactor) data.emissiveFactor = *material.emissiveFactor;
+
+  data.doubleSided = material.doubleSided.value_or(false) ? VK_TRUE : VK_FALSE;
+
+  if (otherTexCoord) {
+    GetLogger()->warn("Material {} uses texture coordinates other than "
+                      "TEXCOORD_0; sampling them with TEXCOORD_0",
+                      material.name.value_or(""));
   }
+  if (material.alphaMode.value_or("OPAQUE") != "OPAQUE") {
+    GetLogger()->warn("Material {} has alphaMode {}; drawing it opaque",
+                      material.name.value_or(""), *material.alphaMode);
+  }
+
+  return data;
+} // ConvertMaterial
+
+/*! \brief Build the SceneData of the glTF \p g, adding every external file
+ * it reads to \p dependencies and, if \p statistics is not null, recording
+ * what decoding copied in it.
+ */
+static tl::expected<SceneData, std::system_error>
+ParseGLTF(gltf::GLTF g, filesystem::path const& path,
+          gsl::span<std::byte const> binaryChunk,
+          std::vector<filesystem::path>& dependencies,
+          GLTFDecodeStatistics* statistics) noexcept {
+  IRIS_LOG_ENTER();
+  using namespace std::string_literals;
+
+  filesystem::path const baseDir = path.parent_path();
 
   if (g.asset.version != "2.0") {
     if (g.asset.minVersion) {
@@ -1132,22 +1814,38 @@ ReadGLTF(filesystem::path const& path) noexcept {
   }
 
   //
-  // Read all the buffers into memory
+  // Read all the external buffers into memory. The binary chunk of a .glb
+  // is referenced in place as the first buffer.
   //
   auto&& buffers =
     g.buffers.value_or<decltype(gltf::GLTF::buffers)::value_type>({});
-  std::vector<std::vector<std::byte>> buffersBytes;
+  std::vector<std::vector<std::byte>> buffersStorage;
+  std::vector<gsl::span<std::byte const>> buffersBytes;
+
+  for (std::size_t i = 0; i < buffers.size(); ++i) {
+    auto&& buffer = buffers[i];
 
-  for (auto&& buffer : buffers) {
     if (buffer.uri) {
       filesystem::path uriPath(*buffer.uri);
-      if (auto b =
-            ReadFile(uriPath.is_relative() ? baseDir / uriPath : uriPath)) {
-        buffersBytes.push_back(std::move(*b));
+      if (uriPath.is_relative()) uriPath = baseDir / uriPath;
+      dependencies.push_back(uriPath);
+
+      if (auto b = ReadFile(uriPath)) {
+        buffersStorage.push_back(std::move(*b));
+        buffersBytes.emplace_back(buffersStorage.back().data(),
+                                  buffersStorage.back().size());
       } else {
         IRIS_LOG_LEAVE();
-        b.error();
+        return tl::unexpected(b.error());
       }
+    } else if (i == 0 && binaryChunk.data() != nullptr) {
+      if (static_cast<std::size_t>(binaryChunk.size()) <
+          static_cast<std::size_t>(buffer.byteLength)) {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(std::system_error(
+          Error::kFileParseFailed, "binary chunk smaller than buffer"));
+      }
+      buffersBytes.emplace_back(binaryChunk.data(), buffer.byteLength);
     } else {
       IRIS_LOG_LEAVE();
       return tl::unexpected(std::system_error(Error::kFileParseFailed,
@@ -1155,176 +1853,429 @@ ReadGLTF(filesystem::path const& path) noexcept {
     }
   }
 
+  if (!g.scene) {
+    GetLogger()->warn("no default scene specified; using first scene");
+    g.scene = 0;
+  }
+
+  //
+  // Flatten the scene graph into per-primitive jobs
+  //
+  auto const flattenStart = std::chrono::steady_clock::now();
+
+  std::vector<gltf::GLTF::PrimitiveJob> jobs;
+  if (auto f = g.FlattenScene()) {
+    jobs = std::move(*f);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(f.error());
+  }
+
+  //
+  // Nodes that place the same mesh primitive share one decode and are drawn
+  // as instances of it. Mirroring transforms flip the winding, which needs a
+  // different pipeline, so they form their own group.
+  //
+  std::vector<gltf::GLTF::PrimitiveJob> uniqueJobs;
+  std::vector<std::vector<glm::mat4x4>> instanceMatrices;
+  {
+    std::map<std::tuple<int, std::size_t, bool>, std::size_t> groups;
+    for (auto&& job : jobs) {
+      auto const key = std::make_tuple(job.meshIdx, job.primIdx,
+                                       glm::determinant(job.matrix) < 0.f);
+      auto const [group, inserted] = groups.emplace(key, uniqueJobs.size());
+      if (inserted) {
+        uniqueJobs.push_back(job);
+        instanceMatrices.emplace_back();
+      }
+      instanceMatrices[group->second].push_back(job.matrix);
+    }
+  }
+
   //
-  // Read all the images into memory
+  // Decode the primitives in parallel on the task scheduler. Each job writes
+  // only its own slot so the results keep the traversal order regardless of
+  // scheduling.
+  //
+  auto const decodeStart = std::chrono::steady_clock::now();
+
+  //
+  // Decode the images as tasks of their own so they run alongside the
+  // geometry below instead of in front of it. Each writes only its own slot.
   //
   auto&& images =
     g.images.value_or<decltype(gltf::GLTF::images)::value_type>({});
-  std::vector<VkExtent3D> imagesExtents;
-  std::vector<std::vector<std::byte>> imagesBytes;
+  std::vector<tl::expected<DecodedImage, std::system_error>> decodedImages(
+    images.size());
+  tbb::task_group imageTasks;
 
   for (auto&& image : images) {
-    if (image.uri) {
-      filesystem::path uriPath(*image.uri);
-      if (uriPath.is_relative()) uriPath = baseDir / uriPath;
+    if (!image.uri) continue;
+    filesystem::path uriPath(*image.uri);
+    if (uriPath.is_relative()) uriPath = baseDir / uriPath;
+    dependencies.push_back(uriPath);
+  }
 
-      int x, y, n;
-      if (auto pixels = stbi_load(uriPath.string().c_str(), &x, &y, &n, 4);
-          !pixels) {
-        IRIS_LOG_LEAVE();
-        return tl::unexpected(
-          std::system_error(Error::kFileNotSupported, stbi_failure_reason()));
-      } else {
-        imagesBytes.emplace_back(reinterpret_cast<std::byte*>(pixels),
-                                 reinterpret_cast<std::byte*>(pixels) +
-                                   x * y * 4);
-        imagesExtents.push_back(
-          {static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), 1});
-      }
-    } else if (image.bufferView) {
-      imagesBytes.push_back(buffersBytes[*image.bufferView]);
-    } else {
+  for (std::size_t i = 0; i < images.size(); ++i) {
+    imageTasks.run([&, i]() {
+      decodedImages[i] = DecodeImage(g, images[i], baseDir, buffersBytes);
+    });
+  }
+
+  std::vector<tl::expected<std::optional<MeshData>, std::system_error>>
+    results(uniqueJobs.size(), std::optional<MeshData>{});
+  std::vector<std::size_t> bytesRead(uniqueJobs.size(), 0);
+
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, uniqueJobs.size()),
+                    [&](tbb::blocked_range<std::size_t> const& range) {
+                      for (std::size_t i = range.begin(); i != range.end();
+                           ++i) {
+                        results[i] = g.ParsePrimitive(
+                          uniqueJobs[i], path, buffersBytes, bytesRead[i]);
+                      }
+                    });
+
+  auto const decodeEnd = std::chrono::steady_clock::now();
+
+  SceneData sceneData;
+  auto&& meshData = sceneData.meshes;
+  meshData.reserve(results.size());
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    auto&& result = results[i];
+    if (!result) {
+      imageTasks.wait();
       IRIS_LOG_LEAVE();
-      return tl::unexpected(std::system_error(
-        Error::kFileNotSupported, "image with no uri or bufferView"));
+      return tl::unexpected(result.error());
+    }
+    if (!*result) continue;
+
+    meshData.push_back(std::move(**result));
+    if (instanceMatrices[i].size() > 1) {
+      meshData.back().instanceMatrices = std::move(instanceMatrices[i]);
     }
+    if (statistics) statistics->primitiveBytesCopied.push_back(bytesRead[i]);
   }
 
-  if (!g.scene) {
-    GetLogger()->warn("no default scene specified; using first node");
-    g.scene = 0;
+  if (statistics) {
+    for (auto&& bytes : buffersBytes) {
+      statistics->bufferBytes += static_cast<std::size_t>(bytes.size());
+    }
   }
 
   //
-  // Parse the scene graph
+  // Reorder the index and vertex streams of every primitive for the vertex
+  // cache and vertex fetch, then simplify it into levels of detail that
+  // share the reordered vertices. Measuring each primitive before and after
+  // simulates the caches over every index, so it is only done when the
+  // results are logged.
   //
-  std::vector<MeshData> meshData;
-  if (auto p = g.ParseNode(*g.scene, glm::mat4x4(1.f), path, buffersBytes)) {
-    meshData = std::move(*p);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(p.error());
-  }
-
-  IRIS_LOG_LEAVE();
-  return meshData;
+  bool const reduceOverdraw = sReduceOverdraw;
+  bool const analyze = GetLogger()->should_log(spdlog::level::debug);
+  std::vector<MeshStatistics> before(analyze ? meshData.size() : 0);
+  std::vector<MeshStatistics> after(analyze ? meshData.size() : 0);
+
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, meshData.size()),
+                    [&](tbb::blocked_range<std::size_t> const& range) {
+                      for (std::size_t i = range.begin(); i != range.end();
+                           ++i) {
+                        if (analyze) {
+                          before[i] = meshData[i].Analyze(reduceOverdraw);
+                        }
+                        meshData[i].Optimize(reduceOverdraw);
+                        if (analyze) {
+                          after[i] = meshData[i].Analyze(reduceOverdraw);
+                        }
+                        meshData[i].GenerateLevelsOfDetail();
+                      }
+                    });
+
+  auto const optimizeEnd = std::chrono::steady_clock::now();
+
+  imageTasks.wait();
+  auto const imagesEnd = std::chrono::steady_clock::now();
+
+  float imagesMilliseconds = 0.f;
+  sceneData.images.reserve(decodedImages.size());
+
+  for (std::size_t i = 0; i < decodedImages.size(); ++i) {
+    auto&& decoded = decodedImages[i];
+    if (!decoded) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(decoded.error());
+    }
 
-#if 0
-  std::vector<Image> images;
-  std::vector<Sampler> samplers;
+    std::string imageName =
+      images[i].name.value_or(images[i].uri.value_or(fmt::format("{}", i)));
+    GetLogger()->debug("Image {} {} ({}x{}) decoded in {:.3f} ms", i,
+                       imageName, decoded->extent.width,
+                       decoded->extent.height, decoded->milliseconds);
+    imagesMilliseconds += decoded->milliseconds;
+
+    // The pixels stay in stb_image's allocation.
+    sceneData.images.push_back(
+      {std::move(imageName), decoded->extent,
+       std::shared_ptr<std::byte>(
+         reinterpret_cast<std::byte*>(decoded->pixels.release()),
+         stbi_image_free),
+       std::move(decoded->encoded), decoded->encodedSize});
+  }
 
-  std::size_t const numTextures =
-    gltf.textures.value_or<std::vector<gltf::Texture>>({}).size();
+  std::size_t const numTextures = g.textures ? g.textures->size() : 0;
+  sceneData.textures.reserve(numTextures);
 
   for (std::size_t i = 0; i < numTextures; ++i) {
-    auto&& texture = (*gltf.textures)[i];
-    auto&& bytes = imagesBytes[*texture.source];
-
-    std::string const textureName =
-      path.string() + (texture.name ? ":" + *texture.name : "");
-
-    if (auto image = Image::CreateFromMemory(
-          VK_IMAGE_TYPE_2D, VK_FORMAT_R8G8B8A8_UNORM, imagesExtents[i],
-          VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
-          gsl::not_null(bytes.data()), 4, textureName + ":image",
-          sCommandPool)) {
-      images.push_back(std::move(*image));
+    if (auto t = ConvertTexture(g, i)) {
+      sceneData.textures.push_back(*t);
     } else {
       IRIS_LOG_LEAVE();
-      return tl::unexpected(image.error());
+      return tl::unexpected(t.error());
     }
+  }
 
-    VkSamplerCreateInfo samplerCI = {};
-    samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerCI.magFilter = VK_FILTER_LINEAR; // auto ??
-    samplerCI.minFilter = VK_FILTER_LINEAR; // auto ??
-    samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerCI.mipLodBias = 0.f;
-    samplerCI.anisotropyEnable = VK_FALSE;
-    samplerCI.maxAnisotropy = 1;
-    samplerCI.compareEnable = VK_FALSE;
-    samplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerCI.minLod = -1000.f;
-    samplerCI.maxLod = 1000.f;
-    samplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerCI.unnormalizedCoordinates = VK_FALSE;
-
-    if (texture.sampler) {
-      auto&& sampler = (*gltf.samplers)[*texture.sampler];
-
-      switch (sampler.magFilter.value_or(9720)) {
-      case 9728: samplerCI.magFilter = VK_FILTER_NEAREST; break;
-      case 9729: samplerCI.magFilter = VK_FILTER_LINEAR; break;
-      }
+  if (g.materials) {
+    for (auto&& material : *g.materials) {
+      sceneData.materials.push_back(ConvertMaterial(material));
+    }
+  }
 
-      switch (sampler.minFilter.value_or(9720)) {
-      case 9728:
-        samplerCI.minFilter = VK_FILTER_NEAREST;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        samplerCI.minLod = 0.0;
-        samplerCI.maxLod = 0.25;
-        break;
-      case 9729:
-        samplerCI.minFilter = VK_FILTER_LINEAR;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        samplerCI.minLod = 0.0;
-        samplerCI.maxLod = 0.25;
-        break;
-      case 9984:
-        samplerCI.minFilter = VK_FILTER_NEAREST;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        break;
-      case 9985:
-        samplerCI.minFilter = VK_FILTER_LINEAR;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        break;
-      case 9986:
-        samplerCI.minFilter = VK_FILTER_NEAREST;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        break;
-      case 9987:
-        samplerCI.minFilter = VK_FILTER_LINEAR;
-        samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        break;
-      }
+  MeshStatistics totalBefore, totalAfter;
+  std::size_t numLevels = 0, numLevelIndices = 0;
+  for (std::size_t i = 0; i < meshData.size(); ++i) {
+    for (auto&& level : meshData[i].levelsOfDetail) {
+      numLevelIndices += level.indices.size();
+    }
+    numLevels += meshData[i].levelsOfDetail.size();
+    if (!analyze) continue;
+
+    GetLogger()->debug(
+      "Primitive {} ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, "
+      "overfetch {:.3f} -> {:.3f}",
+      meshData[i].name, before[i].ACMR(), after[i].ACMR(), before[i].ATVR(),
+      after[i].ATVR(), before[i].Overfetch(), after[i].Overfetch());
+    totalBefore += before[i];
+    totalAfter += after[i];
+  }
 
-      switch (sampler.wrapS.value_or(10497)) {
-      case 10497:
-        samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        break;
-      case 33071:
-        samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        break;
-      case 33648:
-        samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-        break;
-      }
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+  GetLogger()->info(
+    "Decoded {} primitives for {} placements from {} on {} threads: "
+    "flatten {:.3f} ms, decode {:.3f} ms, optimize {:.3f} ms",
+    meshData.size(), jobs.size(), path.string(),
+    tbb::this_task_arena::max_concurrency(),
+    Milliseconds(decodeStart - flattenStart).count(),
+    Milliseconds(decodeEnd - decodeStart).count(),
+    Milliseconds(optimizeEnd - decodeEnd).count());
+  if (!decodedImages.empty()) {
+    GetLogger()->info(
+      "Decoded {} images in {:.3f} ms of decoding, waited {:.3f} ms for "
+      "them after the geometry",
+      decodedImages.size(), imagesMilliseconds,
+      Milliseconds(imagesEnd - optimizeEnd).count());
+  }
+  if (analyze) {
+    GetLogger()->debug(
+      "Optimized {} triangles: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, "
+      "overfetch {:.3f} -> {:.3f}",
+      totalAfter.numTriangles, totalBefore.ACMR(), totalAfter.ACMR(),
+      totalBefore.ATVR(), totalAfter.ATVR(), totalBefore.Overfetch(),
+      totalAfter.Overfetch());
+    if (reduceOverdraw) {
+      GetLogger()->debug("Overdraw {:.3f} -> {:.3f}", totalBefore.Overdraw(),
+                         totalAfter.Overdraw());
+    }
+  }
+  GetLogger()->info("Generated {} levels of detail with {} triangles",
+                    numLevels, numLevelIndices / 3);
 
-      switch (sampler.wrapT.value_or(10497)) {
-      case 10497:
-        samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        break;
-      case 33071:
-        samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        break;
-      case 33648:
-        samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-        break;
+  IRIS_LOG_LEAVE();
+  return sceneData;
+} // ParseGLTF
+
+/*! \brief Find the JSON and optional binary chunk of the .glb in \p file.
+ */
+static std::system_error
+SplitGLB(MappedFile const& file, gsl::span<std::byte const>& jsonChunk,
+         gsl::span<std::byte const>& binaryChunk) noexcept {
+  // From the glTF 2.0 spec: a 12-byte header of magic, version and length,
+  // followed by chunks, each with a 4-byte length and 4-byte type. The first
+  // chunk must be JSON and the optional second chunk BIN; any other chunks
+  // must be ignored.
+  std::uint32_t constexpr kMagic = 0x46546C67;     // "glTF"
+  std::uint32_t constexpr kChunkJSON = 0x4E4F534A; // "JSON"
+  std::uint32_t constexpr kChunkBIN = 0x004E4942;  // "BIN\0"
+
+  jsonChunk = {};
+  binaryChunk = {};
+
+  std::array<std::uint32_t, 3> header;
+  if (file.size < sizeof(header)) {
+    return {Error::kFileParseFailed, "file too small for header"};
+  }
+
+  std::memcpy(header.data(), file.data, sizeof(header));
+  if (header[0] != kMagic) {
+    return {Error::kFileParseFailed, "invalid magic"};
+  } else if (header[1] != 2) {
+    return {Error::kFileParseFailed,
+            fmt::format("Unsupported container version: {}", header[1])};
+  } else if (header[2] > file.size) {
+    return {Error::kFileParseFailed, "file is truncated"};
+  }
+
+  for (std::size_t offset = sizeof(header), chunkIdx = 0;
+       offset + 8 <= header[2]; ++chunkIdx) {
+    std::array<std::uint32_t, 2> chunkHeader;
+    std::memcpy(chunkHeader.data(), file.data + offset, sizeof(chunkHeader));
+    offset += sizeof(chunkHeader);
+
+    if (offset + chunkHeader[0] > header[2]) {
+      return {Error::kFileParseFailed, "chunk is truncated"};
+    }
+
+    if (chunkIdx == 0) {
+      if (chunkHeader[1] != kChunkJSON) {
+        return {Error::kFileParseFailed, "first chunk is not JSON"};
       }
+      jsonChunk = {file.data + offset, chunkHeader[0]};
+    } else if (chunkIdx == 1 && chunkHeader[1] == kChunkBIN) {
+      binaryChunk = {file.data + offset, chunkHeader[0]};
     }
 
-    if (auto s = Sampler::Create(samplerCI, textureName + ":sampler")) {
-      samplers.push_back(std::move(*s));
+    offset += chunkHeader[0];
+  }
+
+  if (jsonChunk.data() == nullptr) {
+    return {Error::kFileParseFailed, "no JSON chunk"};
+  }
+
+  return {Error::kNone};
+} // SplitGLB
+
+//! \brief The bytes of a .gltf or .glb and its JSON and binary chunk.
+struct GLTFFile {
+  //! The file, read for .gltf and mapped for .glb.
+  std::vector<std::byte> bytes{};
+  MappedFile mapping{};
+  gsl::span<std::byte const> json{};
+  gsl::span<std::byte const> binaryChunk{};
+}; // struct GLTFFile
+
+static tl::expected<GLTFFile, std::system_error>
+ReadGLTFFile(filesystem::path const& path) noexcept {
+  IRIS_LOG_ENTER();
+  GLTFFile file;
+
+  if (path.extension().compare(".glb") != 0) {
+    if (auto b = ReadFile(path)) {
+      file.bytes = std::move(*b);
     } else {
       IRIS_LOG_LEAVE();
-      return tl::unexpected(s.error());
+      return tl::unexpected(b.error());
     }
+    file.json = file.bytes;
+    IRIS_LOG_LEAVE();
+    return file;
   }
-#endif
-} // ReadGLTF
+
+  // The mapping only has to outlive parsing: SceneData copies what it needs.
+  if (auto f = MapFile(path)) {
+    file.mapping = std::move(*f);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(f.error());
+  }
+
+  if (auto error = SplitGLB(file.mapping, file.json, file.binaryChunk);
+      error.code()) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(error);
+  }
+
+  IRIS_LOG_LEAVE();
+  return file;
+} // ReadGLTFFile
+
+/*! \brief Parse the JSON and decode the SceneData of \p path, adding the
+ * files it reads to \p dependencies. If \p statistics is not null what
+ * decoding copied is recorded in it.
+ */
+static tl::expected<SceneData, std::system_error>
+ParseScene(filesystem::path const& path, gsl::span<std::byte const> jsonBytes,
+           gsl::span<std::byte const> binaryChunk,
+           std::vector<filesystem::path>& dependencies,
+           GLTFDecodeStatistics* statistics) noexcept {
+  IRIS_LOG_ENTER();
+  auto const parseStart = std::chrono::steady_clock::now();
+
+  gltf::GLTF g;
+  if (auto p = gltf::ParseJSON(jsonBytes, false)) {
+    g = std::move(*p);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(p.error());
+  }
+
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+  GetLogger()->info(
+    "Parsed {} bytes of JSON from {} in {:.3f} ms", jsonBytes.size(),
+    path.string(),
+    Milliseconds(std::chrono::steady_clock::now() - parseStart).count());
+
+  IRIS_LOG_LEAVE();
+  return ParseGLTF(std::move(g), path, binaryChunk, dependencies, statistics);
+} // ParseScene
+
+/*! \brief Read the scene of \p path from the scene cache if it has an entry
+ * for the JSON of \p file, otherwise parse it and write the entry.
+ *
+ * A cached scene is viewed in place in the mapped cache entry. A parsed one
+ * drops its encoded images once they are written, keeping only the pixels.
+ */
+static tl::expected<SceneDataView, std::system_error>
+ReadCachedOrParse(filesystem::path const& path,
+                  GLTFFile const& file) noexcept {
+  IRIS_LOG_ENTER();
+
+  // Options that change the processed SceneData are part of the key.
+  std::uint8_t const reduceOverdraw = sReduceOverdraw ? 1 : 0;
+  std::uint64_t const contentHash = HashBytes(
+    file.json, HashBytes({reinterpret_cast<std::byte const*>(
+                            &reduceOverdraw),
+                          sizeof(reduceOverdraw)}));
+
+  if (auto cached = ReadSceneCache(path, contentHash)) {
+    IRIS_LOG_LEAVE();
+    return std::move(*cached);
+  } else {
+    GetLogger()->debug("Parsing {}: {}", path.string(),
+                       cached.error().what());
+  }
+
+  std::vector<filesystem::path> dependencies;
+  SceneData sceneData;
+  if (auto s =
+        ParseScene(path, file.json, file.binaryChunk, dependencies, nullptr)) {
+    sceneData = std::move(*s);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(s.error());
+  }
+
+  if (auto error = WriteSceneCache(path, contentHash, dependencies, sceneData);
+      error.code()) {
+    GetLogger()->warn("Cannot write scene cache for {}: {}", path.string(),
+                      error.what());
+  }
+
+  for (auto&& image : sceneData.images) {
+    image.encoded.reset();
+    image.encodedSize = 0;
+  }
+
+  IRIS_LOG_LEAVE();
+  return SceneDataView(std::make_shared<SceneData const>(std::move(sceneData)));
+} // ReadCachedOrParse
 
 } // namespace iris::Renderer::io
 
@@ -1332,15 +2283,101 @@ std::function<std::system_error(void)>
 iris::Renderer::io::LoadGLTF(filesystem::path const& path) noexcept {
   IRIS_LOG_ENTER();
 
-  std::vector<MeshData> meshData;
-  if (auto p = ReadGLTF(path)) {
-    meshData = std::move(*p);
+  GLTFFile file;
+  if (auto f = ReadGLTFFile(path)) {
+    file = std::move(*f);
+  } else {
+    IRIS_LOG_LEAVE();
+    return [error = f.error()]() { return error; };
+  }
+
+  // The view keeps what it refers to alive until the scene is created, so a
+  // cached scene is copied straight from the cache entry into staging.
+  SceneDataView sceneData;
+  if (auto p = ReadCachedOrParse(path, file)) {
+    sceneData = std::move(*p);
   } else {
     IRIS_LOG_LEAVE();
     return [error = p.error()]() { return error; };
   }
 
   IRIS_LOG_LEAVE();
-  return [meshData]() { return CreateMeshes(meshData); };
+  return [sceneData = std::move(sceneData), name = path.string()]() {
+    return CreateScene(sceneData, name);
+  };
 } // iris::Renderer::io::LoadGLTF
 
+std::system_error
+iris::Renderer::io::ParseGLTFJSON(filesystem::path const& path,
+                                  bool dom) noexcept {
+  IRIS_LOG_ENTER();
+
+  MappedFile file;
+  if (auto f = MapFile(path)) {
+    file = std::move(*f);
+  } else {
+    IRIS_LOG_LEAVE();
+    return f.error();
+  }
+
+  gsl::span<std::byte const> jsonBytes{file.data, file.size};
+  if (path.extension().compare(".glb") == 0) {
+    gsl::span<std::byte const> binaryChunk;
+    if (auto error = SplitGLB(file, jsonBytes, binaryChunk); error.code()) {
+      IRIS_LOG_LEAVE();
+      return error;
+    }
+  }
+
+  if (auto g = gltf::ParseJSON(jsonBytes, dom); !g) {
+    IRIS_LOG_LEAVE();
+    return g.error();
+  }
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::io::ParseGLTFJSON
+
+tl::expected<std::string, std::system_error>
+iris::Renderer::io::NormalizeGLTFJSON(gsl::span<std::byte const> bytes,
+                                      bool dom) noexcept {
+  IRIS_LOG_ENTER();
+
+  if (auto g = gltf::ParseJSON(bytes, dom)) {
+    json const j = *g;
+    IRIS_LOG_LEAVE();
+    return j.dump();
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(g.error());
+  }
+} // iris::Renderer::io::NormalizeGLTFJSON
+
+tl::expected<iris::Renderer::io::GLTFDecodeStatistics, std::system_error>
+iris::Renderer::io::DecodeGLTF(filesystem::path const& path,
+                               SceneData* sceneData) noexcept {
+  IRIS_LOG_ENTER();
+
+  GLTFFile file;
+  if (auto f = ReadGLTFFile(path)) {
+    file = std::move(*f);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(f.error());
+  }
+
+  GLTFDecodeStatistics statistics;
+  std::vector<filesystem::path> dependencies;
+  auto p = ParseScene(path, file.json, file.binaryChunk, dependencies,
+                      &statistics);
+
+  if (!p) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(p.error());
+  }
+
+  if (sceneData) *sceneData = std::move(*p);
+
+  IRIS_LOG_LEAVE();
+  return statistics;
+} // iris::Renderer::io::DecodeGLTF
@@ -1,6 +1,9 @@
 #ifndef HEV_IRIS_RENDERER_IO_GLTF_H_
 #define HEV_IRIS_RENDERER_IO_GLTF_H_
 
+#include "expected.hpp"
+#include "gsl/gsl"
+#include <cstddef>
 #if STD_FS_IS_EXPERIMENTAL
 #include <experimental/filesystem>
 namespace filesystem = std::experimental::filesystem;
@@ -9,13 +12,52 @@ namespace filesystem = std::experimental::filesystem;
 namespace filesystem = std::filesystem;
 #endif
 #include <functional>
+#include <string>
 #include <system_error>
+#include <vector>
+
+namespace iris::Renderer {
+struct SceneData;
+} // namespace iris::Renderer
 
 namespace iris::Renderer::io {
 
 std::function<std::system_error(void)>
 LoadGLTF(filesystem::path const& path) noexcept;
 
+/*! \brief Parse only the JSON of the .gltf or .glb file at \p path into the
+ * structure loading it starts from, then discard it. If \p dom is true the
+ * JSON is first parsed into a DOM of the whole document, as it was before
+ * the streaming parser. For measuring the parser only.
+ */
+std::system_error ParseGLTFJSON(filesystem::path const& path,
+                                bool dom) noexcept;
+
+/*! \brief Parse the glTF JSON in \p bytes as ParseGLTFJSON does and
+ * serialize the structure it produced back to JSON, which holds only what
+ * loading uses. For testing that both parsers produce the same structure.
+ */
+tl::expected<std::string, std::system_error>
+NormalizeGLTFJSON(gsl::span<std::byte const> bytes, bool dom) noexcept;
+
+//! \brief What DecodeGLTF copied out of the buffers of a glTF file.
+struct GLTFDecodeStatistics {
+  //! Bytes of every buffer of the file, which are read or mapped once.
+  std::size_t bufferBytes{0};
+  //! Bytes each decoded primitive copied out of the buffers, in the order
+  //! of the MeshData of the scene.
+  std::vector<std::size_t> primitiveBytesCopied{};
+}; // struct GLTFDecodeStatistics
+
+/*! \brief Decode the .gltf or .glb file at \p path as loading does, but
+ * without the scene cache and without creating anything on the GPU. If
+ * \p sceneData is not null the decoded scene is moved into it. For measuring
+ * and testing the loader only.
+ */
+tl::expected<GLTFDecodeStatistics, std::system_error>
+DecodeGLTF(filesystem::path const& path,
+           SceneData* sceneData = nullptr) noexcept;
+
 } // namespace iris::Renderer::io
 
 #endif // HEV_IRIS_RENDERER_IO_GLTF_H_
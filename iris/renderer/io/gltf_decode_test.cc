@@ -0,0 +1,219 @@
+#include "renderer/io/gltf.h"
+#include "config.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "renderer/io/read_file.h"
+#include "renderer/mesh.h"
+#include "spdlog/sinks/null_sink.h"
+#include "tbb/task_arena.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using iris::Renderer::MeshData;
+using iris::Renderer::SceneData;
+using iris::Renderer::io::DecodeGLTF;
+
+// The library logs through the "iris" logger the application registers.
+static auto const sLogger = spdlog::null_logger_mt("iris");
+
+/*! \brief Write a .gltf of \p numMeshes indexed grids of \p gridSize by
+ * \p gridSize vertices into \p directory. The grids have no normals or
+ * tangents, so decoding generates both, and the first is placed twice.
+ */
+static filesystem::path WriteGridScene(filesystem::path const& directory,
+                                       int numMeshes, int gridSize) {
+  filesystem::create_directories(directory);
+
+  std::vector<std::byte> bytes;
+  auto const append = [&bytes](void const* data, std::size_t size) {
+    std::size_t const offset = bytes.size();
+    bytes.resize(offset + size);
+    std::memcpy(bytes.data() + offset, data, size);
+    return offset;
+  };
+
+  std::string meshes, accessors, bufferViews, children;
+  for (int m = 0; m < numMeshes; ++m) {
+    std::vector<float> positions, texcoords;
+    for (int y = 0; y < gridSize; ++y) {
+      for (int x = 0; x < gridSize; ++x) {
+        float const u = static_cast<float>(x) / (gridSize - 1);
+        float const v = static_cast<float>(y) / (gridSize - 1);
+        positions.insert(positions.end(),
+                         {u, std::sin(u * 7.f + m) * std::cos(v * 5.f), v});
+        texcoords.insert(texcoords.end(), {u, v});
+      }
+    }
+
+    std::vector<std::uint32_t> indices;
+    for (int y = 0; y + 1 < gridSize; ++y) {
+      for (int x = 0; x + 1 < gridSize; ++x) {
+        auto const i = static_cast<std::uint32_t>(y * gridSize + x);
+        auto const below = i + static_cast<std::uint32_t>(gridSize);
+        indices.insert(indices.end(), {i, below, i + 1, i + 1, below,
+                                       below + 1});
+      }
+    }
+
+    std::size_t const numVertices = positions.size() / 3;
+    std::size_t const positionsOffset =
+      append(positions.data(), positions.size() * sizeof(float));
+    std::size_t const texcoordsOffset =
+      append(texcoords.data(), texcoords.size() * sizeof(float));
+    std::size_t const indicesOffset =
+      append(indices.data(), indices.size() * sizeof(std::uint32_t));
+
+    char const* separator = m == 0 ? "" : ",";
+    bufferViews += fmt::format(
+      R"({0}{{"buffer":0,"byteOffset":{1},"byteLength":{2}}},)"
+      R"({{"buffer":0,"byteOffset":{3},"byteLength":{4}}},)"
+      R"({{"buffer":0,"byteOffset":{5},"byteLength":{6}}})",
+      separator, positionsOffset, positions.size() * sizeof(float),
+      texcoordsOffset, texcoords.size() * sizeof(float), indicesOffset,
+      indices.size() * sizeof(std::uint32_t));
+    accessors += fmt::format(
+      R"({0}{{"bufferView":{1},"componentType":5126,"count":{4},)"
+      R"("type":"VEC3"}},)"
+      R"({{"bufferView":{2},"componentType":5126,"count":{4},)"
+      R"("type":"VEC2"}},)"
+      R"({{"bufferView":{3},"componentType":5125,"count":{5},)"
+      R"("type":"SCALAR"}})",
+      separator, 3 * m, 3 * m + 1, 3 * m + 2, numVertices, indices.size());
+    meshes += fmt::format(
+      R"({0}{{"primitives":[{{"attributes":{{"POSITION":{1},)"
+      R"("TEXCOORD_0":{2}}},"indices":{3}}}]}})",
+      separator, 3 * m, 3 * m + 1, 3 * m + 2);
+    children += fmt::format("{}{}", separator, m + 1);
+  }
+
+  std::string nodes = fmt::format(R"({{"children":[{},{}]}})", children,
+                                  numMeshes + 1);
+  for (int m = 0; m < numMeshes; ++m) {
+    nodes += fmt::format(R"(,{{"mesh":{},"translation":[{},0,{}]}})", m,
+                         m % 8, m / 8);
+  }
+  nodes += R"(,{"mesh":0,"translation":[0,2,0]})";
+
+  std::string const json = fmt::format(
+    R"({{"asset":{{"version":"2.0"}},"scene":0,"scenes":[{{"nodes":[0]}}],)"
+    R"("nodes":[{}],"meshes":[{}],"accessors":[{}],"bufferViews":[{}],)"
+    R"("buffers":[{{"uri":"grid.bin","byteLength":{}}}]}})",
+    nodes, meshes, accessors, bufferViews, bytes.size());
+
+  std::ofstream((directory / "grid.bin").string(), std::ios::binary)
+    .write(reinterpret_cast<char const*>(bytes.data()),
+           static_cast<std::streamsize>(bytes.size()));
+  std::ofstream((directory / "grid.gltf").string(), std::ios::binary)
+    .write(json.data(), static_cast<std::streamsize>(json.size()));
+
+  return directory / "grid.gltf";
+} // WriteGridScene
+
+//! \brief Decode \p path in \p arena three times, returning the first scene
+//! and the fastest time in milliseconds.
+static float DecodeIn(tbb::task_arena& arena, filesystem::path const& path,
+                      SceneData& sceneData) {
+  float fastest = std::numeric_limits<float>::max();
+  for (int i = 0; i < 3; ++i) {
+    SceneData decoded;
+    auto const start = std::chrono::steady_clock::now();
+    arena.execute([&]() {
+      auto statistics = DecodeGLTF(path, &decoded);
+      EXPECT_TRUE(statistics) << statistics.error().what();
+    });
+    fastest = std::min(fastest, std::chrono::duration<float, std::milli>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+    if (i == 0) sceneData = std::move(decoded);
+  }
+  return fastest;
+} // DecodeIn
+
+template <class T>
+static bool SameBytes(std::vector<T> const& a, std::vector<T> const& b) {
+  return a.size() == b.size() &&
+         (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) ==
+                         0);
+} // SameBytes
+
+template <class T>
+static bool SameBytes(T const& a, T const& b) {
+  return std::memcmp(&a, &b, sizeof(T)) == 0;
+} // SameBytes
+
+static void ExpectSameMeshData(MeshData const& a, MeshData const& b) {
+  EXPECT_EQ(a.name, b.name);
+  EXPECT_TRUE(SameBytes(a.matrix, b.matrix)) << a.name;
+  EXPECT_TRUE(SameBytes(a.instanceMatrices, b.instanceMatrices)) << a.name;
+  EXPECT_TRUE(SameBytes(a.vertices, b.vertices)) << a.name;
+  EXPECT_TRUE(SameBytes(a.indices, b.indices)) << a.name;
+  ASSERT_EQ(a.levelsOfDetail.size(), b.levelsOfDetail.size()) << a.name;
+  for (std::size_t i = 0; i < a.levelsOfDetail.size(); ++i) {
+    EXPECT_TRUE(
+      SameBytes(a.levelsOfDetail[i].indices, b.levelsOfDetail[i].indices))
+      << a.name << " level " << i;
+    EXPECT_TRUE(
+      SameBytes(a.levelsOfDetail[i].error, b.levelsOfDetail[i].error))
+      << a.name << " level " << i;
+  }
+  EXPECT_TRUE(SameBytes(a.boundsMin, b.boundsMin)) << a.name;
+  EXPECT_TRUE(SameBytes(a.boundsMax, b.boundsMax)) << a.name;
+  EXPECT_EQ(a.topology, b.topology) << a.name;
+  EXPECT_EQ(a.material, b.material) << a.name;
+  EXPECT_EQ(a.hasTexCoords, b.hasTexCoords) << a.name;
+} // ExpectSameMeshData
+
+/*! \brief Decode \p path on one thread and on the default arena, expect the
+ * scenes to be identical byte for byte and report both times.
+ */
+static void ExpectDeterministicDecode(filesystem::path const& path) {
+  tbb::task_arena serialArena(1);
+  tbb::task_arena defaultArena;
+
+  SceneData serial, parallel;
+  float const serialTime = DecodeIn(serialArena, path, serial);
+  float const parallelTime = DecodeIn(defaultArena, path, parallel);
+
+  ASSERT_FALSE(serial.meshes.empty());
+  ASSERT_EQ(serial.meshes.size(), parallel.meshes.size());
+  for (std::size_t i = 0; i < serial.meshes.size(); ++i) {
+    ExpectSameMeshData(serial.meshes[i], parallel.meshes[i]);
+  }
+
+  ASSERT_EQ(serial.images.size(), parallel.images.size());
+  for (std::size_t i = 0; i < serial.images.size(); ++i) {
+    auto&& a = serial.images[i];
+    auto&& b = parallel.images[i];
+    ASSERT_TRUE(SameBytes(a.extent, b.extent)) << a.name;
+    EXPECT_EQ(std::memcmp(a.pixels.get(), b.pixels.get(),
+                          a.extent.width * a.extent.height * 4),
+              0)
+      << a.name;
+  }
+
+  ::testing::Test::RecordProperty("serialMilliseconds",
+                                  fmt::format("{:.3f}", serialTime));
+  ::testing::Test::RecordProperty("parallelMilliseconds",
+                                  fmt::format("{:.3f}", parallelTime));
+} // ExpectDeterministicDecode
+
+TEST(DecodeGLTF, IsDeterministicAcrossThreadCounts) {
+  // Unique, so concurrent runs never write or remove each other's files.
+  filesystem::path const directory = iris::Renderer::io::TemporaryPath(
+    filesystem::temp_directory_path() / "iris_gltf_decode_test");
+  ExpectDeterministicDecode(WriteGridScene(directory, 48, 48));
+  filesystem::remove_all(directory);
+}
+
+TEST(DecodeGLTF, IsDeterministicForTexturedAsset) {
+  ExpectDeterministicDecode(
+    filesystem::path(iris::kIRISContentDirectory) /
+    "assets/models/BoxTextured/glTF/BoxTextured.gltf");
+}
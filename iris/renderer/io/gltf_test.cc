@@ -0,0 +1,186 @@
+#include "renderer/io/gltf.h"
+#include "error.h"
+#include "gtest/gtest.h"
+#include "spdlog/sinks/null_sink.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using iris::Renderer::io::NormalizeGLTFJSON;
+
+// The library logs through the "iris" logger the application registers.
+static auto const sLogger = spdlog::null_logger_mt("iris");
+
+//! A small document with every member loading reads, and extensions and
+//! extras it skips at the top level and inside elements.
+static constexpr std::string_view kDocument = R"({
+  "asset": {
+    "version": "2.0",
+    "generator": "hand written",
+    "copyright": "public domain",
+    "extras": {"note": "ignored"}
+  },
+  "extensionsUsed": ["KHR_materials_unlit"],
+  "extensions": {"KHR_lights_punctual": {"lights": [{"type": "point"}]}},
+  "scene": 0,
+  "scenes": [{"name": "main", "nodes": [0, 2]}],
+  "nodes": [
+    {
+      "name": "root",
+      "children": [1],
+      "translation": [1.5, -2, 3],
+      "rotation": [0, 0.7071068, 0, 0.7071068],
+      "scale": [2, 2, 2],
+      "extras": {"tags": [{"a": 1}, {"b": [true, false, null]}]}
+    },
+    {"mesh": 0, "matrix": [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 5, 6, 7, 1]},
+    {"mesh": 0}
+  ],
+  "meshes": [{
+    "name": "quad",
+    "primitives": [{
+      "attributes": {"POSITION": 1, "NORMAL": 2, "TEXCOORD_0": 3},
+      "indices": 0,
+      "material": 0,
+      "mode": 4,
+      "extras": {}
+    }]
+  }],
+  "materials": [{
+    "name": "painted",
+    "pbrMetallicRoughness": {
+      "baseColorFactor": [0.8, 0.1, 0.1, 1],
+      "baseColorTexture": {"index": 0, "texCoord": 0},
+      "metallicFactor": 0.25,
+      "roughnessFactor": 0.75,
+      "metallicRoughnessTexture": {"index": 1}
+    },
+    "normalTexture": {"index": 1, "scale": 0.5},
+    "occlusionTexture": {"index": 1, "strength": 0.9},
+    "emissiveTexture": {"index": 0},
+    "emissiveFactor": [0.1, 0.2, 0.3],
+    "alphaMode": "MASK",
+    "alphaCutoff": 0.4,
+    "doubleSided": true
+  }],
+  "textures": [{"sampler": 0, "source": 0}, {"source": 1, "name": "orm"}],
+  "images": [
+    {"uri": "color.png", "name": "color"},
+    {"bufferView": 4, "mimeType": "image/png"}
+  ],
+  "samplers": [{"magFilter": 9729, "minFilter": 9987, "wrapS": 33648,
+                "wrapT": 10497}],
+  "accessors": [
+    {"bufferView": 0, "componentType": 5123, "count": 6, "type": "SCALAR"},
+    {"bufferView": 1, "componentType": 5126, "count": 4, "type": "VEC3",
+     "min": [-1, -1, 0], "max": [1, 1, 0]},
+    {"bufferView": 2, "byteOffset": 0, "componentType": 5126, "count": 4,
+     "type": "VEC3", "name": "normals"},
+    {"bufferView": 3, "componentType": 5123, "normalized": true, "count": 4,
+     "type": "VEC2"}
+  ],
+  "bufferViews": [
+    {"buffer": 0, "byteOffset": 0, "byteLength": 12, "target": 34963},
+    {"buffer": 0, "byteOffset": 12, "byteLength": 48, "target": 34962},
+    {"buffer": 0, "byteOffset": 60, "byteLength": 48, "byteStride": 12},
+    {"buffer": 0, "byteOffset": 108, "byteLength": 16, "name": "uvs"},
+    {"buffer": 1, "byteLength": 1024}
+  ],
+  "buffers": [
+    {"uri": "quad.bin", "byteLength": 124},
+    {"byteLength": 1024, "name": "image data"}
+  ]
+})";
+
+static gsl::span<std::byte const> Bytes(std::string_view document) {
+  return {reinterpret_cast<std::byte const*>(document.data()),
+          static_cast<std::ptrdiff_t>(document.size())};
+} // Bytes
+
+static bool Contains(std::string const& haystack, std::string_view needle) {
+  return haystack.find(needle) != std::string::npos;
+} // Contains
+
+TEST(GLTFJSON, StreamingMatchesDOM) {
+  auto const dom = NormalizeGLTFJSON(Bytes(kDocument), true);
+  auto const streamed = NormalizeGLTFJSON(Bytes(kDocument), false);
+  ASSERT_TRUE(dom) << dom.error().what();
+  ASSERT_TRUE(streamed) << streamed.error().what();
+  EXPECT_EQ(*streamed, *dom);
+
+  // Everything loading reads made it through, and nothing it skips did.
+  for (auto&& member :
+       {"\"accessors\"", "\"bufferViews\"", "\"buffers\"", "\"images\"",
+        "\"materials\"", "\"meshes\"", "\"nodes\"", "\"samplers\"",
+        "\"scene\"", "\"scenes\"", "\"textures\"", "\"doubleSided\"",
+        "\"metallicRoughnessTexture\"", "\"byteStride\"", "\"image data\""}) {
+    EXPECT_TRUE(Contains(*streamed, member)) << member;
+  }
+  EXPECT_FALSE(Contains(*streamed, "extras"));
+  EXPECT_FALSE(Contains(*streamed, "extensions"));
+  EXPECT_FALSE(Contains(*streamed, "KHR_"));
+}
+
+TEST(GLTFJSON, StreamingMatchesDOMForMinimalDocument) {
+  std::string_view const document = R"({"asset": {"version": "2.0"}})";
+  auto const dom = NormalizeGLTFJSON(Bytes(document), true);
+  auto const streamed = NormalizeGLTFJSON(Bytes(document), false);
+  ASSERT_TRUE(dom) << dom.error().what();
+  ASSERT_TRUE(streamed) << streamed.error().what();
+  EXPECT_EQ(*streamed, *dom);
+}
+
+//! \brief Expect both parsers to reject \p document, the streaming one with
+//! an error containing \p message.
+static void ExpectMalformed(std::string_view document,
+                            std::string_view message) {
+  auto const dom = NormalizeGLTFJSON(Bytes(document), true);
+  ASSERT_FALSE(dom) << document;
+  EXPECT_EQ(dom.error().code(), iris::Error::kFileParseFailed);
+
+  auto const streamed = NormalizeGLTFJSON(Bytes(document), false);
+  ASSERT_FALSE(streamed) << document;
+  EXPECT_EQ(streamed.error().code(), iris::Error::kFileParseFailed);
+  EXPECT_TRUE(Contains(streamed.error().what(), message))
+    << streamed.error().what();
+} // ExpectMalformed
+
+TEST(GLTFJSON, RejectsDocumentThatIsNotAnObject) {
+  ExpectMalformed(R"([{"asset": {"version": "2.0"}}])",
+                  "document is not an object");
+  ExpectMalformed(R"("asset")", "document is not an object");
+}
+
+TEST(GLTFJSON, RejectsMissingAsset) {
+  ExpectMalformed(R"({"nodes": [{"mesh": 0}]})", "key 'asset' not found");
+}
+
+TEST(GLTFJSON, RejectsArrayMemberThatIsNotAnArray) {
+  ExpectMalformed(R"({"asset": {"version": "2.0"}, "nodes": {"mesh": 0}})",
+                  "top-level member is not an array");
+  ExpectMalformed(R"({"asset": {"version": "2.0"}, "meshes": 3})",
+                  "top-level member is not an array");
+  ExpectMalformed(R"({"asset": {"version": "2.0"}, "accessors": "none"})",
+                  "top-level member is not an array");
+}
+
+TEST(GLTFJSON, RejectsMembersOfTheWrongType) {
+  ExpectMalformed(R"({"asset": {"version": "2.0"}, "scene": "first"})",
+                  "type must be number");
+  ExpectMalformed(R"({"asset": {"version": "2.0"}, "nodes": [{"mesh": "a"}]})",
+                  "type must be number");
+  ExpectMalformed(R"({"asset": {"version": 2}})", "type must be string");
+}
+
+TEST(GLTFJSON, RejectsMissingRequiredMembers) {
+  ExpectMalformed(R"({"asset": {}})", "key 'version' not found");
+  ExpectMalformed(
+    R"({"asset": {"version": "2.0"}, "buffers": [{"uri": "a.bin"}]})",
+    "key 'byteLength' not found");
+}
+
+TEST(GLTFJSON, RejectsInvalidJSON) {
+  ExpectMalformed(R"({"asset": {"version": "2.0"})", "parse error");
+  ExpectMalformed(R"({"asset": {"version": "2.0"},})", "parse error");
+  ExpectMalformed("", "parse error");
+}
@@ -6,7 +6,6 @@
 
 namespace iris::Renderer::io {
 
-extern VkCommandPool sCommandPool;
 extern VkDescriptorPool sDescriptorPool;
 
 } // namespace iris::Renderer::io
@@ -0,0 +1,154 @@
+#include "renderer/io/map_file.h"
+#include "config.h"
+#include "gsl/gsl"
+#include "logging.h"
+#if PLATFORM_WINDOWS
+#include <Windows.h>
+#elif PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
+#include <utility>
+
+tl::expected<iris::Renderer::io::MappedFile, std::system_error>
+iris::Renderer::io::MapFile(filesystem::path const& path) noexcept {
+  IRIS_LOG_ENTER();
+
+  filesystem::path filePath;
+  if (filesystem::exists(path)) {
+    filePath = path;
+  } else if (filesystem::exists(kIRISContentDirectory / path)) {
+    filePath = kIRISContentDirectory / path;
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::make_error_code(std::errc::no_such_file_or_directory),
+      path.string()));
+  }
+
+  GetLogger()->debug("Mapping {}", filePath.string());
+  MappedFile file;
+
+#if PLATFORM_WINDOWS
+
+  HANDLE fh = ::CreateFileW(filePath.wstring().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fh == INVALID_HANDLE_VALUE) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::error_code(::GetLastError(), std::system_category()),
+      path.string()));
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!::GetFileSizeEx(fh, &fileSize)) {
+    std::error_code const ec(::GetLastError(), std::system_category());
+    ::CloseHandle(fh);
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(ec, path.string()));
+  }
+
+  file.size = static_cast<std::size_t>(fileSize.QuadPart);
+  if (file.size == 0) {
+    ::CloseHandle(fh);
+    IRIS_LOG_LEAVE();
+    return file;
+  }
+
+  // The view keeps the mapping and file alive after the handles are closed.
+  HANDLE mh = ::CreateFileMappingW(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(fh);
+  if (!mh) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::error_code(::GetLastError(), std::system_category()),
+      path.string()));
+  }
+
+  void* ptr = ::MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+  ::CloseHandle(mh);
+  if (!ptr) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::error_code(::GetLastError(), std::system_category()),
+      path.string()));
+  }
+
+#elif PLATFORM_LINUX
+
+  int fd = ::open(filePath.string().c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::error_code(errno, std::system_category()), path.string()));
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    std::error_code const ec(errno, std::system_category());
+    ::close(fd);
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(ec, path.string()));
+  }
+
+  file.size = static_cast<std::size_t>(st.st_size);
+  if (file.size == 0) {
+    ::close(fd);
+    IRIS_LOG_LEAVE();
+    return file;
+  }
+
+  // The mapping keeps the file alive after the descriptor is closed.
+  void* ptr = ::mmap(nullptr, file.size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      std::error_code(errno, std::system_category()), path.string()));
+  }
+
+#endif
+
+  file.data = static_cast<std::byte const*>(ptr);
+  GetLogger()->debug("Mapped {} bytes from {}", file.size, filePath.string());
+
+  Ensures(file.data != nullptr);
+  IRIS_LOG_LEAVE();
+  return file;
+} // iris::Renderer::io::MapFile
+
+iris::Renderer::io::MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data(other.data)
+  , size(other.size) {
+  other.data = nullptr;
+  other.size = 0;
+} // iris::Renderer::io::MappedFile::MappedFile
+
+iris::Renderer::io::MappedFile& iris::Renderer::io::MappedFile::
+operator=(MappedFile&& rhs) noexcept {
+  if (this == &rhs) return *this;
+
+  // rhs takes our mapping and releases it when destroyed.
+  std::swap(data, rhs.data);
+  std::swap(size, rhs.size);
+
+  return *this;
+} // iris::Renderer::io::MappedFile::operator=
+
+iris::Renderer::io::MappedFile::~MappedFile() noexcept {
+  if (data == nullptr) return;
+  IRIS_LOG_ENTER();
+
+#if PLATFORM_WINDOWS
+  ::UnmapViewOfFile(data);
+#elif PLATFORM_LINUX
+  ::munmap(const_cast<std::byte*>(data), size);
+#endif
+  data = nullptr;
+
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::io::MappedFile::~MappedFile
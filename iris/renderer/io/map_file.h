@@ -0,0 +1,44 @@
+#ifndef HEV_IRIS_RENDERER_IO_MAP_FILE_H_
+#define HEV_IRIS_RENDERER_IO_MAP_FILE_H_
+/*! \file
+ * \brief \ref iris::Renderer::io::MappedFile declaration.
+ */
+
+#include "expected.hpp"
+#include <cstddef>
+#if STD_FS_IS_EXPERIMENTAL
+#include <experimental/filesystem>
+namespace filesystem = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace filesystem = std::filesystem;
+#endif
+#include <system_error>
+
+namespace iris::Renderer::io {
+
+/*! \brief A read-only memory mapping of an entire file.
+ *
+ * The mapping is shared, so multiple processes mapping the same file share
+ * the pages in the kernel page cache.
+ */
+struct MappedFile {
+  std::byte const* data{nullptr};
+  std::size_t size{0};
+
+  MappedFile() = default;
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&& rhs) noexcept;
+  ~MappedFile() noexcept;
+}; // struct MappedFile
+
+/*! \brief Blocking function to memory-map a file for reading.
+ */
+tl::expected<MappedFile, std::system_error>
+MapFile(filesystem::path const& path) noexcept;
+
+} // namespace iris::Renderer::io
+
+#endif // HEV_IRIS_RENDERER_IO_MAP_FILE_H_
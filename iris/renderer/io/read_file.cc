@@ -1,7 +1,15 @@
 #include "renderer/io/read_file.h"
 #include "config.h"
+#include "error.h"
+#include "fmt/format.h"
 #include "logging.h"
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
 
 tl::expected<std::vector<std::byte>, std::system_error>
 iris::Renderer::io::ReadFile(filesystem::path const& path) noexcept {
@@ -45,3 +53,116 @@ iris::Renderer::io::ReadFile(filesystem::path const& path) noexcept {
   return bytes;
 } // iris::Renderer::io::ReadFile
 
+filesystem::path
+iris::Renderer::io::TemporaryPath(filesystem::path const& path) noexcept {
+  // The random seed keeps other processes' names apart, the counter the
+  // names of this process's threads.
+  static std::uint64_t const sSeed = []() {
+    std::random_device device;
+    return (std::uint64_t{device()} << 32) | device();
+  }();
+  static std::atomic<std::uint64_t> sCounter{0};
+
+  filesystem::path tmpPath = path;
+  tmpPath += fmt::format(".{:016x}.{}.tmp", sSeed, sCounter++);
+  return tmpPath;
+} // iris::Renderer::io::TemporaryPath
+
+std::system_error
+iris::Renderer::io::WriteFile(filesystem::path const& path,
+                              gsl::span<std::byte const> bytes) noexcept {
+  IRIS_LOG_ENTER();
+
+  filesystem::path const tmpPath = TemporaryPath(path);
+
+  {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{
+      std::fopen(tmpPath.string().c_str(), "wb"), std::fclose};
+
+    if (!fh) {
+      IRIS_LOG_LEAVE();
+      return {std::make_error_code(std::errc::permission_denied),
+              tmpPath.string()};
+    }
+
+    GetLogger()->debug("Writing {} bytes to {}", bytes.size(), path.string());
+    std::size_t nWritten = std::fwrite(bytes.data(), sizeof(std::byte),
+                                       bytes.size(), fh.get());
+
+    if (std::ferror(fh.get()) ||
+        nWritten != static_cast<std::size_t>(bytes.size())) {
+      fh.reset();
+      std::error_code ec;
+      filesystem::remove(tmpPath, ec);
+      IRIS_LOG_LEAVE();
+      return {std::make_error_code(std::errc::io_error), tmpPath.string()};
+    }
+  }
+
+  std::error_code ec;
+  filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    filesystem::remove(tmpPath, ec);
+    IRIS_LOG_LEAVE();
+    return {ec, path.string()};
+  }
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::io::WriteFile
+
+filesystem::path iris::Renderer::io::CacheDirectory() noexcept {
+  IRIS_LOG_ENTER();
+
+  filesystem::path dir;
+  std::error_code ec;
+
+  if (char const* env = std::getenv("IRIS_CACHE_DIR")) {
+    dir = env;
+  } else {
+#if PLATFORM_WINDOWS
+    if (char const* local = std::getenv("LOCALAPPDATA")) {
+      dir = filesystem::path(local) / "iris";
+    }
+#elif PLATFORM_LINUX
+    if (char const* xdg = std::getenv("XDG_CACHE_HOME")) {
+      dir = filesystem::path(xdg) / "iris";
+    } else if (char const* home = std::getenv("HOME")) {
+      dir = filesystem::path(home) / ".cache" / "iris";
+    }
+#endif
+    if (dir.empty()) dir = filesystem::temp_directory_path(ec) / "iris";
+  }
+
+  filesystem::create_directories(dir, ec);
+  if (ec) {
+    GetLogger()->warn("Cannot create cache directory {}: {}", dir.string(),
+                      ec.message());
+  }
+
+  IRIS_LOG_LEAVE();
+  return dir;
+} // iris::Renderer::io::CacheDirectory
+
+filesystem::path
+iris::Renderer::io::CacheDirectory(filesystem::path const& name) noexcept {
+  filesystem::path dir = CacheDirectory() / name;
+  std::error_code ec;
+
+  filesystem::create_directories(dir, ec);
+  if (ec) {
+    GetLogger()->warn("Cannot create cache directory {}: {}", dir.string(),
+                      ec.message());
+  }
+
+  return dir;
+} // iris::Renderer::io::CacheDirectory
+
+std::uint64_t iris::Renderer::io::HashBytes(gsl::span<std::byte const> bytes,
+                                            std::uint64_t hash) noexcept {
+  for (std::byte const byte : bytes) {
+    hash ^= static_cast<std::uint64_t>(byte);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+} // iris::Renderer::io::HashBytes
@@ -5,7 +5,9 @@
  */
 
 #include "expected.hpp"
+#include "gsl/gsl"
 #include <cstddef>
+#include <cstdint>
 #if STD_FS_IS_EXPERIMENTAL
 #include <experimental/filesystem>
 namespace filesystem = std::experimental::filesystem;
@@ -23,6 +25,41 @@ namespace iris::Renderer::io {
 tl::expected<std::vector<std::byte>, std::system_error>
 ReadFile(filesystem::path const& path) noexcept;
 
+/*! \brief Blocking function to directly write a file.
+ *
+ * The bytes are written to a temporary file that is then renamed over
+ * \p path, so concurrent readers never see a partially written file.
+ */
+std::system_error WriteFile(filesystem::path const& path,
+                            gsl::span<std::byte const> bytes) noexcept;
+
+/*! \brief A unique path next to \p path for writing a file that is then
+ * renamed over \p path.
+ *
+ * The name has a random suffix, so concurrent writers of \p path, in this
+ * process or others, never write to the same temporary file.
+ */
+filesystem::path TemporaryPath(filesystem::path const& path) noexcept;
+
+/*! \brief The directory for persistent caches, created if necessary.
+ *
+ * This is \c IRIS_CACHE_DIR if set in the environment, otherwise the
+ * platform per-user cache directory.
+ */
+filesystem::path CacheDirectory() noexcept;
+
+/*! \brief The subdirectory \p name of CacheDirectory() that one kind of
+ * cache keeps its entries in, created if necessary.
+ */
+filesystem::path CacheDirectory(filesystem::path const& name) noexcept;
+
+/*! \brief The 64-bit FNV-1a hash of \p bytes. Unlike absl::Hash it is
+ * stable across runs and platforms, which on-disk cache keys require.
+ * Passing the hash of other bytes as \p hash combines them.
+ */
+std::uint64_t HashBytes(gsl::span<std::byte const> bytes,
+                        std::uint64_t hash = 0xcbf29ce484222325ULL) noexcept;
+
 } // namespace iris::Renderer::io
 
 #endif // HEV_IRIS_RENDERER_IO_H_
@@ -0,0 +1,545 @@
+#include "renderer/io/scene_cache.h"
+#include "config.h"
+#include "error.h"
+#include "fmt/format.h"
+#include "logging.h"
+#include "renderer/io/map_file.h"
+#include "renderer/io/read_file.h"
+#include "stb_image.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace iris::Renderer::io {
+
+//! "IRISSCN\0"; the first eight bytes of every entry.
+static constexpr std::uint64_t kSceneCacheMagic = 0x004E435353495249ULL;
+
+//! Increment when the entry layout or the processing of loaded SceneData
+//! changes, so older entries are no longer used.
+static constexpr std::uint32_t kSceneCacheVersion = 3;
+
+//! Every field starts at a multiple of this so arrays can be read in place.
+static constexpr std::size_t kSceneCacheAlignment = 8;
+
+/*! \brief Appends to a cache entry being written to a file, padding every
+ * field to kSceneCacheAlignment. Errors are sticky and checked once at the
+ * end.
+ */
+struct CacheWriter {
+  std::FILE* fh{nullptr};
+  std::uint64_t size{0};
+  bool failed{false};
+}; // struct CacheWriter
+
+static void Write(CacheWriter& writer, void const* data,
+                  std::size_t size) noexcept {
+  static std::array<std::byte, kSceneCacheAlignment> const kPadding{};
+  std::size_t const padding =
+    (kSceneCacheAlignment - size % kSceneCacheAlignment) %
+    kSceneCacheAlignment;
+
+  if (size > 0 && std::fwrite(data, 1, size, writer.fh) != size) {
+    writer.failed = true;
+  }
+  if (padding > 0 &&
+      std::fwrite(kPadding.data(), 1, padding, writer.fh) != padding) {
+    writer.failed = true;
+  }
+  writer.size += size + padding;
+} // Write
+
+template <class T>
+static void WriteValue(CacheWriter& writer, T const& value) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  Write(writer, &value, sizeof(T));
+} // WriteValue
+
+template <class T>
+static void WriteArray(CacheWriter& writer,
+                       gsl::span<T const> values) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  WriteValue(writer, static_cast<std::uint64_t>(values.size()));
+  Write(writer, values.data(), values.size() * sizeof(T));
+} // WriteArray
+
+static void WriteString(CacheWriter& writer, std::string const& str) noexcept {
+  WriteArray(writer, gsl::span<char const>(str.data(), str.size()));
+} // WriteString
+
+//! \brief Reads fields written by a CacheWriter out of a mapped entry.
+struct CacheReader {
+  std::byte const* data{nullptr};
+  std::size_t size{0};
+  std::size_t offset{0};
+}; // struct CacheReader
+
+//! \brief The next \p size bytes of \p reader where they are in the
+//! mapping, or nullptr if the entry is truncated.
+[[nodiscard]] static std::byte const* Take(CacheReader& reader,
+                                           std::size_t size) noexcept {
+  std::size_t const padded =
+    (size + kSceneCacheAlignment - 1) / kSceneCacheAlignment *
+    kSceneCacheAlignment;
+  if (padded < size || padded > reader.size - reader.offset) return nullptr;
+
+  std::byte const* data = reader.data + reader.offset;
+  reader.offset += padded;
+  return data;
+} // Take
+
+[[nodiscard]] static bool Read(CacheReader& reader, void* data,
+                               std::size_t size) noexcept {
+  std::byte const* src = Take(reader, size);
+  if (!src) return false;
+  if (size > 0) std::memcpy(data, src, size);
+  return true;
+} // Read
+
+template <class T>
+[[nodiscard]] static bool ReadValue(CacheReader& reader, T& value) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return Read(reader, &value, sizeof(T));
+} // ReadValue
+
+template <class T, class Container>
+[[nodiscard]] static bool ReadArray(CacheReader& reader,
+                                    Container& values) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  std::uint64_t count;
+  if (!ReadValue(reader, count)) return false;
+
+  // Check the size before resizing so a corrupt count cannot allocate.
+  if (count > (reader.size - reader.offset) / sizeof(T)) return false;
+  values.resize(count);
+  return Read(reader, values.data(), count * sizeof(T));
+} // ReadArray
+
+/*! \brief Point \p values at an array written by WriteArray where it is in
+ * the mapping. Fields start at multiples of kSceneCacheAlignment in a
+ * page-aligned mapping, so the elements are suitably aligned.
+ */
+template <class T>
+[[nodiscard]] static bool ReadSpan(CacheReader& reader,
+                                   gsl::span<T const>& values) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(alignof(T) <= kSceneCacheAlignment);
+  std::uint64_t count;
+  if (!ReadValue(reader, count)) return false;
+
+  if (count > (reader.size - reader.offset) / sizeof(T)) return false;
+  std::byte const* data = Take(reader, count * sizeof(T));
+  if (!data) return false;
+
+  values = {reinterpret_cast<T const*>(data),
+            static_cast<std::ptrdiff_t>(count)};
+  return true;
+} // ReadSpan
+
+/*! \brief The modification time and size of a file an entry depends on, or
+ * zeros if it does not exist.
+ */
+struct FileStamp {
+  std::int64_t modified{0};
+  std::uint64_t size{0};
+}; // struct FileStamp
+
+static FileStamp Stamp(filesystem::path const& path) noexcept {
+  std::error_code ec;
+  FileStamp stamp;
+
+  auto const modified = filesystem::last_write_time(path, ec);
+  if (ec) return {};
+  stamp.modified = static_cast<std::int64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      modified.time_since_epoch())
+      .count());
+
+  stamp.size = static_cast<std::uint64_t>(filesystem::file_size(path, ec));
+  if (ec) return {};
+
+  return stamp;
+} // Stamp
+
+//! \brief \p path as ReadFile and MapFile find it: either as given or in
+//! kIRISContentDirectory.
+static filesystem::path Resolve(filesystem::path const& path) noexcept {
+  std::error_code ec;
+  if (filesystem::exists(path, ec)) return filesystem::absolute(path, ec);
+  return filesystem::absolute(kIRISContentDirectory / path, ec);
+} // Resolve
+
+static filesystem::path SceneCachePath(filesystem::path const& path) noexcept {
+  static filesystem::path const sCacheDirectory = CacheDirectory("scenes");
+  std::string const source = path.string();
+  return sCacheDirectory /
+         fmt::format("{:016x}.scene",
+                     HashBytes(gsl::as_bytes(
+                       gsl::make_span(source.data(), source.size()))));
+} // SceneCachePath
+
+//! \brief Whether every index in \p indices refers to one of
+//! \p numVertices vertices.
+[[nodiscard]] static bool
+IndicesInRange(gsl::span<unsigned int const> indices,
+               std::size_t numVertices) noexcept {
+  return std::all_of(indices.begin(), indices.end(),
+                     [numVertices](unsigned int index) {
+                       return index < numVertices;
+                     });
+} // IndicesInRange
+
+/*! \brief Read a MeshData written by WriteMeshData. Parsing validates what
+ * it reads from the source file, so the streams and topology of an entry
+ * are checked here just as strictly before they reach staging memory; the
+ * material is checked once the materials have been read.
+ */
+[[nodiscard]] static bool ReadMeshData(CacheReader& reader,
+                                       MeshDataView& meshData) noexcept {
+  std::uint32_t topology, hasTexCoords;
+  std::uint64_t numLevels;
+
+  if (!ReadArray<char>(reader, meshData.name) ||
+      !ReadValue(reader, meshData.material) ||
+      !ReadValue(reader, meshData.matrix) ||
+      !ReadSpan(reader, meshData.instanceMatrices) ||
+      !ReadSpan(reader, meshData.vertices) ||
+      !ReadSpan(reader, meshData.indices) ||
+      !ReadValue(reader, meshData.boundsMin) ||
+      !ReadValue(reader, meshData.boundsMax) ||
+      !ReadValue(reader, topology) || !ReadValue(reader, hasTexCoords) ||
+      !ReadValue(reader, numLevels) ||
+      numLevels > MeshData::kMaxLevelsOfDetail ||
+      topology >
+        static_cast<std::uint32_t>(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN)) {
+    return false;
+  }
+
+  std::size_t const numVertices =
+    static_cast<std::size_t>(meshData.vertices.size());
+  if (!IndicesInRange(meshData.indices, numVertices)) return false;
+
+  meshData.topology = static_cast<VkPrimitiveTopology>(topology);
+  meshData.hasTexCoords = (hasTexCoords != 0);
+
+  meshData.levelsOfDetail.resize(numLevels);
+  for (auto&& level : meshData.levelsOfDetail) {
+    if (!ReadValue(reader, level.error) ||
+        !ReadSpan(reader, level.indices) ||
+        !IndicesInRange(level.indices, numVertices)) {
+      return false;
+    }
+  }
+
+  return true;
+} // ReadMeshData
+
+static void WriteMeshData(CacheWriter& writer,
+                          MeshData const& meshData) noexcept {
+  WriteString(writer, meshData.name);
+  WriteValue(writer, meshData.material);
+  WriteValue(writer, meshData.matrix);
+  WriteArray<glm::mat4x4>(writer, meshData.instanceMatrices);
+  WriteArray<MeshData::Vertex>(writer, meshData.vertices);
+  WriteArray<unsigned int>(writer, meshData.indices);
+  WriteValue(writer, meshData.boundsMin);
+  WriteValue(writer, meshData.boundsMax);
+  WriteValue(writer, static_cast<std::uint32_t>(meshData.topology));
+  WriteValue(writer, static_cast<std::uint32_t>(meshData.hasTexCoords));
+
+  WriteValue(writer,
+             static_cast<std::uint64_t>(meshData.levelsOfDetail.size()));
+  for (auto&& level : meshData.levelsOfDetail) {
+    WriteValue(writer, level.error);
+    WriteArray<unsigned int>(writer, level.indices);
+  }
+} // WriteMeshData
+
+/*! \brief Read the name of an image and point \p encoded at its encoded
+ * file in the mapping; DecodeImage turns it into pixels.
+ */
+[[nodiscard]] static bool
+ReadImageData(CacheReader& reader, ImageData& imageData,
+              gsl::span<std::byte const>& encoded) noexcept {
+  return ReadArray<char>(reader, imageData.name) &&
+         ReadSpan(reader, encoded) && !encoded.empty() &&
+         encoded.size() <= std::numeric_limits<int>::max();
+} // ReadImageData
+
+//! \brief Decode \p encoded into the RGBA8 pixels of \p imageData.
+[[nodiscard]] static bool DecodeImage(gsl::span<std::byte const> encoded,
+                                      ImageData& imageData) noexcept {
+  int x, y, n;
+  stbi_uc* pixels = stbi_load_from_memory(
+    reinterpret_cast<stbi_uc const*>(encoded.data()),
+    static_cast<int>(encoded.size()), &x, &y, &n, 4);
+  if (!pixels) return false;
+
+  // The pixels stay in stb_image's allocation.
+  imageData.pixels.reset(reinterpret_cast<std::byte*>(pixels),
+                         stbi_image_free);
+  imageData.extent = {static_cast<std::uint32_t>(x),
+                      static_cast<std::uint32_t>(y), 1};
+  return true;
+} // DecodeImage
+
+/*! \brief Store the encoded file of an image rather than its pixels: a 4K
+ * texture is 64 MiB of RGBA8 but usually a few MiB encoded.
+ */
+static void WriteImageData(CacheWriter& writer,
+                           ImageData const& imageData) noexcept {
+  if (!imageData.encoded || imageData.encodedSize == 0) {
+    writer.failed = true;
+    return;
+  }
+
+  WriteString(writer, imageData.name);
+  WriteArray<std::byte>(
+    writer, gsl::span<std::byte const>(imageData.encoded.get(),
+                                       imageData.encodedSize));
+} // WriteImageData
+
+} // namespace iris::Renderer::io
+
+tl::expected<iris::Renderer::SceneDataView, std::system_error>
+iris::Renderer::io::ReadSceneCache(filesystem::path const& path,
+                                   std::uint64_t contentHash) noexcept {
+  IRIS_LOG_ENTER();
+  auto const start = std::chrono::steady_clock::now();
+
+  filesystem::path const source = Resolve(path);
+  filesystem::path const cachePath = SceneCachePath(source);
+
+  std::error_code ec;
+  if (!filesystem::exists(cachePath, ec)) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(
+      Error::kFileLoadFailed, "no scene cache entry for " + source.string()));
+  }
+
+  // The returned view points into the mapping and keeps it alive.
+  std::shared_ptr<MappedFile> file;
+  if (auto f = MapFile(cachePath)) {
+    file = std::make_shared<MappedFile>(std::move(*f));
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(f.error());
+  }
+
+  CacheReader reader{file->data, file->size, 0};
+  auto const stale = [&cachePath](char const* reason) {
+    return tl::unexpected(std::system_error(
+      Error::kFileLoadFailed,
+      fmt::format("{} scene cache entry {}", reason, cachePath.string())));
+  };
+
+  std::uint64_t magic, hash;
+  std::uint32_t version, pad0;
+  std::string entrySource;
+
+  if (!ReadValue(reader, magic) || !ReadValue(reader, version) ||
+      !ReadValue(reader, pad0) || !ReadValue(reader, hash) ||
+      !ReadArray<char>(reader, entrySource)) {
+    IRIS_LOG_LEAVE();
+    return stale("Truncated");
+  }
+
+  if (magic != kSceneCacheMagic || version != kSceneCacheVersion) {
+    IRIS_LOG_LEAVE();
+    return stale("Outdated");
+  }
+
+  // The file name is only a hash of the path, so check it was this path.
+  if (entrySource != source.string() || hash != contentHash) {
+    IRIS_LOG_LEAVE();
+    return stale("Stale");
+  }
+
+  std::uint64_t numDependencies;
+  if (!ReadValue(reader, numDependencies)) {
+    IRIS_LOG_LEAVE();
+    return stale("Truncated");
+  }
+
+  for (std::uint64_t i = 0; i < numDependencies; ++i) {
+    std::string dependency;
+    FileStamp stamp;
+    if (!ReadArray<char>(reader, dependency) || !ReadValue(reader, stamp)) {
+      IRIS_LOG_LEAVE();
+      return stale("Truncated");
+    }
+
+    FileStamp const current = Stamp(dependency);
+    if (current.modified != stamp.modified || current.size != stamp.size) {
+      IRIS_LOG_LEAVE();
+      return stale("Stale");
+    }
+  }
+
+  std::uint64_t numMeshes;
+  if (!ReadValue(reader, numMeshes) ||
+      numMeshes > (reader.size - reader.offset)) {
+    IRIS_LOG_LEAVE();
+    return stale("Truncated");
+  }
+
+  SceneDataView sceneData;
+  sceneData.meshes.resize(numMeshes);
+  for (auto&& data : sceneData.meshes) {
+    if (!ReadMeshData(reader, data)) {
+      IRIS_LOG_LEAVE();
+      return stale("Truncated or corrupt");
+    }
+  }
+
+  std::uint64_t numImages;
+  if (!ReadSpan(reader, sceneData.materials) ||
+      !ReadSpan(reader, sceneData.textures) ||
+      !ReadValue(reader, numImages) ||
+      numImages > (reader.size - reader.offset)) {
+    IRIS_LOG_LEAVE();
+    return stale("Truncated");
+  }
+
+  // Every index into the tables must be in range, as parsing makes sure.
+  auto const inTable = [](std::int32_t index, auto numEntries) {
+    return index >= -1 &&
+           (index < 0 || static_cast<std::uint64_t>(index) <
+                           static_cast<std::uint64_t>(numEntries));
+  };
+
+  bool valid = true;
+  for (auto&& data : sceneData.meshes) {
+    valid = valid && inTable(data.material, sceneData.materials.size());
+  }
+  for (auto&& material : sceneData.materials) {
+    for (auto&& texture : material.textures) {
+      valid = valid && inTable(texture, sceneData.textures.size());
+    }
+  }
+  for (auto&& texture : sceneData.textures) {
+    valid = valid && inTable(texture.image, numImages);
+  }
+
+  if (!valid) {
+    IRIS_LOG_LEAVE();
+    return stale("Corrupt");
+  }
+
+  sceneData.images.resize(numImages);
+  std::vector<gsl::span<std::byte const>> encoded(numImages);
+  for (std::size_t i = 0; i < numImages; ++i) {
+    if (!ReadImageData(reader, sceneData.images[i], encoded[i])) {
+      IRIS_LOG_LEAVE();
+      return stale("Truncated");
+    }
+  }
+
+  std::vector<std::uint8_t> decoded(numImages, 0);
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, numImages),
+                    [&](tbb::blocked_range<std::size_t> const& range) {
+                      for (std::size_t i = range.begin(); i != range.end();
+                           ++i) {
+                        decoded[i] = DecodeImage(encoded[i],
+                                                 sceneData.images[i]);
+                      }
+                    });
+
+  if (std::find(decoded.begin(), decoded.end(), 0) != decoded.end()) {
+    IRIS_LOG_LEAVE();
+    return stale("Undecodable image in");
+  }
+
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+  GetLogger()->info(
+    "Read {} primitives, {} materials and {} images for {} from scene cache "
+    "{} ({} bytes) in {:.3f} ms",
+    sceneData.meshes.size(), sceneData.materials.size(),
+    sceneData.images.size(), source.string(), cachePath.string(), file->size,
+    Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+  sceneData.storage = std::move(file);
+  IRIS_LOG_LEAVE();
+  return sceneData;
+} // iris::Renderer::io::ReadSceneCache
+
+std::system_error iris::Renderer::io::WriteSceneCache(
+  filesystem::path const& path, std::uint64_t contentHash,
+  gsl::span<filesystem::path const> dependencies,
+  SceneData const& sceneData) noexcept {
+  IRIS_LOG_ENTER();
+
+  filesystem::path const source = Resolve(path);
+  filesystem::path const cachePath = SceneCachePath(source);
+
+  // Entries can be larger than the scene itself, so they are streamed to a
+  // temporary file rather than built in memory and passed to WriteFile.
+  filesystem::path const tmpPath = TemporaryPath(cachePath);
+
+  {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> fh{
+      std::fopen(tmpPath.string().c_str(), "wb"), std::fclose};
+
+    if (!fh) {
+      IRIS_LOG_LEAVE();
+      return {std::make_error_code(std::errc::permission_denied),
+              tmpPath.string()};
+    }
+
+    CacheWriter writer{fh.get(), 0, false};
+    WriteValue(writer, kSceneCacheMagic);
+    WriteValue(writer, kSceneCacheVersion);
+    WriteValue(writer, std::uint32_t{0});
+    WriteValue(writer, contentHash);
+    WriteString(writer, source.string());
+
+    WriteValue(writer,
+               static_cast<std::uint64_t>(dependencies.size() + 1));
+    WriteString(writer, source.string());
+    WriteValue(writer, Stamp(source));
+    for (auto&& dependency : dependencies) {
+      filesystem::path const resolved = Resolve(dependency);
+      WriteString(writer, resolved.string());
+      WriteValue(writer, Stamp(resolved));
+    }
+
+    WriteValue(writer, static_cast<std::uint64_t>(sceneData.meshes.size()));
+    for (auto&& data : sceneData.meshes) WriteMeshData(writer, data);
+
+    WriteArray<MaterialData>(writer, sceneData.materials);
+    WriteArray<TextureData>(writer, sceneData.textures);
+    WriteValue(writer, static_cast<std::uint64_t>(sceneData.images.size()));
+    for (auto&& data : sceneData.images) WriteImageData(writer, data);
+
+    if (writer.failed) {
+      fh.reset();
+      std::error_code ec;
+      filesystem::remove(tmpPath, ec);
+      IRIS_LOG_LEAVE();
+      return {std::make_error_code(std::errc::io_error), tmpPath.string()};
+    }
+
+    GetLogger()->debug("Wrote {} bytes to scene cache {}", writer.size,
+                       cachePath.string());
+  }
+
+  std::error_code ec;
+  filesystem::rename(tmpPath, cachePath, ec);
+  if (ec) {
+    filesystem::remove(tmpPath, ec);
+    IRIS_LOG_LEAVE();
+    return {ec, cachePath.string()};
+  }
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::io::WriteSceneCache
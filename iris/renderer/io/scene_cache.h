@@ -0,0 +1,55 @@
+#ifndef HEV_IRIS_RENDERER_IO_SCENE_CACHE_H_
+#define HEV_IRIS_RENDERER_IO_SCENE_CACHE_H_
+/*! \file
+ * \brief A binary cache of the SceneData loaded from scene files.
+ *
+ * Loading a glTF file parses its JSON, decodes every accessor and image,
+ * generates normals, tangents and levels of detail and reorders every
+ * primitive. A cache entry holds the result: the final vertex and index
+ * streams, transforms and bounds of every MeshData, the material and texture
+ * tables and the encoded file of every image. Reading an entry maps it and
+ * returns views of the streams and tables in place, so they are copied only
+ * into staging memory, and decodes the images straight out of the mapping.
+ * Entries live in CacheDirectory()/scenes, one per source path, and are only
+ * used while the content hash of the source and the modification time and
+ * size of every file it was loaded from still match.
+ */
+
+#include "expected.hpp"
+#include "gsl/gsl"
+#include "renderer/mesh.h"
+#include <cstddef>
+#include <cstdint>
+#if STD_FS_IS_EXPERIMENTAL
+#include <experimental/filesystem>
+namespace filesystem = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace filesystem = std::filesystem;
+#endif
+#include <system_error>
+#include <vector>
+
+namespace iris::Renderer::io {
+
+/*! \brief Read the cached SceneData of \p path if the entry was written for
+ * \p contentHash and none of its files changed since.
+ * \return a view of the SceneData in the mapped entry, which its storage
+ * keeps mapped, or Error::kFileLoadFailed if there is no usable entry.
+ */
+tl::expected<SceneDataView, std::system_error>
+ReadSceneCache(filesystem::path const& path,
+               std::uint64_t contentHash) noexcept;
+
+/*! \brief Write \p sceneData as the cache entry of \p path, recording
+ * \p contentHash and the modification time and size of \p path and every
+ * file in \p dependencies. Fails if an image has no encoded file.
+ */
+std::system_error
+WriteSceneCache(filesystem::path const& path, std::uint64_t contentHash,
+                gsl::span<filesystem::path const> dependencies,
+                SceneData const& sceneData) noexcept;
+
+} // namespace iris::Renderer::io
+
+#endif // HEV_IRIS_RENDERER_IO_SCENE_CACHE_H_
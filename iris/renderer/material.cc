@@ -0,0 +1,207 @@
+#include "renderer/material.h"
+#include "error.h"
+#include "fmt/format.h"
+#include "logging.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+
+std::vector<std::string>
+iris::Renderer::Material::ShaderMacros() const {
+  std::vector<std::string> macros;
+  if (HasMap(MaterialMap::kBaseColor)) {
+    macros.push_back("-DHAS_BASECOLOR_MAP");
+  }
+  if (HasMap(MaterialMap::kNormal)) macros.push_back("-DHAS_NORMAL_MAP");
+  if (HasMap(MaterialMap::kEmissive)) macros.push_back("-DHAS_EMISSIVE_MAP");
+  if (HasMap(MaterialMap::kMetallicRoughness)) {
+    macros.push_back("-DHAS_METALLICROUGHNESS_MAP");
+  }
+  if (HasMap(MaterialMap::kOcclusion)) {
+    macros.push_back("-DHAS_OCCLUSION_MAP");
+  }
+  return macros;
+} // iris::Renderer::Material::ShaderMacros
+
+static_assert(sizeof(iris::Renderer::Material::BufferData) == 48,
+              "BufferData must match the std140 layout of MaterialBuffer");
+
+tl::expected<std::vector<std::shared_ptr<iris::Renderer::Material const>>,
+             std::system_error>
+iris::Renderer::CreateMaterials(gsl::span<MaterialData const> materials,
+                                gsl::span<TextureData const> textures,
+                                gsl::span<ImageData const> images,
+                                std::string const& name) noexcept {
+  IRIS_LOG_ENTER();
+
+  // Textures are shared by image and color space: base color and emissive
+  // maps hold sRGB colors the sampler converts to linear, the other maps
+  // hold linear data.
+  std::map<std::pair<std::int32_t, bool>, std::shared_ptr<Texture const>>
+    gpuTextures;
+  // Samplers are shared by their parameters.
+  std::map<std::tuple<VkFilter, VkFilter, VkSamplerMipmapMode,
+                      VkSamplerAddressMode, VkSamplerAddressMode, VkBool32>,
+           std::shared_ptr<Sampler const>>
+    gpuSamplers;
+
+  auto const getTexture = [&](std::int32_t index, bool srgb)
+    -> tl::expected<std::shared_ptr<Texture const>, std::system_error> {
+    if (auto iter = gpuTextures.find({index, srgb});
+        iter != gpuTextures.end()) {
+      return iter->second;
+    }
+
+    auto&& imageData = images[index];
+    std::string const textureName =
+      fmt::format("{}:{}{}", name, imageData.name, srgb ? ":srgb" : "");
+
+    // A full chain down to 1x1; R8G8B8A8 formats support linear blits on
+    // every device.
+    std::uint32_t mipLevels = 1;
+    for (std::uint32_t size =
+           std::max(imageData.extent.width, imageData.extent.height);
+         size > 1; size >>= 1) {
+      mipLevels++;
+    }
+
+    auto texture = std::make_shared<Texture>();
+
+    if (auto image = Image::CreateFromMemory(
+          VK_IMAGE_TYPE_2D,
+          srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM,
+          imageData.extent, VK_IMAGE_USAGE_SAMPLED_BIT,
+          VMA_MEMORY_USAGE_GPU_ONLY, gsl::not_null(imageData.pixels.get()), 4,
+          textureName + ":image", mipLevels)) {
+      texture->image = std::move(*image);
+    } else {
+      return tl::unexpected(image.error());
+    }
+
+    if (auto view = texture->image.CreateImageView(
+          VK_IMAGE_VIEW_TYPE_2D,
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1},
+          textureName + ":view")) {
+      texture->view = std::move(*view);
+    } else {
+      return tl::unexpected(view.error());
+    }
+
+    return gpuTextures.emplace(std::make_pair(index, srgb), std::move(texture))
+      .first->second;
+  };
+
+  auto const getSampler = [&](TextureData const& texture)
+    -> tl::expected<std::shared_ptr<Sampler const>, std::system_error> {
+    auto const key =
+      std::make_tuple(texture.magFilter, texture.minFilter, texture.mipmapMode,
+                      texture.addressModeU, texture.addressModeV,
+                      texture.mipmapped);
+    if (auto iter = gpuSamplers.find(key); iter != gpuSamplers.end()) {
+      return iter->second;
+    }
+
+    VkSamplerCreateInfo samplerCI = {};
+    samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerCI.magFilter = texture.magFilter;
+    samplerCI.minFilter = texture.minFilter;
+    samplerCI.mipmapMode = texture.mipmapMode;
+    samplerCI.addressModeU = texture.addressModeU;
+    samplerCI.addressModeV = texture.addressModeV;
+    samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCI.mipLodBias = 0.f;
+    samplerCI.anisotropyEnable = VK_FALSE;
+    samplerCI.maxAnisotropy = 1.f;
+    samplerCI.compareEnable = VK_FALSE;
+    samplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerCI.minLod = 0.f;
+    // Clamping to 0.25 selects the first level while still telling
+    // magnification from minification.
+    samplerCI.maxLod = texture.mipmapped ? VK_LOD_CLAMP_NONE : 0.25f;
+    samplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerCI.unnormalizedCoordinates = VK_FALSE;
+
+    if (auto s = Sampler::Create(
+          samplerCI, fmt::format("{}:sampler{}", name, gpuSamplers.size()))) {
+      return gpuSamplers
+        .emplace(key, std::make_shared<Sampler>(std::move(*s)))
+        .first->second;
+    } else {
+      return tl::unexpected(s.error());
+    }
+  };
+
+  std::vector<std::shared_ptr<Material const>> gpuMaterials;
+  gpuMaterials.reserve(materials.size());
+
+  for (std::size_t i = 0; i < static_cast<std::size_t>(materials.size());
+       ++i) {
+    auto&& data = materials[i];
+    auto material = std::make_shared<Material>();
+    material->doubleSided = (data.doubleSided == VK_TRUE);
+
+    for (std::size_t map = 0; map < kNumMaterialMaps; ++map) {
+      std::int32_t const index = data.textures[map];
+      if (index < 0) continue;
+
+      if (static_cast<std::size_t>(textures.size()) <=
+            static_cast<std::size_t>(index) ||
+          textures[index].image < 0 ||
+          static_cast<std::size_t>(images.size()) <=
+            static_cast<std::size_t>(textures[index].image)) {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(std::system_error(
+          Error::kFileParseFailed,
+          fmt::format("material {} references an invalid texture", i)));
+      }
+
+      auto&& texture = textures[index];
+      bool const srgb =
+        (map == static_cast<std::size_t>(MaterialMap::kBaseColor) ||
+         map == static_cast<std::size_t>(MaterialMap::kEmissive));
+
+      if (auto t = getTexture(texture.image, srgb)) {
+        material->textures[map] = std::move(*t);
+      } else {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(t.error());
+      }
+
+      if (auto s = getSampler(texture)) {
+        material->samplers[map] = std::move(*s);
+      } else {
+        IRIS_LOG_LEAVE();
+        return tl::unexpected(s.error());
+      }
+    }
+
+    Material::BufferData bufferData;
+    bufferData.baseColorFactor = data.baseColorFactor;
+    bufferData.emissiveFactor = data.emissiveFactor;
+    bufferData.normalScale = data.normalScale;
+    bufferData.metallicRoughnessValues =
+      glm::vec2(data.metallicFactor, data.roughnessFactor);
+    bufferData.occlusionStrength = data.occlusionStrength;
+    bufferData.pad0 = 0.f;
+
+    if (auto b = Buffer::CreateFromMemory(
+          sizeof(Material::BufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+          VMA_MEMORY_USAGE_GPU_ONLY, &bufferData,
+          fmt::format("{}:material{}", name, i))) {
+      material->buffer = std::move(*b);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(b.error());
+    }
+
+    gpuMaterials.push_back(std::move(material));
+  }
+
+  GetLogger()->debug(
+    "Created {} materials of {} sharing {} textures and {} samplers",
+    gpuMaterials.size(), name, gpuTextures.size(), gpuSamplers.size());
+
+  IRIS_LOG_LEAVE();
+  return gpuMaterials;
+} // iris::Renderer::CreateMaterials
@@ -0,0 +1,138 @@
+#ifndef HEV_IRIS_RENDERER_MATERIAL_H_
+#define HEV_IRIS_RENDERER_MATERIAL_H_
+/*! \file
+ * \brief Metallic-roughness materials and the textures they sample.
+ *
+ * Scene files are loaded into MaterialData, TextureData and ImageData, which
+ * refer to each other by index. CreateMaterials turns a scene's tables into
+ * GPU Materials: each holds the uniform buffer of its factors and the
+ * Texture and Sampler of each of its maps. Textures are created once per
+ * image and color space and samplers once per set of parameters, so
+ * materials that share them share the GPU objects. Every texture gets a full
+ * mip chain generated on the GPU while it is uploaded.
+ */
+
+#include "glm/glm.hpp"
+#include "renderer/buffer.h"
+#include "renderer/image.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace iris::Renderer {
+
+//! \brief The maps of a material, in the order of their shader bindings.
+enum class MaterialMap {
+  kBaseColor = 0,
+  kNormal = 1,
+  kEmissive = 2,
+  kMetallicRoughness = 3,
+  kOcclusion = 4,
+};
+
+static constexpr std::size_t const kNumMaterialMaps = 5;
+
+//! \brief The decoded pixels of an image that textures sample.
+struct ImageData {
+  std::string name{};
+  VkExtent3D extent{0, 0, 1};
+  //! RGBA8 pixels, extent.width * extent.height * 4 bytes. Shared so scene
+  //! data can be copied without copying them.
+  std::shared_ptr<std::byte> pixels{};
+  //! The encoded image file the pixels were decoded from, encodedSize bytes,
+  //! kept so the scene cache can store it instead of the pixels; null once
+  //! the cache no longer needs it.
+  std::shared_ptr<std::byte const> encoded{};
+  std::size_t encodedSize{0};
+}; // struct ImageData
+
+//! \brief An image and how it is sampled. Trivially copyable.
+struct TextureData {
+  //! Index into the images of the scene.
+  std::int32_t image{-1};
+  VkFilter magFilter{VK_FILTER_LINEAR};
+  VkFilter minFilter{VK_FILTER_LINEAR};
+  VkSamplerMipmapMode mipmapMode{VK_SAMPLER_MIPMAP_MODE_LINEAR};
+  VkSamplerAddressMode addressModeU{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+  VkSamplerAddressMode addressModeV{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+  //! Whether minification reads the mip chain or only the first level.
+  VkBool32 mipmapped{VK_TRUE};
+}; // struct TextureData
+
+/*! \brief The factors and maps of a metallic-roughness material, with the
+ * defaults of a glTF material that specifies none. Trivially copyable.
+ */
+struct MaterialData {
+  glm::vec4 baseColorFactor{1.f, 1.f, 1.f, 1.f};
+  glm::vec3 emissiveFactor{0.f, 0.f, 0.f};
+  float metallicFactor{1.f};
+  float roughnessFactor{1.f};
+  float normalScale{1.f};
+  float occlusionStrength{1.f};
+  //! Index into the textures of the scene of each MaterialMap; -1 for none.
+  std::array<std::int32_t, kNumMaterialMaps> textures{{-1, -1, -1, -1, -1}};
+  VkBool32 doubleSided{VK_FALSE};
+
+  std::int32_t& texture(MaterialMap map) noexcept {
+    return textures[static_cast<std::size_t>(map)];
+  }
+}; // struct MaterialData
+
+//! \brief An image with a full mip chain and a view of all of it.
+struct Texture {
+  Image image{};
+  ImageView view{};
+}; // struct Texture
+
+struct Material {
+  //! \brief The std140 layout of MaterialBuffer in assets/shaders/gltf.frag.
+  struct BufferData {
+    glm::vec4 baseColorFactor;
+    glm::vec3 emissiveFactor;
+    float normalScale;
+    glm::vec2 metallicRoughnessValues;
+    float occlusionStrength;
+    float pad0;
+  };
+
+  //! \brief The binding of the sampler of \p map in the mesh descriptor set;
+  //! its texture is at the next binding.
+  static constexpr std::uint32_t SamplerBinding(MaterialMap map) noexcept {
+    return 2 + 2 * static_cast<std::uint32_t>(map);
+  }
+
+  //! A uniform buffer holding a BufferData.
+  Buffer buffer{};
+  //! The texture and sampler of each MaterialMap; null if it has none.
+  std::array<std::shared_ptr<Texture const>, kNumMaterialMaps> textures{};
+  std::array<std::shared_ptr<Sampler const>, kNumMaterialMaps> samplers{};
+  bool doubleSided{false};
+
+  //! \brief Whether the material samples \p map.
+  bool HasMap(MaterialMap map) const noexcept {
+    return textures[static_cast<std::size_t>(map)] != nullptr;
+  }
+
+  //! \brief The macros that enable the maps of the material in the
+  //! shaders.
+  std::vector<std::string> ShaderMacros() const;
+}; // struct Material
+
+/*! \brief Create the GPU materials of \p materials, creating the textures of
+ * \p textures they use from \p images. Textures are named after \p name.
+ * \return one Material per entry of \p materials, in order.
+ */
+[[nodiscard]] tl::expected<std::vector<std::shared_ptr<Material const>>,
+                           std::system_error>
+CreateMaterials(gsl::span<MaterialData const> materials,
+                gsl::span<TextureData const> textures,
+                gsl::span<ImageData const> images,
+                std::string const& name) noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_MATERIAL_H_
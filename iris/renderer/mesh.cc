@@ -1,6 +1,18 @@
 #include "renderer/mesh.h"
+#include "absl/container/fixed_array.h"
+#include "enumerate.h"
 #include "logging.h"
+#include "meshoptimizer.h"
 #include "renderer/mikktspace.h"
+#include "renderer/simd.h"
+#include "renderer/vertex_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
 
 namespace iris::Renderer {
 
@@ -40,9 +52,9 @@ static void GetNormal(SMikkTSpaceContext const* pContext, float fvNormOut[],
 
   glm::vec3 n;
   if (data->indices.empty()) {
-    n = data->vertices[iFace * 3 + iVert].position;
+    n = data->vertices[iFace * 3 + iVert].normal;
   } else {
-    n = data->vertices[data->indices[iFace * 3 + iVert]].position;
+    n = data->vertices[data->indices[iFace * 3 + iVert]].normal;
   }
 
   fvNormOut[0] = n.x;
@@ -124,132 +136,388 @@ bool iris::Renderer::MeshData::GenerateTangents() {
   return genTangSpaceDefault(ctx.get());
 } // iris::Renderer::MeshData::GenerateTangents
 
-tl::expected<iris::Renderer::Mesh, std::system_error>
-iris::Renderer::Mesh::Create(MeshData const& data) noexcept {
-  IRIS_LOG_ENTER();
-  Expects(!data.bindingDescriptions.empty());
+void iris::Renderer::MeshData::ComputeBounds() noexcept {
+  boundsMin = glm::vec3(std::numeric_limits<float>::max());
+  boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+  if (vertices.empty()) return;
+
+#if IRIS_RENDERER_HAS_SSE2
+  // Each 16-byte load covers position and the first component of normal,
+  // which is discarded with the fourth lane when storing the result.
+  static_assert(offsetof(Vertex, position) + sizeof(float) * 4 <=
+                sizeof(Vertex));
+  __m128 vMin = _mm_set1_ps(std::numeric_limits<float>::max());
+  __m128 vMax = _mm_set1_ps(std::numeric_limits<float>::lowest());
+
+  for (auto&& vertex : vertices) {
+    __m128 const p = _mm_loadu_ps(&vertex.position.x);
+    vMin = _mm_min_ps(vMin, p);
+    vMax = _mm_max_ps(vMax, p);
+  }
 
-  bool const hasTexCoords = (data.attributeDescriptions.size() == 4);
-  Mesh mesh;
-  mesh.modelMatrix = data.matrix;
-  mesh.modelMatrixInverse = glm::inverse(mesh.modelMatrix);
+  alignas(16) float mins[4];
+  alignas(16) float maxs[4];
+  _mm_store_ps(mins, vMin);
+  _mm_store_ps(maxs, vMax);
+  boundsMin = glm::vec3(mins[0], mins[1], mins[2]);
+  boundsMax = glm::vec3(maxs[0], maxs[1], maxs[2]);
+#else
+  for (auto&& vertex : vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+#endif
+} // iris::Renderer::MeshData::ComputeBounds
+
+float iris::Renderer::MeshStatistics::ACMR() const noexcept {
+  if (numTriangles == 0) return 0.f;
+  return static_cast<float>(numVerticesTransformed) / numTriangles;
+} // iris::Renderer::MeshStatistics::ACMR
+
+float iris::Renderer::MeshStatistics::ATVR() const noexcept {
+  if (numVertices == 0) return 0.f;
+  return static_cast<float>(numVerticesTransformed) / numVertices;
+} // iris::Renderer::MeshStatistics::ATVR
+
+float iris::Renderer::MeshStatistics::Overfetch() const noexcept {
+  if (numBytesReferenced == 0) return 0.f;
+  return static_cast<float>(numBytesFetched) / numBytesReferenced;
+} // iris::Renderer::MeshStatistics::Overfetch
+
+float iris::Renderer::MeshStatistics::Overdraw() const noexcept {
+  if (numPixelsCovered == 0) return 0.f;
+  return static_cast<float>(numPixelsShaded) / numPixelsCovered;
+} // iris::Renderer::MeshStatistics::Overdraw
+
+iris::Renderer::MeshStatistics& iris::Renderer::MeshStatistics::
+operator+=(MeshStatistics const& other) noexcept {
+  numTriangles += other.numTriangles;
+  numVertices += other.numVertices;
+  numVerticesTransformed += other.numVerticesTransformed;
+  numBytesFetched += other.numBytesFetched;
+  numBytesReferenced += other.numBytesReferenced;
+  numPixelsCovered += other.numPixelsCovered;
+  numPixelsShaded += other.numPixelsShaded;
+  return *this;
+} // iris::Renderer::MeshStatistics::operator+=
+
+void iris::Renderer::MeshData::Optimize(bool reduceOverdraw) {
+  if (topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vertices.empty()) {
+    return;
+  }
 
-  if (auto b = Buffer::Create(
-        sizeof(ModelBufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU, data.name + ":modelBuffer")) {
-    mesh.modelBuffer = std::move(*b);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(b.error());
+  if (indices.empty()) {
+    std::vector<unsigned int> remap(vertices.size());
+    std::size_t const numUnique = meshopt_generateVertexRemap(
+      remap.data(), nullptr, vertices.size(), vertices.data(),
+      vertices.size(), sizeof(Vertex));
+
+    indices.resize(vertices.size());
+    meshopt_remapIndexBuffer(indices.data(), nullptr, indices.size(),
+                             remap.data());
+    meshopt_remapVertexBuffer(vertices.data(), vertices.data(),
+                              vertices.size(), sizeof(Vertex), remap.data());
+    vertices.resize(numUnique);
   }
 
-  if (auto p = mesh.modelBuffer.Map<ModelBufferData*>()) {
-    (*p)->modelMatrix = data.matrix;
-    (*p)->modelMatrixInverse = glm::inverse(data.matrix);
-    mesh.modelBuffer.Unmap();
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(p.error());
+  // The cache and overdraw passes permute whole triangles; the fetch pass
+  // then renumbers vertices so the index list walks memory forward.
+  meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(),
+                              vertices.size());
+
+  if (reduceOverdraw) {
+    // Accept up to 5% more cache misses for the overdraw gain.
+    meshopt_optimizeOverdraw(indices.data(), indices.data(), indices.size(),
+                             &vertices[0].position.x, vertices.size(),
+                             sizeof(Vertex), 1.05f);
   }
 
-  if (auto b = Buffer::Create(
-        sizeof(MaterialBufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU, data.name + ":materialBuffer")) {
-    mesh.materialBuffer = std::move(*b);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(b.error());
+  vertices.resize(meshopt_optimizeVertexFetch(
+    vertices.data(), indices.data(), indices.size(), vertices.data(),
+    vertices.size(), sizeof(Vertex)));
+} // iris::Renderer::MeshData::Optimize
+
+iris::Renderer::MeshStatistics
+iris::Renderer::MeshData::Analyze(bool analyzeOverdraw) const {
+  MeshStatistics statistics;
+  if (topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST || vertices.empty()) {
+    return statistics;
+  }
+
+  // Unindexed lists transform every vertex of every triangle.
+  std::vector<unsigned int> sequential;
+  gsl::span<unsigned int const> list = indices;
+  if (list.empty()) {
+    sequential.resize(vertices.size());
+    std::iota(sequential.begin(), sequential.end(), 0u);
+    list = sequential;
   }
 
-  if (auto p = mesh.materialBuffer.Map<MaterialBufferData*>()) {
-    (*p)->metallicRoughnessValues = glm::vec2(0.f, 1.f);
-    (*p)->baseColorFactor = glm::vec4(0.8f, 0.f, 0.f, 1.f);
-    mesh.materialBuffer.Unmap();
+  // A 16 entry FIFO approximates the caches of current hardware.
+  auto const cache = meshopt_analyzeVertexCache(
+    list.data(), list.size(), vertices.size(), 16, 0, 0);
+  auto const fetch = meshopt_analyzeVertexFetch(
+    list.data(), list.size(), vertices.size(), sizeof(Vertex));
+
+  statistics.numTriangles = list.size() / 3;
+  statistics.numVertices = vertices.size();
+  statistics.numVerticesTransformed = cache.vertices_transformed;
+  statistics.numBytesFetched = fetch.bytes_fetched;
+  statistics.numBytesReferenced = vertices.size() * sizeof(Vertex);
+
+  if (analyzeOverdraw) {
+    auto const overdraw = meshopt_analyzeOverdraw(
+      list.data(), list.size(), &vertices[0].position.x, vertices.size(),
+      sizeof(Vertex));
+    statistics.numPixelsCovered = overdraw.pixels_covered;
+    statistics.numPixelsShaded = overdraw.pixels_shaded;
+  }
+
+  return statistics;
+} // iris::Renderer::MeshData::Analyze
+
+void iris::Renderer::MeshData::GenerateLevelsOfDetail() {
+  levelsOfDetail.clear();
+
+  // Below this many triangles a level saves less than its draw costs.
+  std::size_t const kMinIndices = 3 * 256;
+  // The largest error allowed, relative to the extent of the mesh; coarse
+  // levels are only selected when their error projects to under a pixel.
+  float const kMaxRelativeError = 0.25f;
+
+  if (topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST ||
+      indices.size() < kMinIndices * 2) {
+    return;
+  }
+
+  float const scale = meshopt_simplifyScale(
+    &vertices[0].position.x, vertices.size(), sizeof(Vertex));
+  std::vector<unsigned int> simplified(indices.size());
+  std::size_t numPrevious = indices.size();
+  float error = 0.f;
+
+  while (levelsOfDetail.size() < kMaxLevelsOfDetail) {
+    std::size_t const target = numPrevious / 2;
+    if (target < kMinIndices) break;
+
+    // Simplify the full list every time so errors do not compound.
+    float relativeError = 0.f;
+    std::size_t const numIndices = meshopt_simplify(
+      simplified.data(), indices.data(), indices.size(),
+      &vertices[0].position.x, vertices.size(), sizeof(Vertex), target,
+      kMaxRelativeError, 0, &relativeError);
+
+    // Stop when borders or the error bound keep it from getting smaller.
+    if (numIndices == 0 || numIndices > numPrevious * 3 / 4) break;
+
+    LevelOfDetail level;
+    level.indices.assign(simplified.begin(),
+                         simplified.begin() + numIndices);
+    meshopt_optimizeVertexCache(level.indices.data(), level.indices.data(),
+                                numIndices, vertices.size());
+
+    error = std::max(error, relativeError * scale);
+    level.error = error;
+    levelsOfDetail.push_back(std::move(level));
+    numPrevious = numIndices;
+  }
+} // iris::Renderer::MeshData::GenerateLevelsOfDetail
+
+iris::Renderer::MeshDataView::MeshDataView(MeshData const& data)
+  : name(data.name)
+  , matrix(data.matrix)
+  , instanceMatrices(data.instanceMatrices)
+  , vertices(data.vertices)
+  , indices(data.indices)
+  , boundsMin(data.boundsMin)
+  , boundsMax(data.boundsMax)
+  , topology(data.topology)
+  , material(data.material)
+  , hasTexCoords(data.hasTexCoords) {
+  levelsOfDetail.reserve(data.levelsOfDetail.size());
+  for (auto&& level : data.levelsOfDetail) {
+    levelsOfDetail.push_back({level.indices, level.error});
+  }
+} // iris::Renderer::MeshDataView::MeshDataView
+
+iris::Renderer::SceneDataView::SceneDataView(
+  std::shared_ptr<SceneData const> sceneData)
+  : meshes(sceneData->meshes.begin(), sceneData->meshes.end())
+  , materials(sceneData->materials)
+  , textures(sceneData->textures)
+  , images(sceneData->images)
+  , storage(std::move(sceneData)) {
+} // iris::Renderer::SceneDataView::SceneDataView
+
+namespace iris::Renderer {
+
+/*! \brief Split the instances order[first, last) into clusters of at most
+ * Mesh::kMaxInstancesPerCluster by halving them at the median of the longest
+ * axis of their \p spheres centers. Appends the end of each cluster in
+ * \p order to \p ends.
+ */
+static void ClusterInstances(gsl::span<glm::vec4 const> spheres,
+                             std::vector<std::size_t>& order,
+                             std::size_t first, std::size_t last,
+                             std::vector<std::size_t>& ends) {
+  if (first == last) return;
+  if (last - first <= Mesh::kMaxInstancesPerCluster) {
+    ends.push_back(last);
+    return;
+  }
+
+  glm::vec3 lo(std::numeric_limits<float>::max());
+  glm::vec3 hi(std::numeric_limits<float>::lowest());
+  for (std::size_t i = first; i < last; ++i) {
+    lo = glm::min(lo, glm::vec3(spheres[order[i]]));
+    hi = glm::max(hi, glm::vec3(spheres[order[i]]));
+  }
+
+  glm::vec3 const extent = hi - lo;
+  int const axis = (extent.x >= extent.y && extent.x >= extent.z)
+                     ? 0
+                     : (extent.y >= extent.z ? 1 : 2);
+
+  // Ties are broken by index so the clusters do not depend on the order the
+  // instances arrive in.
+  std::size_t const middle = first + (last - first) / 2;
+  std::nth_element(order.begin() + first, order.begin() + middle,
+                   order.begin() + last, [&](std::size_t a, std::size_t b) {
+                     return spheres[a][axis] < spheres[b][axis] ||
+                            (spheres[a][axis] == spheres[b][axis] && a < b);
+                   });
+
+  ClusterInstances(spheres, order, first, middle, ends);
+  ClusterInstances(spheres, order, middle, last, ends);
+} // ClusterInstances
+
+//! \brief A sphere around the \p spheres of \p cluster: centered on their
+//! centroid and reaching the far side of the farthest one.
+static glm::vec4 EnclosingSphere(gsl::span<glm::vec4 const> spheres,
+                                 gsl::span<std::size_t const> cluster) {
+  glm::vec3 centroid(0.f);
+  for (auto&& i : cluster) centroid += glm::vec3(spheres[i]);
+  centroid /= static_cast<float>(cluster.size());
+
+  float radius = 0.f;
+  for (auto&& i : cluster) {
+    radius = std::max(
+      radius, glm::length(glm::vec3(spheres[i]) - centroid) + spheres[i].w);
+  }
+
+  return glm::vec4(centroid, radius);
+} // EnclosingSphere
+
+} // namespace iris::Renderer
+
+tl::expected<std::vector<iris::Renderer::Mesh>, std::system_error>
+iris::Renderer::Mesh::Create(MeshDataView const& data,
+                             std::shared_ptr<Material const> material,
+                             bool quantizeVertices) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(!data.vertices.empty());
+  Expects(material != nullptr);
+
+  bool const hasTexCoords = data.hasTexCoords;
+  VertexFormat const format = MakeVertexFormat(data, quantizeVertices);
+  VkVertexInputBindingDescription const binding = format.Binding();
+  gsl::span<glm::mat4x4 const> instanceMatrices(&data.matrix, 1);
+  if (!data.instanceMatrices.empty()) instanceMatrices = data.instanceMatrices;
+
+  // Level of detail errors are scaled by the largest instance of each
+  // cluster so no instance is drawn coarser than it should be.
+  absl::FixedArray<glm::vec4> spheres(instanceMatrices.size());
+  absl::FixedArray<float> scales(instanceMatrices.size(), 0.f);
+  float maxScale = 0.f;
+
+  bool const hasBounds =
+    glm::all(glm::lessThanEqual(data.boundsMin, data.boundsMax));
+  if (hasBounds) {
+    // Enclose the object-space box in a sphere, then scale its radius by the
+    // largest axis scale of each instance's model matrix.
+    glm::vec3 const center = (data.boundsMin + data.boundsMax) * 0.5f;
+    float const radius = glm::length(data.boundsMax - data.boundsMin) * 0.5f;
+
+    for (auto&& [i, matrix] : enumerate(instanceMatrices)) {
+      scales[i] = std::sqrt(std::max(
+        {glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+         glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+         glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))}));
+      spheres[i] = glm::vec4(glm::vec3(matrix * glm::vec4(center, 1.f)),
+                             radius * scales[i]);
+      maxScale = std::max(maxScale, scales[i]);
+    }
+  }
+
+  // Mirrored instances wind their triangles the other way, so they are
+  // clustered apart and get a pipeline of their own.
+  std::vector<std::size_t> order(instanceMatrices.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::size_t const numMirrored = static_cast<std::size_t>(
+    std::stable_partition(order.begin(), order.end(),
+                          [&](std::size_t i) {
+                            return glm::determinant(instanceMatrices[i]) <
+                                   0.f;
+                          }) -
+    order.begin());
+
+  // Without bounds nothing is culled, so splitting further gains nothing.
+  std::vector<std::size_t> ends;
+  if (hasBounds) {
+    ClusterInstances(spheres, order, 0, numMirrored, ends);
+    ClusterInstances(spheres, order, numMirrored, order.size(), ends);
   } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(p.error());
+    if (numMirrored > 0) ends.push_back(numMirrored);
+    if (numMirrored < order.size()) ends.push_back(order.size());
   }
 
+  // Maps need texture coordinates; without them only the factors apply.
+  std::vector<MaterialMap> maps;
   std::vector<std::string> shaderMacros;
-  if (hasTexCoords) shaderMacros.push_back("-DHAS_TEXCOORDS");
+  if (hasTexCoords) {
+    shaderMacros = material->ShaderMacros();
+    shaderMacros.push_back("-DHAS_TEXCOORDS");
+    for (std::size_t i = 0; i < kNumMaterialMaps; ++i) {
+      if (material->HasMap(static_cast<MaterialMap>(i))) {
+        maps.push_back(static_cast<MaterialMap>(i));
+      }
+    }
+  }
 
-  absl::FixedArray<Shader> shaders(2);
+  absl::FixedArray<std::shared_ptr<Shader const>> shaders(2);
 
-  if (auto vs = Shader::CreateFromFile(
-        "assets/shaders/gltf.vert", VK_SHADER_STAGE_VERTEX_BIT, shaderMacros)) {
+  if (auto vs = GetShaderVariant("assets/shaders/gltf.vert",
+                                 VK_SHADER_STAGE_VERTEX_BIT, shaderMacros)) {
     shaders[0] = std::move(*vs);
   } else {
     IRIS_LOG_LEAVE();
     return tl::unexpected(vs.error());
   }
 
-  if (auto fs = Shader::CreateFromFile(
-        "assets/shaders/gltf.frag", VK_SHADER_STAGE_FRAGMENT_BIT, shaderMacros)) {
+  if (auto fs = GetShaderVariant("assets/shaders/gltf.frag",
+                                 VK_SHADER_STAGE_FRAGMENT_BIT, shaderMacros)) {
     shaders[1] = std::move(*fs);
   } else {
     IRIS_LOG_LEAVE();
     return tl::unexpected(fs.error());
   }
 
-  absl::FixedArray<VkDescriptorSetLayoutBinding> descriptorSetLayoutBinding(2);
-  descriptorSetLayoutBinding[0] = {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+  absl::FixedArray<VkDescriptorSetLayoutBinding> descriptorSetLayoutBinding(
+    2 + maps.size() * 2);
+  descriptorSetLayoutBinding[0] = {0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
                                    VK_SHADER_STAGE_ALL_GRAPHICS, nullptr};
   descriptorSetLayoutBinding[1] = {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
                                    VK_SHADER_STAGE_ALL_GRAPHICS, nullptr};
-
-  if (auto d =
-        AllocateDescriptorSets(descriptorSetLayoutBinding, kNumDescriptorSets,
-                               data.name + ":descriptorSet")) {
-    mesh.descriptorSets = std::move(*d);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(d.error());
+  for (auto&& [i, map] : enumerate(maps)) {
+    std::uint32_t const samplerBinding = Material::SamplerBinding(map);
+    descriptorSetLayoutBinding[2 + i * 2] = {
+      samplerBinding, VK_DESCRIPTOR_TYPE_SAMPLER, 1,
+      VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+    descriptorSetLayoutBinding[3 + i * 2] = {
+      samplerBinding + 1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1,
+      VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
   }
 
-  absl::FixedArray<VkWriteDescriptorSet> writeDescriptorSets(2);
-
-  absl::FixedArray<VkPushConstantRange> pushConstantRanges(1);
-  pushConstantRanges[0] = {VK_SHADER_STAGE_VERTEX_BIT, 0,
-                           sizeof(glm::mat4) * 2 + sizeof(glm::mat3)};
-
-  VkDescriptorBufferInfo modelBufferInfo;
-  modelBufferInfo.buffer = mesh.modelBuffer;
-  modelBufferInfo.offset = 0;
-  modelBufferInfo.range = VK_WHOLE_SIZE;
-
-  VkDescriptorBufferInfo materialBufferInfo;
-  materialBufferInfo.buffer = mesh.materialBuffer;
-  materialBufferInfo.offset = 0;
-  materialBufferInfo.range = VK_WHOLE_SIZE;
-
-  writeDescriptorSets[0] = {
-    VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    nullptr,                           // pNext
-    mesh.descriptorSets.sets[0],       // dstSet
-    0,                                 // dstBinding
-    0,                                 // dstArrayElement
-    1,                                 // descriptorCount
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, // descriptorType
-    nullptr,                           // pImageInfo
-    &modelBufferInfo,                  // pBufferInfo
-    nullptr                            // pTexelBufferView
-  };
-
-  writeDescriptorSets[1] = {
-    VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    nullptr,                           // pNext
-    mesh.descriptorSets.sets[0],       // dstSet
-    1,                                 // dstBinding
-    0,                                 // dstArrayElement
-    1,                                 // descriptorCount
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, // descriptorType
-    nullptr,                           // pImageInfo
-    &materialBufferInfo,               // pBufferInfo
-    nullptr                            // pTexelBufferView
-  };
-
-  UpdateDescriptorSets(writeDescriptorSets);
-
   VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCI = {};
   inputAssemblyStateCI.sType =
     VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -264,12 +532,8 @@ iris::Renderer::Mesh::Create(MeshData const& data) noexcept {
   rasterizationStateCI.sType =
     VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
   rasterizationStateCI.polygonMode = VK_POLYGON_MODE_FILL;
-  rasterizationStateCI.cullMode = VK_CULL_MODE_BACK_BIT;
-  if (glm::determinant(data.matrix) < 0.f) {
-    rasterizationStateCI.frontFace = VK_FRONT_FACE_CLOCKWISE;
-  } else {
-    rasterizationStateCI.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-  }
+  rasterizationStateCI.cullMode =
+    material->doubleSided ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
   rasterizationStateCI.lineWidth = 1.f;
 
   VkPipelineMultisampleStateCreateInfo multisampleStateCI = {};
@@ -302,73 +566,231 @@ iris::Renderer::Mesh::Create(MeshData const& data) noexcept {
   absl::FixedArray<VkDynamicState> dynamicStates{VK_DYNAMIC_STATE_VIEWPORT,
                                                  VK_DYNAMIC_STATE_SCISSOR};
 
-  absl::FixedArray<VkDescriptorSetLayout> descriptorSetLayouts(2);
-  descriptorSetLayouts[0] = sBaseDescriptorSetLayout;
-  descriptorSetLayouts[1] = mesh.descriptorSets.layout;
-
-  if (auto p = Pipeline::CreateGraphics(
-        descriptorSetLayouts, pushConstantRanges, shaders,
-        data.bindingDescriptions, data.attributeDescriptions,
-        inputAssemblyStateCI, viewportStateCI, rasterizationStateCI,
-        multisampleStateCI, depthStencilStateCI, colorBlendAttachmentStates,
-        dynamicStates, 0, data.name + ":pipeline")) {
-    mesh.pipeline = std::move(*p);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(p.error());
-  }
+  //
+  // The geometry is uploaded once and shared by the meshes of every cluster.
+  //
+  std::shared_ptr<GeometryRange const> indices;
+  std::vector<LevelOfDetail> levelsOfDetail;
 
   if (!data.indices.empty()) {
-    mesh.numIndices = static_cast<std::uint32_t>(data.indices.size());
+    // Every level of detail goes in the same range, after the full list.
+    // Without bounds there is no distance to select them by.
+    gsl::span<MeshDataView::LevelOfDetail const> levels;
+    if (maxScale > 0.f) levels = data.levelsOfDetail;
+
+    std::size_t numIndices = static_cast<std::size_t>(data.indices.size());
+    for (auto&& level : levels) {
+      levelsOfDetail.push_back(
+        {gsl::narrow_cast<std::uint32_t>(numIndices),
+         gsl::narrow_cast<std::uint32_t>(level.indices.size()), level.error});
+      numIndices += level.indices.size();
+    }
 
-    if (auto ib = Buffer::CreateFromMemory(
-          data.indices.size() * sizeof(decltype(data.indices)::value_type),
-          VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
-          gsl::not_null(data.indices.data()), data.name + ":indexBuffer")) {
-      mesh.indexBuffer = std::move(*ib);
+    using Index = decltype(data.indices)::value_type;
+    if (auto ib = AllocateGeometry(
+          GeometryKind::kIndex, numIndices * sizeof(Index), sizeof(Index),
+          [&](std::byte* dst) {
+            std::memcpy(dst, data.indices.data(),
+                        data.indices.size() * sizeof(Index));
+            for (auto&& [i, level] : enumerate(levels)) {
+              std::memcpy(dst + levelsOfDetail[i].firstIndex * sizeof(Index),
+                          level.indices.data(),
+                          level.indices.size() * sizeof(Index));
+            }
+          })) {
+      indices = std::make_shared<GeometryRange const>(std::move(*ib));
     } else {
       IRIS_LOG_LEAVE();
       return tl::unexpected(ib.error());
     }
   }
 
-  std::size_t const stride = (3 + 3 + 4 + (hasTexCoords ? 2 : 0));
-  std::vector<float> vertexBuffer(data.vertices.size() * stride);
-  for (std::size_t i = 0; i < data.vertices.size(); ++i) {
-    auto&& vertex = data.vertices[i];
-    std::size_t const offset = i * stride;
-    vertexBuffer[offset + 0] = vertex.position.x;
-    vertexBuffer[offset + 1] = vertex.position.y;
-    vertexBuffer[offset + 2] = vertex.position.z;
-    vertexBuffer[offset + 3] = vertex.normal.x;
-    vertexBuffer[offset + 4] = vertex.normal.y;
-    vertexBuffer[offset + 5] = vertex.normal.z;
-    vertexBuffer[offset + 6] = vertex.tangent.x;
-    vertexBuffer[offset + 7] = vertex.tangent.y;
-    vertexBuffer[offset + 8] = vertex.tangent.z;
-    vertexBuffer[offset + 9] = vertex.tangent.w;
-    if (hasTexCoords) {
-      vertexBuffer[offset + 10] = vertex.texcoord.x;
-      vertexBuffer[offset + 11] = vertex.texcoord.y;
-    }
-  }
-
-  if (auto vb = Buffer::CreateFromMemory(
-        vertexBuffer.size() * sizeof(float), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY, gsl::not_null(vertexBuffer.data()),
-        data.name + ":vertexBuffer")) {}
-
-  if (auto vb = Buffer::CreateFromMemory(
-        data.vertices.size() * sizeof(decltype(data.vertices)::value_type),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
-        gsl::not_null(data.vertices.data()), data.name + ":vertexBuffer")) {
-    mesh.vertexBuffer = std::move(*vb);
+  // Pack straight into staging memory: the vertices are converted once and
+  // copied once.
+  std::shared_ptr<GeometryRange const> vertices;
+  if (auto vb = AllocateGeometry(
+        GeometryKind::kVertex, data.vertices.size() * format.stride,
+        format.stride, [&](std::byte* dst) {
+          PackVertices(format, data.vertices, dst);
+        })) {
+    vertices = std::make_shared<GeometryRange const>(std::move(*vb));
   } else {
     IRIS_LOG_LEAVE();
     return tl::unexpected(vb.error());
   }
 
+  std::vector<Mesh> meshes;
+  meshes.reserve(ends.size());
+  std::size_t begin = 0;
+
+  for (auto&& end : ends) {
+    gsl::span<std::size_t const> const cluster(
+      order.data() + begin, static_cast<std::ptrdiff_t>(end - begin));
+    begin = end;
+
+    std::string const name =
+      ends.size() > 1 ? data.name + ":" + std::to_string(meshes.size())
+                      : data.name;
+
+    Mesh mesh;
+    mesh.material = material;
+    mesh.modelMatrix = instanceMatrices[cluster[0]];
+    mesh.modelMatrixInverse = glm::inverse(mesh.modelMatrix);
+    mesh.numInstances = gsl::narrow_cast<std::uint32_t>(cluster.size());
+
+    float clusterScale = 0.f;
+    if (hasBounds) {
+      for (auto&& i : cluster) {
+        clusterScale = std::max(clusterScale, scales[i]);
+      }
+      mesh.boundingSphere = EnclosingSphere(spheres, cluster);
+    }
+
+    if (auto b = Buffer::Create(
+          sizeof(ModelBufferData) * cluster.size(),
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+          name + ":modelBuffer")) {
+      mesh.modelBuffer = std::move(*b);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(b.error());
+    }
+
+    if (auto p = mesh.modelBuffer.Map<ModelBufferData*>()) {
+      for (auto&& [j, i] : enumerate(cluster)) {
+        (*p)[j].modelMatrix = instanceMatrices[i];
+        (*p)[j].modelMatrixInverse = glm::inverse(instanceMatrices[i]);
+      }
+      mesh.modelBuffer.Unmap();
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(p.error());
+    }
+
+    if (auto d = AllocateDescriptorSets(descriptorSetLayoutBinding,
+                                        kNumDescriptorSets,
+                                        name + ":descriptorSet")) {
+      mesh.descriptorSets = std::move(*d);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(d.error());
+    }
+
+    absl::FixedArray<VkWriteDescriptorSet> writeDescriptorSets(
+      2 + maps.size() * 2);
+
+    VkDescriptorBufferInfo modelBufferInfo;
+    modelBufferInfo.buffer = mesh.modelBuffer;
+    modelBufferInfo.offset = 0;
+    modelBufferInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo materialBufferInfo;
+    materialBufferInfo.buffer = mesh.material->buffer;
+    materialBufferInfo.offset = 0;
+    materialBufferInfo.range = VK_WHOLE_SIZE;
+
+    writeDescriptorSets[0] = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,                           // pNext
+      mesh.descriptorSets.sets[0],       // dstSet
+      0,                                 // dstBinding
+      0,                                 // dstArrayElement
+      1,                                 // descriptorCount
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // descriptorType
+      nullptr,                           // pImageInfo
+      &modelBufferInfo,                  // pBufferInfo
+      nullptr                            // pTexelBufferView
+    };
+
+    writeDescriptorSets[1] = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,                           // pNext
+      mesh.descriptorSets.sets[0],       // dstSet
+      1,                                 // dstBinding
+      0,                                 // dstArrayElement
+      1,                                 // descriptorCount
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, // descriptorType
+      nullptr,                           // pImageInfo
+      &materialBufferInfo,               // pBufferInfo
+      nullptr                            // pTexelBufferView
+    };
+
+    // The image infos must outlive the update.
+    absl::FixedArray<VkDescriptorImageInfo> mapInfos(maps.size() * 2);
+
+    for (auto&& [i, map] : enumerate(maps)) {
+      std::size_t const index = static_cast<std::size_t>(map);
+      std::uint32_t const samplerBinding = Material::SamplerBinding(map);
+
+      mapInfos[i * 2] = {*mesh.material->samplers[index], VK_NULL_HANDLE,
+                         VK_IMAGE_LAYOUT_UNDEFINED};
+      mapInfos[i * 2 + 1] = {VK_NULL_HANDLE,
+                             mesh.material->textures[index]->view,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+      writeDescriptorSets[2 + i * 2] = {
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        nullptr,                     // pNext
+        mesh.descriptorSets.sets[0], // dstSet
+        samplerBinding,              // dstBinding
+        0,                           // dstArrayElement
+        1,                           // descriptorCount
+        VK_DESCRIPTOR_TYPE_SAMPLER,  // descriptorType
+        &mapInfos[i * 2],            // pImageInfo
+        nullptr,                     // pBufferInfo
+        nullptr                      // pTexelBufferView
+      };
+
+      writeDescriptorSets[3 + i * 2] = {
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        nullptr,                          // pNext
+        mesh.descriptorSets.sets[0],      // dstSet
+        samplerBinding + 1,               // dstBinding
+        0,                                // dstArrayElement
+        1,                                // descriptorCount
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, // descriptorType
+        &mapInfos[i * 2 + 1],             // pImageInfo
+        nullptr,                          // pBufferInfo
+        nullptr                           // pTexelBufferView
+      };
+    }
+
+    UpdateDescriptorSets(writeDescriptorSets);
+
+    if (glm::determinant(mesh.modelMatrix) < 0.f) {
+      rasterizationStateCI.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    } else {
+      rasterizationStateCI.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    }
+
+    absl::FixedArray<VkDescriptorSetLayout> descriptorSetLayouts(2);
+    descriptorSetLayouts[0] = sBaseDescriptorSetLayout;
+    descriptorSetLayouts[1] = mesh.descriptorSets.layout;
+
+    if (auto p = GetGraphicsPipeline(
+          descriptorSetLayouts, {}, shaders, gsl::make_span(&binding, 1),
+          format.Attributes(), inputAssemblyStateCI, viewportStateCI,
+          rasterizationStateCI, multisampleStateCI, depthStencilStateCI,
+          colorBlendAttachmentStates, dynamicStates, 0,
+          data.name + ":pipeline")) {
+      mesh.pipeline = std::move(*p);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(p.error());
+    }
+
+    mesh.vertices = vertices;
+    mesh.indices = indices;
+    mesh.vertexStride = format.stride;
+    mesh.numVertices = gsl::narrow_cast<std::uint32_t>(data.vertices.size());
+    mesh.numIndices = gsl::narrow_cast<std::uint32_t>(data.indices.size());
+    mesh.levelsOfDetail = levelsOfDetail;
+    for (auto&& level : mesh.levelsOfDetail) level.error *= clusterScale;
+
+    meshes.push_back(std::move(mesh));
+  }
+
   IRIS_LOG_LEAVE();
-  return std::move(mesh);
+  return std::move(meshes);
 } // iris::Renderer::Mesh::Create
 
@@ -4,11 +4,41 @@
 #include "glm/glm.hpp"
 #include "renderer/buffer.h"
 #include "renderer/descriptor_sets.h"
+#include "renderer/geometry_arena.h"
+#include "renderer/material.h"
 #include "renderer/pipeline.h"
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace iris::Renderer {
 
+/*! \brief How well an index list uses the post-transform vertex cache, vertex
+ * fetch and, if analyzed, the framebuffer. Sums of several meshes give the
+ * combined ratios.
+ */
+struct MeshStatistics {
+  std::size_t numTriangles{0};
+  std::size_t numVertices{0};
+  std::size_t numVerticesTransformed{0};
+  std::size_t numBytesFetched{0};
+  std::size_t numBytesReferenced{0};
+  std::size_t numPixelsCovered{0};
+  std::size_t numPixelsShaded{0};
+
+  //! Average cache miss ratio: vertices transformed per triangle.
+  float ACMR() const noexcept;
+  //! Average transformed vertex ratio: vertices transformed per vertex.
+  float ATVR() const noexcept;
+  //! Bytes of vertices fetched per byte of vertices.
+  float Overfetch() const noexcept;
+  //! Pixels shaded per pixel covered; 0 if overdraw was not analyzed.
+  float Overdraw() const noexcept;
+
+  MeshStatistics& operator+=(MeshStatistics const& other) noexcept;
+}; // struct MeshStatistics
+
 struct MeshData {
   struct Vertex {
     glm::vec3 position{0.0f, 0.0f, 0.0f};
@@ -19,49 +49,192 @@ struct MeshData {
 
   std::string name{};
   glm::mat4x4 matrix{1.f};
+  //! Transforms of every instance when the same geometry is placed more than
+  //! once; empty for a single instance at matrix.
+  std::vector<glm::mat4x4> instanceMatrices{};
 
   std::vector<Vertex> vertices{};
   std::vector<unsigned int> indices{};
 
+  //! A simplified index list of the same vertices.
+  struct LevelOfDetail {
+    std::vector<unsigned int> indices{};
+    //! Object-space distance the simplified surface may deviate by.
+    float error{0.f};
+  };
+
+  //! The most levels of detail GenerateLevelsOfDetail creates; also the
+  //! size of the level table in assets/shaders/cull.comp.
+  static constexpr std::size_t const kMaxLevelsOfDetail = 6;
+
+  //! Levels of detail coarser than indices, in order of increasing error.
+  std::vector<LevelOfDetail> levelsOfDetail{};
+
+  //! Object-space bounds of the vertex positions; empty if min > max.
+  glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+  glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+
   VkPrimitiveTopology topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
-  std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
-  std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+  //! Index into the materials of the scene; -1 for the default material.
+  std::int32_t material{-1};
+  //! Whether vertices carry texture coordinates; the GPU vertex layout is
+  //! chosen from this by MakeVertexFormat.
+  bool hasTexCoords{false};
 
   void GenerateNormals();
   bool GenerateTangents();
+  void ComputeBounds() noexcept;
+
+  /*! \brief Reorder triangles for the post-transform vertex cache and, if
+   * \p reduceOverdraw is true, then for less overdraw at a small cost in
+   * cache efficiency; then reorder vertices in the order they are first
+   * used. Triangle lists without indices are indexed first, welding
+   * identical vertices. Other topologies are left as they are.
+   */
+  void Optimize(bool reduceOverdraw);
+
+  //! \brief Measure the index list; overdraw is only measured if
+  //! \p analyzeOverdraw is true as it rasterizes the mesh.
+  MeshStatistics Analyze(bool analyzeOverdraw) const;
+
+  /*! \brief Fill levelsOfDetail by repeatedly simplifying indices to about
+   * half the triangles, until simplification stalls, the mesh gets small or
+   * there are kMaxLevelsOfDetail levels. Only indexed triangle lists are
+   * simplified; call after Optimize.
+   */
+  void GenerateLevelsOfDetail();
 }; // struct MeshData
 
+//! \brief Everything loaded from a scene file: its meshes and the
+//! materials, textures and images they refer to by index.
+struct SceneData {
+  std::vector<MeshData> meshes{};
+  std::vector<MaterialData> materials{};
+  std::vector<TextureData> textures{};
+  std::vector<ImageData> images{};
+}; // struct SceneData
+
+/*! \brief The parts of a MeshData a Mesh is created from, with the streams
+ * left where they are: in a MeshData or in a mapped scene cache entry.
+ */
+struct MeshDataView {
+  struct LevelOfDetail {
+    gsl::span<unsigned int const> indices{};
+    float error{0.f};
+  };
+
+  std::string name{};
+  glm::mat4x4 matrix{1.f};
+  gsl::span<glm::mat4x4 const> instanceMatrices{};
+  gsl::span<MeshData::Vertex const> vertices{};
+  gsl::span<unsigned int const> indices{};
+  std::vector<LevelOfDetail> levelsOfDetail{};
+  glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+  glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+  VkPrimitiveTopology topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+  std::int32_t material{-1};
+  bool hasTexCoords{false};
+
+  MeshDataView() = default;
+  //! \brief View the streams of \p data, which must outlive the view.
+  MeshDataView(MeshData const& data);
+}; // struct MeshDataView
+
+/*! \brief The parts of a SceneData a scene is created from. The mesh
+ * streams, materials and textures refer to memory \ref storage keeps alive,
+ * so a scene read from the cache is never copied out of its mapping.
+ */
+struct SceneDataView {
+  std::vector<MeshDataView> meshes{};
+  gsl::span<MaterialData const> materials{};
+  gsl::span<TextureData const> textures{};
+  std::vector<ImageData> images{};
+  //! Owns what the spans refer to.
+  std::shared_ptr<void const> storage{};
+
+  SceneDataView() = default;
+  //! \brief View \p sceneData, keeping it alive.
+  explicit SceneDataView(std::shared_ptr<SceneData const> sceneData);
+}; // struct SceneDataView
+
 struct Mesh {
   static constexpr std::size_t const kNumDescriptorSets = 1;
 
-  static tl::expected<Mesh, std::system_error>
-  Create(MeshData const& data) noexcept;
+  //! The most instances of one MeshData a single Mesh draws.
+  static constexpr std::size_t const kMaxInstancesPerCluster = 64;
+
+  /*! \brief Create the meshes of \p data shaded with \p material, storing
+   * its vertices tightly packed and, if \p quantizeVertices is true,
+   * quantized; see MakeVertexFormat. The maps of \p material are only
+   * sampled if \p data has texture coordinates.
+   *
+   * The instances of \p data are split into spatial clusters of at most
+   * kMaxInstancesPerCluster, one Mesh each, so every cluster is culled,
+   * sorted and has its level of detail selected on its own bounds. The
+   * meshes share the geometry.
+   */
+  static tl::expected<std::vector<Mesh>, std::system_error>
+  Create(MeshDataView const& data, std::shared_ptr<Material const> material,
+         bool quantizeVertices = false) noexcept;
 
   struct ModelBufferData {
     glm::mat4 modelMatrix;
     glm::mat4 modelMatrixInverse;
   };
 
-  struct MaterialBufferData {
-    glm::vec2 metallicRoughnessValues;
-    glm::vec2 pad0;
-    glm::vec4 baseColorFactor;
-
-    //float NormalScale; // optional
-    //glm::vec3 EmissiveFactor; // optional
-    //float OcclusionStrength; // optional
-  };
-
   glm::mat4 modelMatrix{1.f};
   glm::mat4 modelMatrixInverse{1.f};
   Buffer modelBuffer{};
-  Buffer materialBuffer{};
+  //! Shared with the other meshes of the scene that use it.
+  std::shared_ptr<Material const> material{};
   DescriptorSets descriptorSets;
-  Pipeline pipeline{};
-  Buffer vertexBuffer{};
-  Buffer indexBuffer{};
+  std::shared_ptr<Pipeline const> pipeline{};
+  //! Ranges of the shared geometry buffers, shared with the other clusters
+  //! of the same MeshData; indices is null for non-indexed meshes.
+  std::shared_ptr<GeometryRange const> vertices{};
+  std::shared_ptr<GeometryRange const> indices{};
+  std::uint32_t vertexStride{0};
   std::uint32_t numVertices{0};
   std::uint32_t numIndices{0};
+  //! Number of ModelBufferData entries in modelBuffer, one per instance.
+  std::uint32_t numInstances{1};
+
+  //! A coarser index list stored after the full one in the indices range.
+  struct LevelOfDetail {
+    //! Offset in indices from the first index of the full list.
+    std::uint32_t firstIndex{0};
+    std::uint32_t numIndices{0};
+    //! World-space error at the largest instance scale.
+    float error{0.f};
+  };
+
+  //! Levels of detail coarser than the full index list, in order of
+  //! increasing error; level 0 is the full list and level i is
+  //! levelsOfDetail[i - 1].
+  std::vector<LevelOfDetail> levelsOfDetail{};
+  //! World-space bounding sphere of the instances: center in xyz and radius
+  //! in w. An infinite radius means the mesh has no bounds and is never
+  //! culled.
+  glm::vec4 boundingSphere{0.f, 0.f, 0.f,
+                           std::numeric_limits<float>::infinity()};
+
+  //! \brief The vertexOffset (or firstVertex) of this mesh's draws.
+  std::int32_t VertexOffset() const noexcept {
+    return gsl::narrow_cast<std::int32_t>(vertices->Offset() / vertexStride);
+  }
+
+  //! \brief The firstIndex of this mesh's indexed draws of \p level.
+  std::uint32_t FirstIndex(std::uint32_t level = 0) const noexcept {
+    if (!indices) return 0;
+    std::uint32_t const first = gsl::narrow_cast<std::uint32_t>(
+      indices->Offset() / sizeof(std::uint32_t));
+    return level == 0 ? first : first + levelsOfDetail[level - 1].firstIndex;
+  }
+
+  //! \brief The indexCount of this mesh's indexed draws of \p level.
+  std::uint32_t NumIndices(std::uint32_t level = 0) const noexcept {
+    return level == 0 ? numIndices : levelsOfDetail[level - 1].numIndices;
+  }
 
   Mesh()
     : descriptorSets(kNumDescriptorSets) {}
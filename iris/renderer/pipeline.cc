@@ -1,11 +1,134 @@
 #include "renderer/pipeline.h"
+#include "absl/container/flat_hash_map.h"
 #include "logging.h"
+#include <mutex>
+#include <type_traits>
+
+namespace iris::Renderer {
+
+static std::mutex sGraphicsPipelinesMutex;
+static absl::flat_hash_map<std::string, std::shared_ptr<Pipeline const>>
+  sGraphicsPipelines;
+static std::size_t sGraphicsPipelineRequests{0};
+
+//! \brief Append the bytes of \p value to \p key. Only used for handles,
+//! scalars and Vulkan structs without padding or pointers.
+template <class T>
+static void AppendToKey(std::string& key, T const& value) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  key.append(reinterpret_cast<char const*>(&value), sizeof(T));
+} // AppendToKey
+
+template <class T>
+static void AppendSpanToKey(std::string& key, gsl::span<T> values) noexcept {
+  AppendToKey(key, values.size());
+  for (auto&& value : values) AppendToKey(key, value);
+} // AppendSpanToKey
+
+/*! \brief Build the key identifying a graphics pipeline: every field that
+ * affects the created pipeline, with sType and pNext skipped and pointed-to
+ * arrays expanded.
+ */
+static std::string GraphicsPipelineKey(
+  gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+  gsl::span<const VkPushConstantRange> pushConstantRanges,
+  gsl::span<const std::shared_ptr<Shader const>> shaders,
+  gsl::span<const VkVertexInputBindingDescription>
+    vertexInputBindingDescriptions,
+  gsl::span<const VkVertexInputAttributeDescription>
+    vertexInputAttributeDescriptions,
+  VkPipelineInputAssemblyStateCreateInfo const& inputAssemblyStateCI,
+  VkPipelineViewportStateCreateInfo const& viewportStateCI,
+  VkPipelineRasterizationStateCreateInfo const& rasterizationStateCI,
+  VkPipelineMultisampleStateCreateInfo const& multisampleStateCI,
+  VkPipelineDepthStencilStateCreateInfo const& depthStencilStateCI,
+  gsl::span<const VkPipelineColorBlendAttachmentState>
+    colorBlendAttachmentStates,
+  gsl::span<const VkDynamicState> dynamicStates,
+  std::uint32_t renderPassSubpass) noexcept {
+  std::string key;
+  key.reserve(512);
+
+  AppendToKey(key, sRenderPass);
+  AppendToKey(key, renderPassSubpass);
+  AppendSpanToKey(key, descriptorSetLayouts);
+  AppendSpanToKey(key, pushConstantRanges);
+
+  AppendToKey(key, shaders.size());
+  for (auto&& shader : shaders) {
+    AppendToKey(key, shader->stage);
+    AppendToKey(key, shader->handle);
+    key.append(shader->entry).push_back('\0');
+  }
+
+  AppendSpanToKey(key, vertexInputBindingDescriptions);
+  AppendSpanToKey(key, vertexInputAttributeDescriptions);
+
+  AppendToKey(key, inputAssemblyStateCI.flags);
+  AppendToKey(key, inputAssemblyStateCI.topology);
+  AppendToKey(key, inputAssemblyStateCI.primitiveRestartEnable);
+
+  AppendToKey(key, viewportStateCI.flags);
+  AppendToKey(key, viewportStateCI.viewportCount);
+  if (viewportStateCI.pViewports) {
+    AppendSpanToKey(key, gsl::make_span(viewportStateCI.pViewports,
+                                        viewportStateCI.viewportCount));
+  }
+  AppendToKey(key, viewportStateCI.scissorCount);
+  if (viewportStateCI.pScissors) {
+    AppendSpanToKey(key, gsl::make_span(viewportStateCI.pScissors,
+                                        viewportStateCI.scissorCount));
+  }
+
+  AppendToKey(key, rasterizationStateCI.flags);
+  AppendToKey(key, rasterizationStateCI.depthClampEnable);
+  AppendToKey(key, rasterizationStateCI.rasterizerDiscardEnable);
+  AppendToKey(key, rasterizationStateCI.polygonMode);
+  AppendToKey(key, rasterizationStateCI.cullMode);
+  AppendToKey(key, rasterizationStateCI.frontFace);
+  AppendToKey(key, rasterizationStateCI.depthBiasEnable);
+  AppendToKey(key, rasterizationStateCI.depthBiasConstantFactor);
+  AppendToKey(key, rasterizationStateCI.depthBiasClamp);
+  AppendToKey(key, rasterizationStateCI.depthBiasSlopeFactor);
+  AppendToKey(key, rasterizationStateCI.lineWidth);
+
+  AppendToKey(key, multisampleStateCI.flags);
+  AppendToKey(key, multisampleStateCI.rasterizationSamples);
+  AppendToKey(key, multisampleStateCI.sampleShadingEnable);
+  AppendToKey(key, multisampleStateCI.minSampleShading);
+  if (multisampleStateCI.pSampleMask) {
+    std::uint32_t const numSampleMaskWords =
+      (multisampleStateCI.rasterizationSamples + 31) / 32;
+    AppendSpanToKey(key, gsl::make_span(multisampleStateCI.pSampleMask,
+                                        numSampleMaskWords));
+  }
+  AppendToKey(key, multisampleStateCI.alphaToCoverageEnable);
+  AppendToKey(key, multisampleStateCI.alphaToOneEnable);
+
+  AppendToKey(key, depthStencilStateCI.flags);
+  AppendToKey(key, depthStencilStateCI.depthTestEnable);
+  AppendToKey(key, depthStencilStateCI.depthWriteEnable);
+  AppendToKey(key, depthStencilStateCI.depthCompareOp);
+  AppendToKey(key, depthStencilStateCI.depthBoundsTestEnable);
+  AppendToKey(key, depthStencilStateCI.stencilTestEnable);
+  AppendToKey(key, depthStencilStateCI.front);
+  AppendToKey(key, depthStencilStateCI.back);
+  AppendToKey(key, depthStencilStateCI.minDepthBounds);
+  AppendToKey(key, depthStencilStateCI.maxDepthBounds);
+
+  AppendSpanToKey(key, colorBlendAttachmentStates);
+  AppendSpanToKey(key, dynamicStates);
+
+  return key;
+} // GraphicsPipelineKey
+
+} // namespace iris::Renderer
 
 tl::expected<iris::Renderer::Pipeline, std::system_error>
 iris::Renderer::Pipeline::CreateGraphics(
   gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
   gsl::span<const VkPushConstantRange> pushConstantRanges,
-  gsl::span<const Shader> shaders,
+  gsl::span<const std::shared_ptr<Shader const>> shaders,
   gsl::span<const VkVertexInputBindingDescription>
     vertexInputBindingDescriptions,
   gsl::span<const VkVertexInputAttributeDescription>
@@ -48,9 +171,9 @@ iris::Renderer::Pipeline::CreateGraphics(
     shaderStageCIs[i] = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                          nullptr,
                          0,
-                         shaders[i].stage,
-                         shaders[i].handle,
-                         shaders[i].entry.c_str(),
+                         shaders[i]->stage,
+                         shaders[i]->handle,
+                         shaders[i]->entry.c_str(),
                          nullptr};
   }
 
@@ -95,7 +218,7 @@ iris::Renderer::Pipeline::CreateGraphics(
   graphicsPipelineCI.renderPass = sRenderPass;
   graphicsPipelineCI.subpass = renderPassSubpass;
 
-  if (auto result = vkCreateGraphicsPipelines(sDevice, VK_NULL_HANDLE, 1,
+  if (auto result = vkCreateGraphicsPipelines(sDevice, sPipelineCache, 1,
                                               &graphicsPipelineCI, nullptr,
                                               &pipeline.handle);
       result != VK_SUCCESS) {
@@ -118,6 +241,136 @@ iris::Renderer::Pipeline::CreateGraphics(
   return std::move(pipeline);
 } // iris::Renderer::Pipeline::Create
 
+tl::expected<iris::Renderer::Pipeline, std::system_error>
+iris::Renderer::Pipeline::CreateCompute(
+  gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+  gsl::span<const VkPushConstantRange> pushConstantRanges,
+  Shader const& shader, std::string name) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+  Expects(shader.stage == VK_SHADER_STAGE_COMPUTE_BIT);
+
+  Pipeline pipeline;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+  pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutCI.setLayoutCount =
+    gsl::narrow_cast<std::uint32_t>(descriptorSetLayouts.size());
+  pipelineLayoutCI.pSetLayouts = descriptorSetLayouts.data();
+  pipelineLayoutCI.pushConstantRangeCount =
+    gsl::narrow_cast<std::uint32_t>(pushConstantRanges.size());
+  pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
+
+  if (auto result = vkCreatePipelineLayout(sDevice, &pipelineLayoutCI, nullptr,
+                                           &pipeline.layout);
+      result != VK_SUCCESS) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(make_error_code(result),
+                                            "Cannot create pipeline layout"));
+  }
+
+  VkComputePipelineCreateInfo computePipelineCI = {};
+  computePipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  computePipelineCI.stage = {
+    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+    nullptr,
+    0,
+    shader.stage,
+    shader.handle,
+    shader.entry.c_str(),
+    nullptr};
+  computePipelineCI.layout = pipeline.layout;
+
+  if (auto result = vkCreateComputePipelines(sDevice, sPipelineCache, 1,
+                                             &computePipelineCI, nullptr,
+                                             &pipeline.handle);
+      result != VK_SUCCESS) {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(std::system_error(make_error_code(result),
+                                            "Cannot create compute pipeline"));
+  }
+
+  if (!name.empty()) {
+    NameObject(VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipeline.layout,
+               (name + ".layout").c_str());
+    NameObject(VK_OBJECT_TYPE_PIPELINE, pipeline.handle, name.c_str());
+  }
+
+  pipeline.name = std::move(name);
+
+  Ensures(pipeline.layout != VK_NULL_HANDLE);
+  Ensures(pipeline.handle != VK_NULL_HANDLE);
+  IRIS_LOG_LEAVE();
+  return std::move(pipeline);
+} // iris::Renderer::Pipeline::CreateCompute
+
+tl::expected<std::shared_ptr<iris::Renderer::Pipeline const>, std::system_error>
+iris::Renderer::GetGraphicsPipeline(
+  gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+  gsl::span<const VkPushConstantRange> pushConstantRanges,
+  gsl::span<const std::shared_ptr<Shader const>> shaders,
+  gsl::span<const VkVertexInputBindingDescription>
+    vertexInputBindingDescriptions,
+  gsl::span<const VkVertexInputAttributeDescription>
+    vertexInputAttributeDescriptions,
+  VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCI,
+  VkPipelineViewportStateCreateInfo viewportStateCI,
+  VkPipelineRasterizationStateCreateInfo rasterizationStateCI,
+  VkPipelineMultisampleStateCreateInfo multisampleStateCI,
+  VkPipelineDepthStencilStateCreateInfo depthStencilStateCI,
+  gsl::span<const VkPipelineColorBlendAttachmentState>
+    colorBlendAttachmentStates,
+  gsl::span<const VkDynamicState> dynamicStates,
+  std::uint32_t renderPassSubpass, std::string name) noexcept {
+  IRIS_LOG_ENTER();
+
+  std::string const key = GraphicsPipelineKey(
+    descriptorSetLayouts, pushConstantRanges, shaders,
+    vertexInputBindingDescriptions, vertexInputAttributeDescriptions,
+    inputAssemblyStateCI, viewportStateCI, rasterizationStateCI,
+    multisampleStateCI, depthStencilStateCI, colorBlendAttachmentStates,
+    dynamicStates, renderPassSubpass);
+
+  std::lock_guard<std::mutex> lock(sGraphicsPipelinesMutex);
+  ++sGraphicsPipelineRequests;
+
+  if (auto iter = sGraphicsPipelines.find(key);
+      iter != sGraphicsPipelines.end()) {
+    IRIS_LOG_LEAVE();
+    return iter->second;
+  }
+
+  std::shared_ptr<Pipeline const> pipeline;
+  if (auto p = Pipeline::CreateGraphics(
+        descriptorSetLayouts, pushConstantRanges, shaders,
+        vertexInputBindingDescriptions, vertexInputAttributeDescriptions,
+        inputAssemblyStateCI, viewportStateCI, rasterizationStateCI,
+        multisampleStateCI, depthStencilStateCI, colorBlendAttachmentStates,
+        dynamicStates, renderPassSubpass, std::move(name))) {
+    pipeline = std::make_shared<Pipeline const>(std::move(*p));
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(p.error());
+  }
+
+  sGraphicsPipelines.emplace(key, pipeline);
+
+  IRIS_LOG_LEAVE();
+  return pipeline;
+} // iris::Renderer::GetGraphicsPipeline
+
+void iris::Renderer::ReleaseGraphicsPipelines() noexcept {
+  IRIS_LOG_ENTER();
+  std::lock_guard<std::mutex> lock(sGraphicsPipelinesMutex);
+
+  GetLogger()->info("Graphics pipelines: {} created for {} requests",
+                    sGraphicsPipelines.size(), sGraphicsPipelineRequests);
+  sGraphicsPipelines.clear();
+  sGraphicsPipelineRequests = 0;
+
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::ReleaseGraphicsPipelines
+
 iris::Renderer::Pipeline::Pipeline(Pipeline&& other) noexcept
   : layout(other.layout)
   , handle(other.handle)
@@ -4,6 +4,7 @@
 #include "iris/renderer/impl.h"
 #include "iris/renderer/shader.h"
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -13,7 +14,7 @@ struct Pipeline {
   static tl::expected<Pipeline, std::system_error>
   CreateGraphics(gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
                  gsl::span<const VkPushConstantRange> pushConstantRanges,
-                 gsl::span<const Shader> shaders,
+                 gsl::span<const std::shared_ptr<Shader const>> shaders,
                  gsl::span<const VkVertexInputBindingDescription>
                    vertexInputBindingDescriptions,
                  gsl::span<const VkVertexInputAttributeDescription>
@@ -29,6 +30,11 @@ struct Pipeline {
                  std::uint32_t renderPassSubpass,
                  std::string name = {}) noexcept;
 
+  static tl::expected<Pipeline, std::system_error>
+  CreateCompute(gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                gsl::span<const VkPushConstantRange> pushConstantRanges,
+                Shader const& shader, std::string name = {}) noexcept;
+
   VkPipelineLayout layout{VK_NULL_HANDLE};
   VkPipeline handle{VK_NULL_HANDLE};
 
@@ -45,6 +51,36 @@ private:
   std::string name;
 }; // struct Pipeline
 
+/*! \brief Get a graphics Pipeline shared by every caller with the same state.
+ *
+ * The arguments are the same as Pipeline::CreateGraphics. The full state,
+ * including the layout, is the key: a pipeline is only created the first
+ * time a given state is requested. The registry keeps pipelines alive until
+ * ReleaseGraphicsPipelines.
+ */
+tl::expected<std::shared_ptr<Pipeline const>, std::system_error>
+GetGraphicsPipeline(gsl::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                    gsl::span<const VkPushConstantRange> pushConstantRanges,
+                    gsl::span<const std::shared_ptr<Shader const>> shaders,
+                    gsl::span<const VkVertexInputBindingDescription>
+                      vertexInputBindingDescriptions,
+                    gsl::span<const VkVertexInputAttributeDescription>
+                      vertexInputAttributeDescriptions,
+                    VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCI,
+                    VkPipelineViewportStateCreateInfo viewportStateCI,
+                    VkPipelineRasterizationStateCreateInfo rasterizationStateCI,
+                    VkPipelineMultisampleStateCreateInfo multisampleStateCI,
+                    VkPipelineDepthStencilStateCreateInfo depthStencilStateCI,
+                    gsl::span<const VkPipelineColorBlendAttachmentState>
+                      colorBlendAttachmentStates,
+                    gsl::span<const VkDynamicState> dynamicStates,
+                    std::uint32_t renderPassSubpass,
+                    std::string name = {}) noexcept;
+
+//! \brief Drop the registry's references to all shared pipelines; must be
+//! called before the device is destroyed.
+void ReleaseGraphicsPipelines() noexcept;
+
 } // namespace iris::Renderer
 
 #endif // HEV_IRIS_RENDERER_PIPELINE_H_
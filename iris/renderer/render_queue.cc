@@ -0,0 +1,51 @@
+#include "renderer/render_queue.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+// Key layout, most significant first:
+//   [63:48] unused
+//   [47:16] pipeline rank
+//   [15:0]  depth: the top 16 bits of a non-negative float
+
+std::uint64_t
+iris::Renderer::MakeStateKey(std::uint32_t pipelineRank) noexcept {
+  return std::uint64_t{pipelineRank} << 16;
+} // iris::Renderer::MakeStateKey
+
+std::uint64_t iris::Renderer::MakeDrawKey(std::uint64_t stateKey,
+                                          float depth) noexcept {
+  // The bit patterns of non-negative floats sort in the same order as their
+  // values; negative and NaN depths are in front of the camera plane.
+  if (!(depth > 0.f)) depth = 0.f;
+
+  std::uint32_t bits;
+  std::memcpy(&bits, &depth, sizeof(bits));
+  return stateKey | (bits >> 16);
+} // iris::Renderer::MakeDrawKey
+
+void iris::Renderer::RadixSort(std::vector<DrawItem>& items,
+                               std::vector<DrawItem>& scratch) noexcept {
+  if (items.size() < 2) return;
+  scratch.resize(items.size());
+
+  for (unsigned int shift = 0; shift < 64; shift += 8) {
+    std::array<std::size_t, 256> counts{};
+    for (auto&& item : items) counts[(item.key >> shift) & 0xFF]++;
+
+    // Every key has the same byte here: the pass would not move anything.
+    if (counts[(items[0].key >> shift) & 0xFF] == items.size()) continue;
+
+    std::size_t offset = 0;
+    for (auto&& count : counts) {
+      std::size_t const n = count;
+      count = offset;
+      offset += n;
+    }
+
+    for (auto&& item : items) {
+      scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+    }
+    items.swap(scratch);
+  }
+} // iris::Renderer::RadixSort
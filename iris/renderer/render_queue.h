@@ -0,0 +1,47 @@
+#ifndef HEV_IRIS_RENDERER_RENDER_QUEUE_H_
+#define HEV_IRIS_RENDERER_RENDER_QUEUE_H_
+/*! \file
+ * \brief \ref iris::Renderer::DrawItem declaration.
+ */
+
+#include <cstdint>
+#include <vector>
+
+namespace iris::Renderer {
+
+/*! \brief One draw in a render queue: a sort key, the mesh to draw and its
+ * level of detail.
+ *
+ * Keys order draws by pipeline, then depth, so sorting a queue groups the
+ * draws that share a pipeline and draws each group front to back. Every mesh
+ * sub-allocates its geometry from the same vertex and index buffers, and mesh
+ * descriptor sets are unique to each mesh, so neither is part of the key.
+ */
+struct DrawItem {
+  std::uint64_t key{0};
+  std::uint32_t meshIndex{0};
+  std::uint32_t levelOfDetail{0};
+}; // struct DrawItem
+
+/*! \brief Build the state part of a sort key from a small integer
+ * identifying the pipeline of a mesh.
+ */
+std::uint64_t MakeStateKey(std::uint32_t pipelineRank) noexcept;
+
+/*! \brief Combine \p stateKey with the view-space distance \p depth.
+ *
+ * Depth is quantized to 16 bits (roughly 1% steps) so that small camera
+ * movements do not reorder draws; ties keep their queue order.
+ */
+std::uint64_t MakeDrawKey(std::uint64_t stateKey, float depth) noexcept;
+
+/*! \brief Stable LSD radix sort of \p items by key, using \p scratch as the
+ * second buffer. Passes over bytes that are equal in every key are skipped,
+ * so unused key bits cost nothing.
+ */
+void RadixSort(std::vector<DrawItem>& items,
+               std::vector<DrawItem>& scratch) noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_RENDER_QUEUE_H_
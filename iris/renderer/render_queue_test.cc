@@ -0,0 +1,129 @@
+#include "renderer/render_queue.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace iris::Renderer;
+
+TEST(MakeStateKey, PlacesPipelineAboveDepth) {
+  EXPECT_EQ(MakeStateKey(0), 0u);
+  EXPECT_EQ(MakeStateKey(1), std::uint64_t{1} << 16);
+  EXPECT_EQ(MakeStateKey(0x12345678), 0x123456780000u);
+  EXPECT_EQ(MakeStateKey(0xFFFFFFFF), 0xFFFFFFFF0000u);
+}
+
+TEST(MakeStateKey, LeavesDepthBitsClear) {
+  for (std::uint32_t rank : {0u, 1u, 0xFFFFu, 0x12345678u, 0xFFFFFFFFu}) {
+    EXPECT_EQ(MakeStateKey(rank) & 0xFFFF, 0u);
+  }
+}
+
+TEST(MakeStateKey, OrdersByPipeline) {
+  EXPECT_LT(MakeStateKey(0), MakeStateKey(1));
+  EXPECT_LT(MakeStateKey(3), MakeStateKey(0xFFFFFFFF));
+}
+
+TEST(MakeDrawKey, PutsDepthInLowBits) {
+  // 1.f is 0x3F800000; its top 16 bits are the depth.
+  EXPECT_EQ(MakeDrawKey(0, 1.f), 0x3F80u);
+  EXPECT_EQ(MakeDrawKey(MakeStateKey(2), 1.f),
+            MakeStateKey(2) | 0x3F80u);
+
+  // Even the largest depth stays out of the state bits.
+  EXPECT_EQ(MakeDrawKey(0, std::numeric_limits<float>::max()) >> 16, 0u);
+  EXPECT_EQ(MakeDrawKey(0, std::numeric_limits<float>::infinity()), 0x7F80u);
+}
+
+TEST(MakeDrawKey, ClampsNegativeAndNaNDepthToZero) {
+  EXPECT_EQ(MakeDrawKey(0, 0.f), 0u);
+  EXPECT_EQ(MakeDrawKey(0, -0.f), 0u);
+  EXPECT_EQ(MakeDrawKey(0, -5.f), 0u);
+  EXPECT_EQ(MakeDrawKey(0, std::numeric_limits<float>::quiet_NaN()), 0u);
+  EXPECT_EQ(MakeDrawKey(MakeStateKey(1), -1.f), MakeStateKey(1));
+}
+
+TEST(MakeDrawKey, OrdersByDepthFrontToBack) {
+  std::uint64_t const state = MakeStateKey(1);
+  EXPECT_LT(MakeDrawKey(state, 0.5f), MakeDrawKey(state, 1.f));
+  EXPECT_LT(MakeDrawKey(state, 1.f), MakeDrawKey(state, 2.f));
+  EXPECT_LT(MakeDrawKey(state, 2.f), MakeDrawKey(state, 1000.f));
+
+  // Depth never outweighs state.
+  EXPECT_LT(MakeDrawKey(state, 1e30f), MakeDrawKey(MakeStateKey(2), 0.f));
+}
+
+TEST(MakeDrawKey, QuantizesNearbyDepths) {
+  EXPECT_EQ(MakeDrawKey(0, 1.f), MakeDrawKey(0, 1.001f));
+  EXPECT_NE(MakeDrawKey(0, 1.f), MakeDrawKey(0, 1.01f));
+}
+
+TEST(RadixSort, HandlesEmptyAndSingleItems) {
+  std::vector<DrawItem> items, scratch;
+  RadixSort(items, scratch);
+  EXPECT_TRUE(items.empty());
+
+  items.push_back({42, 7, 1});
+  RadixSort(items, scratch);
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items[0].key, 42u);
+  EXPECT_EQ(items[0].meshIndex, 7u);
+  EXPECT_EQ(items[0].levelOfDetail, 1u);
+}
+
+TEST(RadixSort, SortsEveryKeyByte) {
+  std::vector<DrawItem> items, scratch;
+  for (std::uint32_t i = 0; i < 8; ++i) {
+    // One item per byte position, in descending key order.
+    items.push_back({std::uint64_t{1} << (8 * (7 - i)), i, 0});
+  }
+
+  RadixSort(items, scratch);
+  for (std::uint32_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(items[i].key, std::uint64_t{1} << (8 * i));
+    EXPECT_EQ(items[i].meshIndex, 7 - i);
+  }
+}
+
+TEST(RadixSort, IsStable) {
+  std::vector<DrawItem> items, scratch;
+  for (std::uint32_t i = 0; i < 100; ++i) {
+    items.push_back({MakeStateKey(i % 3), i, 0});
+  }
+
+  RadixSort(items, scratch);
+  for (std::size_t i = 1; i < items.size(); ++i) {
+    ASSERT_LE(items[i - 1].key, items[i].key);
+    if (items[i - 1].key == items[i].key) {
+      EXPECT_LT(items[i - 1].meshIndex, items[i].meshIndex);
+    }
+  }
+}
+
+TEST(RadixSort, MatchesStableSortOfDrawKeys) {
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<std::uint32_t> pipelines(0, 1000);
+  std::uniform_real_distribution<float> depths(-1.f, 500.f);
+
+  std::vector<DrawItem> items, scratch;
+  for (std::uint32_t i = 0; i < 5000; ++i) {
+    std::uint64_t const state = MakeStateKey(pipelines(generator));
+    items.push_back({MakeDrawKey(state, depths(generator)), i, i % 4});
+  }
+
+  std::vector<DrawItem> expected = items;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](DrawItem const& a, DrawItem const& b) {
+                     return a.key < b.key;
+                   });
+
+  RadixSort(items, scratch);
+  ASSERT_EQ(items.size(), expected.size());
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    EXPECT_EQ(items[i].key, expected[i].key);
+    EXPECT_EQ(items[i].meshIndex, expected[i].meshIndex);
+    EXPECT_EQ(items[i].levelOfDetail, expected[i].levelOfDetail);
+  }
+}
@@ -23,12 +23,18 @@
 #include "protos.h"
 #include "renderer/command_buffers.h"
 #include "renderer/descriptor_sets.h"
+#include "renderer/geometry_arena.h"
+#include "renderer/gpu_culling.h"
 #include "renderer/impl.h"
 #include "renderer/io/gltf.h"
 #include "renderer/io/json.h"
 #include "renderer/io/read_file.h"
+#include "renderer/material.h"
 #include "renderer/mesh.h"
+#include "renderer/render_queue.h"
 #include "renderer/shader.h"
+#include "renderer/simd.h"
+#include "renderer/upload.h"
 #include "renderer/vulkan.h"
 #include "renderer/window.h"
 #if PLATFORM_COMPILER_MSVC
@@ -39,8 +45,11 @@
 #if PLATFORM_COMPILER_MSVC
 #pragma warning(pop)
 #endif
+#include "tbb/blocked_range.h"
 #include "tbb/concurrent_queue.h"
+#include "tbb/parallel_for.h"
 #include "tbb/task.h"
+#include "tbb/task_arena.h"
 #include "tbb/task_scheduler_init.h"
 #include "wsi/window.h"
 #if PLATFORM_WINDOWS
@@ -48,8 +57,11 @@
 #elif PLATFORM_LINUX
 #include "wsi/window_x11.h"
 #endif
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #if STD_FS_IS_EXPERIMENTAL
 #include <experimental/filesystem>
 namespace filesystem = std::experimental::filesystem;
@@ -124,8 +136,13 @@ VkPhysicalDevice sPhysicalDevice{VK_NULL_HANDLE};
 std::uint32_t sGraphicsQueueFamilyIndex{UINT32_MAX};
 VkDevice sDevice{VK_NULL_HANDLE};
 VkQueue sGraphicsCommandQueue{VK_NULL_HANDLE};
-VkFence sFrameComplete{VK_NULL_HANDLE};
+std::uint32_t sTransferQueueFamilyIndex{UINT32_MAX};
+VkQueue sTransferCommandQueue{VK_NULL_HANDLE};
 VmaAllocator sAllocator{VK_NULL_HANDLE};
+bool sReduceOverdraw{false};
+
+std::uint32_t sNumFramesInFlight{2};
+std::uint32_t sFrameIndex{0};
 
 VkSurfaceFormatKHR sSurfaceColorFormat{VK_FORMAT_B8G8R8A8_UNORM,
                                        VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
@@ -140,6 +157,7 @@ std::uint32_t sDepthStencilTargetAttachmentIndex{2};
 std::uint32_t sDepthStencilResolveAttachmentIndex{3};
 
 VkRenderPass sRenderPass{VK_NULL_HANDLE};
+VkPipelineCache sPipelineCache{VK_NULL_HANDLE};
 
 glm::mat4 sViewMatrix;
 glm::mat4 sViewMatrixInverse;
@@ -152,6 +170,8 @@ glm::mat4 sViewMatrixInverse;
 
 static bool sInitialized{false};
 static std::atomic_bool sRunning{false};
+static bool sGPUCulling{false};
+static bool sQuantizeVertices{false};
 
 static tbb::task_scheduler_init sTaskSchedulerInit{
   tbb::task_scheduler_init::deferred};
@@ -160,15 +180,57 @@ static tbb::concurrent_queue<std::function<std::system_error(void)>>
 
 static std::vector<VkCommandPool> sGraphicsCommandPools;
 static std::vector<VkDescriptorPool> sGraphicsDescriptorPools;
-static VkSemaphore sImagesReadyForPresent{VK_NULL_HANDLE};
 static std::mutex sOneTimeSubmitMutex;
 static VkFence sOneTimeSubmitFence{VK_NULL_HANDLE};
 
-static std::uint32_t const sNumCommandBuffers{2};
-static absl::FixedArray<VkCommandBuffer> sCommandBuffers(sNumCommandBuffers,
-                                                         VK_NULL_HANDLE);
-static std::uint32_t sCommandBufferIndex{0};
-static std::vector<VkCommandBuffer> sSecondaryCommandBuffers;
+/*! \brief The number of bind commands a recording issued and skipped because
+ * the state was already bound.
+ */
+struct BindCounts {
+  std::uint32_t issued{0};
+  std::uint32_t elided{0};
+}; // struct BindCounts
+
+/*! \brief The secondary command buffers recorded for one window in one frame
+ * in flight, and the state they were recorded against. They are replayed
+ * every time the frame comes around until that state changes.
+ */
+struct WindowSecondaries {
+  std::uint64_t sceneGeneration{0};
+  std::uint32_t viewIndex{0};
+  VkViewport viewport{};
+  VkRect2D scissor{};
+  // The meshes that survived culling, in the sorted order they were recorded.
+  std::vector<DrawItem> draws{};
+  std::vector<VkCommandBuffer> commandBuffers{};
+  // The sGraphicsCommandPools index each of commandBuffers came from.
+  std::vector<std::size_t> threadIndices{};
+  // Binds recorded into and skipped in each of commandBuffers.
+  std::vector<BindCounts> bindCounts{};
+}; // struct WindowSecondaries
+
+/*! \brief Everything a single frame in flight records into or writes. A
+ * frame's resources are only reused after its complete fence has signaled.
+ */
+struct FrameResources {
+  VkCommandPool commandPool{VK_NULL_HANDLE};
+  VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+  // Unused secondary command buffers allocated from sGraphicsCommandPools[i]
+  // by TBB thread i. Stale recordings give their buffers back to these lists
+  // and are reset when the buffers are begun again.
+  std::vector<std::vector<VkCommandBuffer>> freeSecondaryCommandBuffers{};
+  absl::flat_hash_map<std::string, WindowSecondaries> windowSecondaries{};
+  VkFence complete{VK_NULL_HANDLE};
+  VkSemaphore imagesReadyForPresent{VK_NULL_HANDLE};
+  VkDescriptorSet baseDescriptorSet{VK_NULL_HANDLE};
+}; // struct FrameResources
+
+static std::array<FrameResources, kMaxFramesInFlight> sFrames;
+
+// Incremented whenever something the cached secondary command buffers
+// recorded changes: the mesh list (and with it the pipelines and descriptor
+// sets) or the base descriptor sets.
+static std::uint64_t sSceneGeneration{1};
 
 struct MatrixBufferData {
   glm::mat4 viewMatrix;
@@ -189,12 +251,22 @@ struct LightBufferData {
   int numLights;
 }; // struct LightBufferData
 
+// sMatrixBuffer holds one MatrixBufferData per view (window) per frame in
+// flight; the frame is selected by the descriptor offset and the view by a
+// dynamic offset. sLightBuffer holds one LightBufferData per frame in flight.
+// Both stay persistently mapped and their slices are stride bytes apart to
+// satisfy minUniformBufferOffsetAlignment.
+static constexpr std::uint32_t const kInitialMatrixBufferNumViews{8};
 static VkBuffer sMatrixBuffer{VK_NULL_HANDLE};
 static VmaAllocation sMatrixBufferAllocation{VK_NULL_HANDLE};
+static std::byte* sMatrixBufferData{nullptr};
+static VkDeviceSize sMatrixBufferStride{0};
+static std::uint32_t sMatrixBufferNumViews{0};
 static VkBuffer sLightBuffer{VK_NULL_HANDLE};
 static VmaAllocation sLightBufferAllocation{VK_NULL_HANDLE};
+static std::byte* sLightBufferData{nullptr};
+static VkDeviceSize sLightBufferStride{0};
 VkDescriptorSetLayout sBaseDescriptorSetLayout{VK_NULL_HANDLE};
-static absl::FixedArray<VkDescriptorSet> sBaseDescriptorSets(2, VK_NULL_HANDLE);
 
 static absl::flat_hash_map<std::string, iris::Renderer::Window>&
 Windows() {
@@ -207,6 +279,32 @@ static std::vector<Mesh>& Meshes() {
   return sMeshes;
 } // Meshes
 
+/*! \brief The world-space bounding spheres of Meshes() in the same order,
+ * stored as separate arrays so culling can test four meshes at a time.
+ */
+struct BoundingSpheres {
+  std::vector<float> x{};
+  std::vector<float> y{};
+  std::vector<float> z{};
+  std::vector<float> radius{};
+}; // struct BoundingSpheres
+
+static BoundingSpheres sMeshBoundingSpheres;
+
+// The state part of the render queue sort key of each of Meshes(), built
+// from ranks handed out to pipelines as meshes are added. Every mesh shares
+// the vertex buffer of the geometry arena, so it takes no part in the key.
+static std::vector<std::uint64_t> sMeshStateKeys;
+static absl::flat_hash_map<VkPipeline, std::uint32_t> sPipelineRanks;
+
+// The render queue of Meshes() grouped by state only, which GPU culling draws
+// every window from, and the sSceneGeneration it was built for.
+static std::vector<DrawItem> sStateQueue;
+static std::uint64_t sStateQueueGeneration{0};
+
+// The GeometryGeneration that the offsets in the GPU culling data are from.
+static std::uint64_t sCulledGeometryGeneration{0};
+
 std::chrono::steady_clock::time_point sPreviousFrameTime;
 absl::FixedArray<float> sFrameTimes(100);
 std::uint64_t sFrameNum = 0;
@@ -1032,23 +1130,65 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   vkGetPhysicalDeviceQueueFamilyProperties2(
     sPhysicalDevice, &numQueueFamilyProperties, queueFamilyProperties.data());
 
-  absl::FixedArray<float> priorities(
+  std::uint32_t const numGraphicsQueues =
     queueFamilyProperties[sGraphicsQueueFamilyIndex]
-      .queueFamilyProperties.queueCount);
+      .queueFamilyProperties.queueCount;
+
+  // Prefer a transfer-only family, which is usually a dedicated copy engine,
+  // then any other family that can transfer, then a second graphics queue.
+  // Failing all of those uploads share the graphics queue.
+  std::uint32_t transferQueueFamilyIndex = UINT32_MAX;
+  std::uint32_t transferQueueIndex = 0;
+
+  for (auto [i, props] : enumerate(queueFamilyProperties)) {
+    auto&& qfProps = props.queueFamilyProperties;
+    if (i == sGraphicsQueueFamilyIndex || qfProps.queueCount == 0) continue;
+
+    // Graphics and compute queues support transfers without saying so.
+    VkQueueFlags const flags = qfProps.queueFlags;
+    if (!(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT |
+                   VK_QUEUE_COMPUTE_BIT))) {
+      continue;
+    }
+
+    bool const transferOnly =
+      !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+    if (transferQueueFamilyIndex == UINT32_MAX || transferOnly) {
+      transferQueueFamilyIndex = gsl::narrow_cast<std::uint32_t>(i);
+      if (transferOnly) break;
+    }
+  }
+
+  if (transferQueueFamilyIndex == UINT32_MAX) {
+    transferQueueFamilyIndex = sGraphicsQueueFamilyIndex;
+    transferQueueIndex = (numGraphicsQueues > 1 ? 1 : 0);
+  }
+
+  absl::FixedArray<float> priorities(numGraphicsQueues);
   std::fill_n(std::begin(priorities), priorities.size(), 1.f);
 
-  VkDeviceQueueCreateInfo qci = {};
-  qci.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  qci.queueFamilyIndex = sGraphicsQueueFamilyIndex;
-  qci.queueCount = queueFamilyProperties[sGraphicsQueueFamilyIndex]
-                     .queueFamilyProperties.queueCount;
-  qci.pQueuePriorities = priorities.data();
+  absl::FixedArray<VkDeviceQueueCreateInfo> qcis(
+    transferQueueFamilyIndex == sGraphicsQueueFamilyIndex ? 1 : 2);
+
+  qcis[0] = {};
+  qcis[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  qcis[0].queueFamilyIndex = sGraphicsQueueFamilyIndex;
+  qcis[0].queueCount = numGraphicsQueues;
+  qcis[0].pQueuePriorities = priorities.data();
+
+  if (qcis.size() > 1) {
+    qcis[1] = {};
+    qcis[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    qcis[1].queueFamilyIndex = transferQueueFamilyIndex;
+    qcis[1].queueCount = 1;
+    qcis[1].pQueuePriorities = priorities.data();
+  }
 
   VkDeviceCreateInfo ci = {};
   ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
   ci.pNext = &physicalDeviceFeatures;
-  ci.queueCreateInfoCount = 1;
-  ci.pQueueCreateInfos = &qci;
+  ci.queueCreateInfoCount = gsl::narrow_cast<std::uint32_t>(qcis.size());
+  ci.pQueueCreateInfos = qcis.data();
   ci.enabledExtensionCount =
     gsl::narrow_cast<std::uint32_t>(extensionNames.size());
   ci.ppEnabledExtensionNames = extensionNames.data();
@@ -1062,8 +1202,20 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   vkGetDeviceQueue(sDevice, sGraphicsQueueFamilyIndex, 0,
                    &sGraphicsCommandQueue);
 
+  sTransferQueueFamilyIndex = transferQueueFamilyIndex;
+  vkGetDeviceQueue(sDevice, sTransferQueueFamilyIndex, transferQueueIndex,
+                   &sTransferCommandQueue);
+
+  if (sTransferCommandQueue == sGraphicsCommandQueue) {
+    GetLogger()->info("Uploads share the graphics queue");
+  } else {
+    GetLogger()->info("Uploads use queue {} of family {}", transferQueueIndex,
+                      sTransferQueueFamilyIndex);
+  }
+
   Ensures(sDevice != VK_NULL_HANDLE);
   Ensures(sGraphicsCommandQueue != VK_NULL_HANDLE);
+  Ensures(sTransferCommandQueue != VK_NULL_HANDLE);
   IRIS_LOG_LEAVE();
   return {Error::kNone};
 } // CreateDevice
@@ -1077,6 +1229,24 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   ci.queueFamilyIndex = sGraphicsQueueFamilyIndex;
 
+  // Each frame in flight resets its own pool once its fence has signaled.
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    if (auto result =
+          vkCreateCommandPool(sDevice, &ci, nullptr, &sFrames[i].commandPool);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result),
+              fmt::format("Cannot create frame command pool {}", i)};
+    }
+
+    NameObject(VK_OBJECT_TYPE_COMMAND_POOL, sFrames[i].commandPool,
+               fmt::format("sFrames:{}:commandPool", i).c_str());
+  }
+
+  // The shared pools are never reset as a whole because their command
+  // buffers may belong to different frames in flight.
+  ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
   sGraphicsCommandPools.resize(sTaskSchedulerInit.default_num_threads());
   for (auto&& [i, commandPool] : enumerate(sGraphicsCommandPools)) {
     if (auto result = vkCreateCommandPool(sDevice, &ci, nullptr, &commandPool);
@@ -1090,6 +1260,11 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
                fmt::format("sGraphicsCommandPools:{}", i).c_str());
   }
 
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    sFrames[i].freeSecondaryCommandBuffers.resize(
+      sGraphicsCommandPools.size());
+  }
+
   for (auto&& commandPool : sGraphicsCommandPools) {
     Ensures(commandPool != VK_NULL_HANDLE);
   }
@@ -1146,8 +1321,6 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
   Expects(sOneTimeSubmitFence == VK_NULL_HANDLE);
-  Expects(sFrameComplete == VK_NULL_HANDLE);
-  Expects(sImagesReadyForPresent == VK_NULL_HANDLE);
 
   VkFenceCreateInfo fci = {};
   fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -1160,32 +1333,36 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
 
   NameObject(VK_OBJECT_TYPE_FENCE, sOneTimeSubmitFence, "sOneTimeSubmitFence");
 
+  // Frame fences start signaled so the first wait on each returns at once.
   fci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-  if (auto result = vkCreateFence(sDevice, &fci, nullptr, &sFrameComplete);
-      result != VK_SUCCESS) {
-    IRIS_LOG_LEAVE();
-    return {make_error_code(result), "Cannot create fence"};
-  }
-
-  NameObject(VK_OBJECT_TYPE_FENCE, sFrameComplete, "sFrameComplete");
-
   VkSemaphoreCreateInfo sci = {};
   sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-  if (auto result =
-        vkCreateSemaphore(sDevice, &sci, nullptr, &sImagesReadyForPresent);
-      result != VK_SUCCESS) {
-    IRIS_LOG_LEAVE();
-    return {make_error_code(result), "Cannot create semaphore"};
-  }
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    auto&& frame = sFrames[i];
+
+    if (auto result = vkCreateFence(sDevice, &fci, nullptr, &frame.complete);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot create fence"};
+    }
+
+    NameObject(VK_OBJECT_TYPE_FENCE, frame.complete,
+               fmt::format("sFrames:{}:complete", i).c_str());
 
-  NameObject(VK_OBJECT_TYPE_SEMAPHORE, sImagesReadyForPresent,
-             "sImagesReadyForPresent");
+    if (auto result = vkCreateSemaphore(sDevice, &sci, nullptr,
+                                        &frame.imagesReadyForPresent);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot create semaphore"};
+    }
+
+    NameObject(VK_OBJECT_TYPE_SEMAPHORE, frame.imagesReadyForPresent,
+               fmt::format("sFrames:{}:imagesReadyForPresent", i).c_str());
+  }
 
   Ensures(sOneTimeSubmitFence != VK_NULL_HANDLE);
-  Ensures(sFrameComplete != VK_NULL_HANDLE);
-  Ensures(sImagesReadyForPresent != VK_NULL_HANDLE);
   IRIS_LOG_LEAVE();
   return {Error::kNone};
 } // CreateFencesAndSemaphores
@@ -1357,88 +1534,293 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   return {Error::kNone};
 } // CreateRenderPass
 
-[[nodiscard]] static std::system_error AllocateCommandBuffers() noexcept {
+static filesystem::path PipelineCachePath() noexcept {
+  return io::CacheDirectory() / "pipeline_cache.bin";
+} // PipelineCachePath
+
+/*! \brief Create sPipelineCache, seeded with the data saved by the previous
+ * run if it was written by the same device and driver.
+ */
+[[nodiscard]] static std::system_error CreatePipelineCache() noexcept {
   IRIS_LOG_ENTER();
+  Expects(sPhysicalDevice != VK_NULL_HANDLE);
   Expects(sDevice != VK_NULL_HANDLE);
-  Expects(sNumCommandBuffers == sCommandBuffers.size());
-  for (auto&& commandBuffer : sCommandBuffers) {
-    Expects(commandBuffer == VK_NULL_HANDLE);
+  Expects(sPipelineCache == VK_NULL_HANDLE);
+
+  VkPhysicalDeviceProperties physicalDeviceProperties;
+  vkGetPhysicalDeviceProperties(sPhysicalDevice, &physicalDeviceProperties);
+
+  std::vector<std::byte> initialData;
+  filesystem::path const path = PipelineCachePath();
+
+  if (filesystem::exists(path)) {
+    if (auto bytes = io::ReadFile(path)) initialData = std::move(*bytes);
+
+    // Some drivers do not validate the header themselves, so only hand over
+    // data whose header matches this device.
+    struct Header {
+      std::uint32_t length;
+      std::uint32_t version;
+      std::uint32_t vendorID;
+      std::uint32_t deviceID;
+      std::uint8_t uuid[VK_UUID_SIZE];
+    } header;
+
+    if (initialData.size() >= sizeof(header)) {
+      std::memcpy(&header, initialData.data(), sizeof(header));
+    }
+
+    if (initialData.size() < sizeof(header) ||
+        header.version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != physicalDeviceProperties.vendorID ||
+        header.deviceID != physicalDeviceProperties.deviceID ||
+        std::memcmp(header.uuid, physicalDeviceProperties.pipelineCacheUUID,
+                    VK_UUID_SIZE) != 0) {
+      GetLogger()->info("Ignoring stale pipeline cache {}", path.string());
+      initialData.clear();
+    }
   }
 
-  VkCommandBufferAllocateInfo ai = {};
-  ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  ai.commandPool = sGraphicsCommandPools[0];
-  ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  ai.commandBufferCount = sNumCommandBuffers;
+  VkPipelineCacheCreateInfo pipelineCacheCI = {};
+  pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  pipelineCacheCI.initialDataSize = initialData.size();
+  pipelineCacheCI.pInitialData = initialData.data();
+
+  if (auto result = vkCreatePipelineCache(sDevice, &pipelineCacheCI, nullptr,
+                                          &sPipelineCache);
+      result != VK_SUCCESS) {
+    IRIS_LOG_LEAVE();
+    return {make_error_code(result), "Cannot create pipeline cache"};
+  }
+
+  if (!initialData.empty()) {
+    GetLogger()->debug("Loaded {} bytes of pipeline cache from {}",
+                       initialData.size(), path.string());
+  }
+
+  NameObject(VK_OBJECT_TYPE_PIPELINE_CACHE, sPipelineCache, "sPipelineCache");
+
+  Ensures(sPipelineCache != VK_NULL_HANDLE);
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // CreatePipelineCache
+
+//! \brief Write sPipelineCache to disk for the next run.
+static void SavePipelineCache() noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sPipelineCache != VK_NULL_HANDLE);
+
+  std::size_t size = 0;
+  if (auto result =
+        vkGetPipelineCacheData(sDevice, sPipelineCache, &size, nullptr);
+      result != VK_SUCCESS || size == 0) {
+    IRIS_LOG_LEAVE();
+    return;
+  }
 
+  std::vector<std::byte> data(size);
   if (auto result =
-        vkAllocateCommandBuffers(sDevice, &ai, sCommandBuffers.data());
+        vkGetPipelineCacheData(sDevice, sPipelineCache, &size, data.data());
       result != VK_SUCCESS) {
+    GetLogger()->warn("Cannot get pipeline cache data: {}",
+                      to_string(result));
     IRIS_LOG_LEAVE();
-    return {make_error_code(result), "Cannot allocate command buffers"};
+    return;
   }
+  data.resize(size);
 
-  for (auto&& commandBuffer : sCommandBuffers) {
-    NameObject(VK_OBJECT_TYPE_COMMAND_BUFFER, commandBuffer, "sCommandBuffers");
-    Ensures(commandBuffer != VK_NULL_HANDLE);
+  if (auto error = io::WriteFile(PipelineCachePath(), data); error.code()) {
+    GetLogger()->warn("Cannot write pipeline cache: {}", error.what());
+  }
+
+  IRIS_LOG_LEAVE();
+} // SavePipelineCache
+
+[[nodiscard]] static std::system_error AllocateCommandBuffers() noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+
+  VkCommandBufferAllocateInfo ai = {};
+  ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  ai.commandBufferCount = 1;
+
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    auto&& frame = sFrames[i];
+    Expects(frame.commandPool != VK_NULL_HANDLE);
+    Expects(frame.commandBuffer == VK_NULL_HANDLE);
+
+    ai.commandPool = frame.commandPool;
+
+    if (auto result =
+          vkAllocateCommandBuffers(sDevice, &ai, &frame.commandBuffer);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot allocate command buffers"};
+    }
+
+    NameObject(VK_OBJECT_TYPE_COMMAND_BUFFER, frame.commandBuffer,
+               fmt::format("sFrames:{}:commandBuffer", i).c_str());
+    Ensures(frame.commandBuffer != VK_NULL_HANDLE);
   }
 
   IRIS_LOG_LEAVE();
   return {Error::kNone};
 } // AllocateCommandBuffers
 
-[[nodiscard]] static std::system_error CreateUniformBuffers() noexcept {
+[[nodiscard]] static std::system_error
+CreateMatrixBuffer(std::uint32_t numViews) noexcept {
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
+  Expects(sMatrixBuffer == VK_NULL_HANDLE);
+  Expects(sMatrixBufferStride > 0);
 
   VkBufferCreateInfo bufferCI = {};
   bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  bufferCI.size = static_cast<std::uint32_t>(sizeof(MatrixBufferData));
+  bufferCI.size = sMatrixBufferStride * numViews * sNumFramesInFlight;
   bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 
   std::string matrixBufferName = "sMatrixBuffer";
 
   VmaAllocationCreateInfo allocationCI = {};
   allocationCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT |
+                       VMA_ALLOCATION_CREATE_MAPPED_BIT;
   allocationCI.pUserData = matrixBufferName.data();
 
+  VmaAllocationInfo allocationInfo;
   if (auto result =
         vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI, &sMatrixBuffer,
-                        &sMatrixBufferAllocation, nullptr);
+                        &sMatrixBufferAllocation, &allocationInfo);
       result != VK_SUCCESS) {
     IRIS_LOG_LEAVE();
     return {make_error_code(result), "Error creating sMatrixBuffer"};
   }
 
-  bufferCI.size = static_cast<std::uint32_t>(sizeof(LightBufferData));
+  NameObject(VK_OBJECT_TYPE_BUFFER, sMatrixBuffer, "sMatrixBuffer");
+
+  sMatrixBufferData = static_cast<std::byte*>(allocationInfo.pMappedData);
+  sMatrixBufferNumViews = numViews;
+
+  Ensures(sMatrixBuffer != VK_NULL_HANDLE);
+  Ensures(sMatrixBufferData != nullptr);
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // CreateMatrixBuffer
+
+[[nodiscard]] static std::system_error CreateUniformBuffers() noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sDevice != VK_NULL_HANDLE);
+
+  VkPhysicalDeviceProperties physicalDeviceProperties;
+  vkGetPhysicalDeviceProperties(sPhysicalDevice, &physicalDeviceProperties);
+  VkDeviceSize const alignment =
+    physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+
+  auto const alignUp = [alignment](VkDeviceSize size) {
+    return (size + alignment - 1) / alignment * alignment;
+  };
+
+  sMatrixBufferStride = alignUp(sizeof(MatrixBufferData));
+  sLightBufferStride = alignUp(sizeof(LightBufferData));
+
+  if (auto error = CreateMatrixBuffer(kInitialMatrixBufferNumViews);
+      error.code()) {
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  VkBufferCreateInfo bufferCI = {};
+  bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCI.size = sLightBufferStride * sNumFramesInFlight;
+  bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
   std::string lightBufferName = "sLightBuffer";
+
+  VmaAllocationCreateInfo allocationCI = {};
+  allocationCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT |
+                       VMA_ALLOCATION_CREATE_MAPPED_BIT;
   allocationCI.pUserData = lightBufferName.data();
 
+  VmaAllocationInfo allocationInfo;
   if (auto result =
         vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI, &sLightBuffer,
-                        &sLightBufferAllocation, nullptr);
+                        &sLightBufferAllocation, &allocationInfo);
       result != VK_SUCCESS) {
     IRIS_LOG_LEAVE();
     return {make_error_code(result), "Error creating sLightBuffer"};
   }
 
-  NameObject(VK_OBJECT_TYPE_BUFFER, sMatrixBuffer, "sMatrixBuffer");
   NameObject(VK_OBJECT_TYPE_BUFFER, sLightBuffer, "sLightBuffer");
+  sLightBufferData = static_cast<std::byte*>(allocationInfo.pMappedData);
 
   Ensures(sMatrixBuffer != VK_NULL_HANDLE);
   Ensures(sLightBuffer != VK_NULL_HANDLE);
+  Ensures(sLightBufferData != nullptr);
   IRIS_LOG_LEAVE();
   return {Error::kNone};
 } // CreateUniformBuffers
 
+//! \brief Point every frame's base descriptor set at its slices of
+//! sMatrixBuffer and sLightBuffer.
+static void WriteBaseDescriptorSets() noexcept {
+  IRIS_LOG_ENTER();
+
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    auto&& frame = sFrames[i];
+    Expects(frame.baseDescriptorSet != VK_NULL_HANDLE);
+
+    VkDescriptorBufferInfo matrixBufferInfo;
+    matrixBufferInfo.buffer = sMatrixBuffer;
+    matrixBufferInfo.offset = sMatrixBufferStride * sMatrixBufferNumViews * i;
+    matrixBufferInfo.range = sizeof(MatrixBufferData);
+
+    VkDescriptorBufferInfo lightBufferInfo;
+    lightBufferInfo.buffer = sLightBuffer;
+    lightBufferInfo.offset = sLightBufferStride * i;
+    lightBufferInfo.range = sizeof(LightBufferData);
+
+    absl::FixedArray<VkWriteDescriptorSet> writeDescriptorSets(2);
+
+    writeDescriptorSets[0] = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,                                   // pNext
+      frame.baseDescriptorSet,                   // dstSet
+      0,                                         // dstBinding
+      0,                                         // dstArrayElement
+      1,                                         // descriptorCount
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, // descriptorType
+      nullptr,                                   // pImageInfo
+      &matrixBufferInfo,                         // pBufferInfo
+      nullptr                                    // pTexelBufferView
+    };
+
+    writeDescriptorSets[1] = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,                                   // pNext
+      frame.baseDescriptorSet,                   // dstSet
+      1,                                         // dstBinding
+      0,                                         // dstArrayElement
+      1,                                         // descriptorCount
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         // descriptorType
+      nullptr,                                   // pImageInfo
+      &lightBufferInfo,                          // pBufferInfo
+      nullptr                                    // pTexelBufferView
+    };
+
+    UpdateDescriptorSets(writeDescriptorSets);
+  }
+
+  IRIS_LOG_LEAVE();
+} // WriteBaseDescriptorSets
+
 [[nodiscard]] static std::system_error CreateDescriptorSets() noexcept {
   IRIS_LOG_ENTER();
   Expects(sDevice != VK_NULL_HANDLE);
 
-  absl::FixedArray<VkDescriptorSetLayoutBinding> bindings(
-    sBaseDescriptorSets.size());
-  bindings[0] = {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+  absl::FixedArray<VkDescriptorSetLayoutBinding> bindings(2);
+  bindings[0] = {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
                  VK_SHADER_STAGE_ALL_GRAPHICS, nullptr};
   bindings[1] = {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
                  VK_SHADER_STAGE_ALL_GRAPHICS, nullptr};
@@ -1459,73 +1841,441 @@ CreateDeviceAndQueues(VkPhysicalDeviceFeatures2 physicalDeviceFeatures,
   NameObject(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, sBaseDescriptorSetLayout,
              "sBaseDescriptorSetLayout");
 
-  absl::FixedArray<VkDescriptorSetLayout> layouts(sBaseDescriptorSets.size(),
-                                                  sBaseDescriptorSetLayout);
-
   VkDescriptorSetAllocateInfo descriptorSetAI = {};
   descriptorSetAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   descriptorSetAI.descriptorPool = sGraphicsDescriptorPools[0];
-  descriptorSetAI.descriptorSetCount = static_cast<uint32_t>(layouts.size());
-  descriptorSetAI.pSetLayouts = layouts.data();
+  descriptorSetAI.descriptorSetCount = 1;
+  descriptorSetAI.pSetLayouts = &sBaseDescriptorSetLayout;
 
-  if (auto result = vkAllocateDescriptorSets(sDevice, &descriptorSetAI,
-                                             sBaseDescriptorSets.data());
-      result != VK_SUCCESS) {
-    IRIS_LOG_LEAVE();
-    return {make_error_code(result), "Cannot create descriptor set"};
-  }
-
-  VkDescriptorBufferInfo modelBufferInfo;
-  modelBufferInfo.buffer = sMatrixBuffer;
-  modelBufferInfo.offset = 0;
-  modelBufferInfo.range = VK_WHOLE_SIZE;
-
-  VkDescriptorBufferInfo materialBufferInfo;
-  materialBufferInfo.buffer = sLightBuffer;
-  materialBufferInfo.offset = 0;
-  materialBufferInfo.range = VK_WHOLE_SIZE;
-
-  absl::FixedArray<VkWriteDescriptorSet> writeDescriptorSets(2);
-
-  writeDescriptorSets[0] = {
-    VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    nullptr,                           // pNext
-    sBaseDescriptorSets[0],            // dstSet
-    0,                                 // dstBinding
-    0,                                 // dstArrayElement
-    1,                                 // descriptorCount
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, // descriptorType
-    nullptr,                           // pImageInfo
-    &modelBufferInfo,                  // pBufferInfo
-    nullptr                            // pTexelBufferView
-  };
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    auto&& frame = sFrames[i];
 
-  writeDescriptorSets[1] = {
-    VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    nullptr,                           // pNext
-    sBaseDescriptorSets[0],            // dstSet
-    1,                                 // dstBinding
-    0,                                 // dstArrayElement
-    1,                                 // descriptorCount
-    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, // descriptorType
-    nullptr,                           // pImageInfo
-    &materialBufferInfo,               // pBufferInfo
-    nullptr                            // pTexelBufferView
-  };
+    if (auto result = vkAllocateDescriptorSets(sDevice, &descriptorSetAI,
+                                               &frame.baseDescriptorSet);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot create descriptor set"};
+    }
+  }
 
-  UpdateDescriptorSets(writeDescriptorSets);
+  WriteBaseDescriptorSets();
 
   Ensures(sBaseDescriptorSetLayout != VK_NULL_HANDLE);
   IRIS_LOG_LEAVE();
   return {Error::kNone};
 } // CreateDescriptorSets
 
+/*! \brief Make sure sMatrixBuffer has a slice for \p numViews views in every
+ * frame. Growing it waits for the device to go idle, which only happens when
+ * windows are added.
+ */
+[[nodiscard]] static std::system_error
+ReserveMatrixBufferViews(std::uint32_t numViews) noexcept {
+  if (numViews <= sMatrixBufferNumViews) return {Error::kNone};
+  IRIS_LOG_ENTER();
+
+  vkDeviceWaitIdle(sDevice);
+  vmaDestroyBuffer(sAllocator, sMatrixBuffer, sMatrixBufferAllocation);
+  sMatrixBuffer = VK_NULL_HANDLE;
+  sMatrixBufferAllocation = VK_NULL_HANDLE;
+  sMatrixBufferData = nullptr;
+
+  if (auto error =
+        CreateMatrixBuffer(std::max(numViews, sMatrixBufferNumViews * 2));
+      error.code()) {
+    sMatrixBufferNumViews = 0;
+    IRIS_LOG_LEAVE();
+    return error;
+  }
+
+  WriteBaseDescriptorSets();
+  sSceneGeneration++;
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // ReserveMatrixBufferViews
+
+/*! \brief The smallest draw range worth recording into its own secondary
+ * command buffer; below this the cost of vkCmdExecuteCommands dominates.
+ */
+static constexpr std::size_t const kMinDrawsPerSecondary{64};
+
+//! The screen-space error in pixels a level of detail may project to.
+static constexpr float const kLevelOfDetailPixelError{1.f};
+
+/*! \brief Get a secondary command buffer for the calling TBB thread from its
+ * pool in sGraphicsCommandPools, allocating a new one when \p frame holds no
+ * free ones for that thread.
+ */
+static VkCommandBuffer
+GetThreadSecondaryCommandBuffer(FrameResources& frame,
+                                std::size_t threadIndex) noexcept {
+  auto&& freeCommandBuffers = frame.freeSecondaryCommandBuffers[threadIndex];
+  if (!freeCommandBuffers.empty()) {
+    VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+    freeCommandBuffers.pop_back();
+    return commandBuffer;
+  }
+
+  VkCommandBufferAllocateInfo commandBufferAI = {};
+  commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  commandBufferAI.commandPool = sGraphicsCommandPools[threadIndex];
+  commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+  commandBufferAI.commandBufferCount = 1;
+
+  VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+  if (auto result =
+        vkAllocateCommandBuffers(sDevice, &commandBufferAI, &commandBuffer);
+      result != VK_SUCCESS) {
+    GetLogger()->error(
+      "Renderer::Frame: allocating secondary command buffer failed: {}",
+      to_string(result));
+    return VK_NULL_HANDLE;
+  }
+
+  return commandBuffer;
+} // GetThreadSecondaryCommandBuffer
+
+/*! \brief Give the command buffers of a stale recording back to the free
+ * lists of the pools they came from.
+ */
+static void ReleaseWindowSecondaries(FrameResources& frame,
+                                     WindowSecondaries& secondaries) noexcept {
+  for (auto&& [i, commandBuffer] : enumerate(secondaries.commandBuffers)) {
+    if (commandBuffer == VK_NULL_HANDLE) continue;
+    frame.freeSecondaryCommandBuffers[secondaries.threadIndices[i]].push_back(
+      commandBuffer);
+  }
+
+  secondaries.commandBuffers.clear();
+  secondaries.threadIndices.clear();
+} // ReleaseWindowSecondaries
+
+//! \brief The input to the GPU culling pass for \p mesh.
+static MeshCullData MakeMeshCullData(Mesh const& mesh) noexcept {
+  MeshCullData cullData;
+  cullData.boundingSphere = mesh.boundingSphere;
+  cullData.numIndices = mesh.numIndices;
+  cullData.numVertices = mesh.numVertices;
+  cullData.numInstances = mesh.numInstances;
+  cullData.firstIndex = mesh.FirstIndex();
+  cullData.vertexOffset = mesh.VertexOffset();
+
+  cullData.numLevels = gsl::narrow_cast<std::uint32_t>(
+    std::min(mesh.levelsOfDetail.size(), cullData.levels.size()));
+  for (std::uint32_t i = 0; i < cullData.numLevels; ++i) {
+    auto&& level = mesh.levelsOfDetail[i];
+    cullData.levels[i] = {level.firstIndex, level.numIndices, level.error};
+  }
+
+  return cullData;
+} // MakeMeshCullData
+
+/*! \brief The number of pixels a unit of error at unit distance projects to
+ * in \p window, divided by kLevelOfDetailPixelError.
+ */
+static float LevelOfDetailScale(Window const& window) noexcept {
+  return std::abs(window.projectionMatrix[1][1]) *
+         std::abs(window.surface.viewport.height) * 0.5f /
+         kLevelOfDetailPixelError;
+} // LevelOfDetailScale
+
+/*! \brief The coarsest level of detail of \p mesh whose error stays within
+ * kLevelOfDetailPixelError when seen from \p viewPosition, where
+ * \p levelOfDetailScale is from LevelOfDetailScale. The distance is to the
+ * near side of the bounding sphere, so the level is never too coarse for
+ * any part or instance of the mesh.
+ */
+static std::uint32_t SelectLevelOfDetail(Mesh const& mesh,
+                                         glm::vec3 const& viewPosition,
+                                         float levelOfDetailScale) noexcept {
+  float const distance =
+    glm::length(glm::vec3(mesh.boundingSphere) - viewPosition) -
+    mesh.boundingSphere.w;
+  // Also catches the NaN distance of meshes without bounds.
+  if (!(distance > 0.f)) return 0;
+
+  std::uint32_t levelOfDetail = 0;
+  for (auto&& [i, level] : enumerate(mesh.levelsOfDetail)) {
+    if (level.error * levelOfDetailScale > distance) break;
+    levelOfDetail = gsl::narrow_cast<std::uint32_t>(i + 1);
+  }
+
+  return levelOfDetail;
+} // SelectLevelOfDetail
+
+/*! \brief Extract the clip planes of \p viewProjectionMatrix for a [0, 1]
+ * depth range, normalized so the signed distance to a center can be compared
+ * with a radius.
+ */
+static std::array<glm::vec4, 6>
+FrustumPlanes(glm::mat4 const& viewProjectionMatrix) noexcept {
+  auto const row = [&viewProjectionMatrix](int i) {
+    return glm::vec4(viewProjectionMatrix[0][i], viewProjectionMatrix[1][i],
+                     viewProjectionMatrix[2][i], viewProjectionMatrix[3][i]);
+  };
+
+  std::array<glm::vec4, 6> planes = {{
+    row(3) + row(0), // left
+    row(3) - row(0), // right
+    row(3) + row(1), // top
+    row(3) - row(1), // bottom
+    row(2),          // near
+    row(3) - row(2), // far
+  }};
+  for (auto&& plane : planes) plane /= glm::length(glm::vec3(plane));
+
+  return planes;
+} // FrustumPlanes
+
+/*! \brief Test the bounding sphere of every mesh against the frustum of
+ * \p viewProjectionMatrix, setting \p visible to 1 for each mesh that is at
+ * least partly inside and 0 otherwise.
+ * \return the number of visible meshes.
+ */
+static std::size_t CullMeshes(glm::mat4 const& viewProjectionMatrix,
+                              gsl::span<std::uint8_t> visible) noexcept {
+  auto&& spheres = sMeshBoundingSpheres;
+  std::size_t const numMeshes = spheres.x.size();
+  Expects(static_cast<std::size_t>(visible.size()) == numMeshes);
+
+  std::array<glm::vec4, 6> const planes =
+    FrustumPlanes(viewProjectionMatrix);
+
+  std::size_t i = 0;
+
+#if IRIS_RENDERER_HAS_SSE2
+  for (; i + 4 <= numMeshes; i += 4) {
+    __m128 const x = _mm_loadu_ps(&spheres.x[i]);
+    __m128 const y = _mm_loadu_ps(&spheres.y[i]);
+    __m128 const z = _mm_loadu_ps(&spheres.z[i]);
+    __m128 const negRadius =
+      _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+    __m128 inside = _mm_cmpeq_ps(x, x);
+
+    for (auto&& plane : planes) {
+      __m128 const distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)),
+                   _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+        _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)),
+                   _mm_set1_ps(plane.w)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+    }
+
+    int const mask = _mm_movemask_ps(inside);
+    visible[i] = static_cast<std::uint8_t>(mask & 1);
+    visible[i + 1] = static_cast<std::uint8_t>((mask >> 1) & 1);
+    visible[i + 2] = static_cast<std::uint8_t>((mask >> 2) & 1);
+    visible[i + 3] = static_cast<std::uint8_t>((mask >> 3) & 1);
+  }
+#endif
+
+  for (; i < numMeshes; ++i) {
+    glm::vec4 const center(spheres.x[i], spheres.y[i], spheres.z[i], 1.f);
+    visible[i] = std::all_of(
+      planes.begin(), planes.end(), [&](glm::vec4 const& plane) {
+        return glm::dot(plane, center) >= -spheres.radius[i];
+      });
+  }
+
+  return static_cast<std::size_t>(
+    std::count(visible.begin(), visible.end(), std::uint8_t{1}));
+} // CullMeshes
+
+/*! \brief Build the sorted render queue of the meshes marked in \p visible:
+ * grouped by state and front to back from the viewpoint of \p viewMatrix,
+ * each at the level of detail SelectLevelOfDetail picks for
+ * \p levelOfDetailScale.
+ */
+static void SortDraws(glm::mat4 const& viewMatrix,
+                      float levelOfDetailScale,
+                      gsl::span<std::uint8_t const> visible,
+                      std::vector<DrawItem>& draws,
+                      std::vector<DrawItem>& scratch) noexcept {
+  auto&& spheres = sMeshBoundingSpheres;
+  auto&& meshes = Meshes();
+  draws.clear();
+
+  glm::vec3 const viewPosition(glm::inverse(viewMatrix)[3]);
+
+  // The view looks down -z, so the distance is the negated view-space z.
+  glm::vec4 const row2(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2],
+                       viewMatrix[3][2]);
+
+  for (auto&& [i, isVisible] : enumerate(visible)) {
+    if (!isVisible) continue;
+    float const depth = -(row2.x * spheres.x[i] + row2.y * spheres.y[i] +
+                          row2.z * spheres.z[i] + row2.w);
+    draws.push_back(
+      {MakeDrawKey(sMeshStateKeys[i], depth),
+       gsl::narrow_cast<std::uint32_t>(i),
+       SelectLevelOfDetail(meshes[i], viewPosition, levelOfDetailScale)});
+  }
+
+  RadixSort(draws, scratch);
+} // SortDraws
+
+/*! \brief The render queue of every mesh grouped by state only, for GPU
+ * culling. The order does not depend on the view, so it is only rebuilt
+ * when the scene changes.
+ */
+static std::vector<DrawItem> const& StateQueue() noexcept {
+  if (sStateQueueGeneration == sSceneGeneration) return sStateQueue;
+
+  std::vector<DrawItem> scratch;
+  sStateQueue.clear();
+  for (auto&& [i, stateKey] : enumerate(sMeshStateKeys)) {
+    sStateQueue.push_back({stateKey, gsl::narrow_cast<std::uint32_t>(i)});
+  }
+
+  RadixSort(sStateQueue, scratch);
+  sStateQueueGeneration = sSceneGeneration;
+  return sStateQueue;
+} // StateQueue
+
+/*! \brief Record \p draws of \p meshes into \p commandBuffer, continuing
+ * the render pass of \p window and using the matrix slice at
+ * \p matrixBufferOffset. Binds of the state already bound by the previous
+ * draw are skipped and counted in \p bindCounts. Nothing that changes per
+ * frame is recorded, so the command buffer can be replayed until the scene
+ * or the window changes.
+ *
+ * If \p drawCommandBuffer is not VK_NULL_HANDLE, each mesh is drawn
+ * indirectly from its slot in the region at \p drawCommandOffset, which the
+ * GPU culling pass fills in every frame.
+ */
+static void
+RecordSecondaryCommandBuffer(VkCommandBuffer commandBuffer,
+                             Window const& window,
+                             VkDescriptorSet baseDescriptorSet,
+                             std::uint32_t matrixBufferOffset,
+                             gsl::span<Mesh const> meshes,
+                             gsl::span<DrawItem const> draws,
+                             VkBuffer drawCommandBuffer,
+                             VkDeviceSize drawCommandOffset,
+                             BindCounts& bindCounts) noexcept {
+  VkCommandBufferInheritanceInfo inheritanceInfo = {};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.renderPass = sRenderPass;
+  // Leave the framebuffer unspecified: the swapchain image changes every
+  // frame and the recording must stay valid for all of them.
+  inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+  if (auto result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+      result != VK_SUCCESS) {
+    GetLogger()->error(
+      "Renderer::Frame: begin secondary command buffer failed: {}",
+      to_string(result));
+    return;
+  }
+
+  vkCmdSetViewport(commandBuffer, 0, 1, &window.surface.viewport);
+  vkCmdSetScissor(commandBuffer, 0, 1, &window.surface.scissor);
+
+  std::array<VkDescriptorSet, 2> descriptorSets;
+  descriptorSets[0] = baseDescriptorSet;
+
+  // Every mesh draws from the geometry arena, so these are bound once.
+  VkBuffer const vertexBuffer = GeometryBuffer(GeometryKind::kVertex);
+  VkBuffer const indexBuffer = GeometryBuffer(GeometryKind::kIndex);
+
+  VkPipeline boundPipeline{VK_NULL_HANDLE};
+  VkPipelineLayout boundLayout{VK_NULL_HANDLE};
+  VkDescriptorSet boundMeshSet{VK_NULL_HANDLE};
+  VkBuffer boundVertexBuffer{VK_NULL_HANDLE};
+  VkBuffer boundIndexBuffer{VK_NULL_HANDLE};
+
+  for (auto&& draw : draws) {
+    auto&& mesh = meshes[draw.meshIndex];
+
+    if (mesh.pipeline->handle != boundPipeline) {
+      vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        *mesh.pipeline);
+      boundPipeline = mesh.pipeline->handle;
+      bindCounts.issued++;
+    } else {
+      bindCounts.elided++;
+    }
+
+    // The base set stays bound as long as the layout does; only the mesh set
+    // changes from draw to draw, and then only set 1 is rebound.
+    descriptorSets[1] = mesh.descriptorSets.sets[0];
+    if (mesh.pipeline->layout != boundLayout) {
+      vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh.pipeline->layout,
+        0, gsl::narrow_cast<std::uint32_t>(descriptorSets.size()),
+        descriptorSets.data(), 1, &matrixBufferOffset);
+      boundLayout = mesh.pipeline->layout;
+      boundMeshSet = descriptorSets[1];
+      bindCounts.issued++;
+    } else if (descriptorSets[1] != boundMeshSet) {
+      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              mesh.pipeline->layout, 1, 1, &descriptorSets[1],
+                              0, nullptr);
+      boundMeshSet = descriptorSets[1];
+      bindCounts.issued++;
+    } else {
+      bindCounts.elided++;
+    }
+
+    if (vertexBuffer != boundVertexBuffer) {
+      VkDeviceSize bindingOffset = 0;
+      vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer,
+                             &bindingOffset);
+      boundVertexBuffer = vertexBuffer;
+      bindCounts.issued++;
+    } else {
+      bindCounts.elided++;
+    }
+
+    VkDeviceSize const slotOffset =
+      drawCommandOffset + kDrawCommandStride * draw.meshIndex;
+
+    if (mesh.numIndices > 0) {
+      if (indexBuffer != boundIndexBuffer) {
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0,
+                             VK_INDEX_TYPE_UINT32);
+        boundIndexBuffer = indexBuffer;
+        bindCounts.issued++;
+      } else {
+        bindCounts.elided++;
+      }
+      if (drawCommandBuffer != VK_NULL_HANDLE) {
+        vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, slotOffset,
+                                 1, 0);
+      } else {
+        vkCmdDrawIndexed(commandBuffer, mesh.NumIndices(draw.levelOfDetail),
+                         mesh.numInstances,
+                         mesh.FirstIndex(draw.levelOfDetail),
+                         mesh.VertexOffset(), 0);
+      }
+    } else if (drawCommandBuffer != VK_NULL_HANDLE) {
+      vkCmdDrawIndirect(commandBuffer, drawCommandBuffer, slotOffset, 1, 0);
+    } else {
+      vkCmdDraw(commandBuffer, mesh.numVertices, mesh.numInstances,
+                gsl::narrow_cast<std::uint32_t>(mesh.VertexOffset()), 0);
+    }
+  }
+
+  if (auto result = vkEndCommandBuffer(commandBuffer); result != VK_SUCCESS) {
+    GetLogger()->error(
+      "Renderer::Frame: end secondary command buffer failed: {}",
+      to_string(result));
+  }
+} // RecordSecondaryCommandBuffer
+
 } // namespace iris::Renderer
 
 std::system_error
 iris::Renderer::Initialize(gsl::czstring<> appName, Options const& options,
                            std::uint32_t appVersion,
-                           spdlog::sinks_init_list logSinks) noexcept {
+                           spdlog::sinks_init_list logSinks,
+                           std::uint32_t numFramesInFlight) noexcept {
   GetLogger(logSinks);
   IRIS_LOG_ENTER();
 
@@ -1534,6 +2284,16 @@ iris::Renderer::Initialize(gsl::czstring<> appName, Options const& options,
     return {Error::kAlreadyInitialized};
   }
 
+  sNumFramesInFlight =
+    std::clamp(numFramesInFlight, std::uint32_t{1}, kMaxFramesInFlight);
+  sFrameIndex = 0;
+  sGPUCulling = (options & Options::kGPUCulling) == Options::kGPUCulling;
+  sQuantizeVertices =
+    (options & Options::kQuantizeVertices) == Options::kQuantizeVertices;
+  sReduceOverdraw =
+    (options & Options::kReduceOverdraw) == Options::kReduceOverdraw;
+  GetLogger()->debug("Number of frames in flight: {}", sNumFramesInFlight);
+
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   sTaskSchedulerInit.initialize();
@@ -1663,11 +2423,21 @@ iris::Renderer::Initialize(gsl::czstring<> appName, Options const& options,
     return {error};
   }
 
+  if (auto error = InitializeUploads(); error.code()) {
+    IRIS_LOG_LEAVE();
+    return {error};
+  }
+
   if (auto error = CreateRenderPass(); error.code()) {
     IRIS_LOG_LEAVE();
     return {error};
   }
 
+  if (auto error = CreatePipelineCache(); error.code()) {
+    IRIS_LOG_LEAVE();
+    return {error};
+  }
+
   if (auto error = AllocateCommandBuffers(); error.code()) {
     IRIS_LOG_LEAVE();
     return {error};
@@ -1683,6 +2453,13 @@ iris::Renderer::Initialize(gsl::czstring<> appName, Options const& options,
     return {error};
   }
 
+  if (sGPUCulling) {
+    if (auto error = InitializeGPUCulling(); error.code()) {
+      IRIS_LOG_LEAVE();
+      return {error};
+    }
+  }
+
   sInitialized = true;
   sRunning = true;
 
@@ -1704,7 +2481,24 @@ void iris::Renderer::Shutdown() noexcept {
   vkDeviceWaitIdle(sDevice);
 
   Meshes().clear();
+  sMeshBoundingSpheres = {};
+  sMeshStateKeys.clear();
+  sPipelineRanks.clear();
+  sStateQueue.clear();
+  sStateQueueGeneration = 0;
+  sCulledGeometryGeneration = 0;
   Windows().clear();
+  ShutdownGPUCulling();
+  ReleaseGeometryArenas();
+  ShutdownUploads();
+  ReleaseGraphicsPipelines();
+  ReleaseShaderVariants();
+  ReleaseDescriptorSetLayouts();
+
+  if (sPipelineCache != VK_NULL_HANDLE) {
+    SavePipelineCache();
+    vkDestroyPipelineCache(sDevice, sPipelineCache, nullptr);
+  }
 
   if (sMatrixBuffer != VK_NULL_HANDLE ||
       sMatrixBufferAllocation != VK_NULL_HANDLE) {
@@ -1720,22 +2514,24 @@ void iris::Renderer::Shutdown() noexcept {
     vkDestroyDescriptorSetLayout(sDevice, sBaseDescriptorSetLayout, nullptr);
   }
 
-  vkFreeCommandBuffers(sDevice, sGraphicsCommandPools[0],
-                       gsl::narrow_cast<std::uint32_t>(sCommandBuffers.size()),
-                       sCommandBuffers.data());
-
   if (sRenderPass != VK_NULL_HANDLE) {
     vkDestroyRenderPass(sDevice, sRenderPass, nullptr);
   }
 
   if (sAllocator != VK_NULL_HANDLE) { vmaDestroyAllocator(sAllocator); }
 
-  if (sImagesReadyForPresent != VK_NULL_HANDLE) {
-    vkDestroySemaphore(sDevice, sImagesReadyForPresent, nullptr);
-  }
-
-  if (sFrameComplete != VK_NULL_HANDLE) {
-    vkDestroyFence(sDevice, sFrameComplete, nullptr);
+  for (auto&& frame : sFrames) {
+    if (frame.imagesReadyForPresent != VK_NULL_HANDLE) {
+      vkDestroySemaphore(sDevice, frame.imagesReadyForPresent, nullptr);
+    }
+    if (frame.complete != VK_NULL_HANDLE) {
+      vkDestroyFence(sDevice, frame.complete, nullptr);
+    }
+    // Destroying the pool frees the frame's command buffers.
+    if (frame.commandPool != VK_NULL_HANDLE) {
+      vkDestroyCommandPool(sDevice, frame.commandPool, nullptr);
+    }
+    frame = {};
   }
 
   if (sOneTimeSubmitFence != VK_NULL_HANDLE) {
@@ -1762,6 +2558,12 @@ void iris::Renderer::Shutdown() noexcept {
 
   if (sInstance != VK_NULL_HANDLE) { vkDestroyInstance(sInstance, nullptr); }
 
+  auto const shaderCacheStats = GetShaderCacheStatistics();
+  GetLogger()->info(
+    "Shader cache: {} memory hits, {} disk hits, {} compiled",
+    shaderCacheStats.memoryHits, shaderCacheStats.diskHits,
+    shaderCacheStats.misses);
+
   glslang::FinalizeProcess();
 
   sTaskSchedulerInit.terminate();
@@ -1806,20 +2608,26 @@ bool iris::Renderer::BeginFrame() noexcept {
     }
   }
 
+  // Only wait for the GPU to finish the frame that last used this slot of the
+  // ring; the other frames in flight keep executing while we record.
+  auto&& frame = sFrames[sFrameIndex];
+
   if (auto result =
-        vkWaitForFences(sDevice, 1, &sFrameComplete, VK_TRUE, UINT64_MAX);
+        vkWaitForFences(sDevice, 1, &frame.complete, VK_TRUE, UINT64_MAX);
       result != VK_SUCCESS) {
     GetLogger()->error("Error waiting on fence: {}", to_string(result));
     return false;
   }
 
-  if (auto result = vkResetFences(sDevice, 1, &sFrameComplete);
+  if (auto result = vkResetFences(sDevice, 1, &frame.complete);
       result != VK_SUCCESS) {
     GetLogger()->error("Error resetting fence: {}", to_string(result));
     return false;
   }
 
-  if (auto result = vkResetCommandPool(sDevice, sGraphicsCommandPools[0], 0);
+  RetireUploads(sFrameIndex);
+
+  if (auto result = vkResetCommandPool(sDevice, frame.commandPool, 0);
       result != VK_SUCCESS) {
     GetLogger()->error("Error resetting command pool: {}", to_string(result));
     return false;
@@ -1831,6 +2639,34 @@ bool iris::Renderer::BeginFrame() noexcept {
 void iris::Renderer::EndFrame() noexcept {
   if (!sInitialized || !sRunning) return;
   auto&& windows = Windows();
+  auto&& frame = sFrames[sFrameIndex];
+
+  if (auto error = ReserveMatrixBufferViews(
+        gsl::narrow_cast<std::uint32_t>(windows.size()));
+      error.code()) {
+    GetLogger()->error("Error reserving matrix buffer: {}", error.what());
+    return;
+  }
+
+  if (sGPUCulling) {
+    // Compacting the geometry arena moved the geometry of every mesh. It
+    // waited for the device to go idle, so no frame still culls them.
+    if (sCulledGeometryGeneration != GeometryGeneration()) {
+      for (auto&& [i, mesh] : enumerate(Meshes())) {
+        UpdateGPUCullingMesh(i, MakeMeshCullData(mesh));
+      }
+      sCulledGeometryGeneration = GeometryGeneration();
+    }
+
+    if (auto grown = PrepareGPUCulling(
+          gsl::narrow_cast<std::uint32_t>(windows.size()))) {
+      if (*grown) sSceneGeneration++;
+    } else {
+      GetLogger()->error("Error preparing GPU culling: {}",
+                         grown.error().what());
+      return;
+    }
+  }
 
   //
   // Acquire images/semaphores from all iris::Window objects
@@ -1839,8 +2675,8 @@ void iris::Renderer::EndFrame() noexcept {
   for (auto&& [title, window] : windows) {
     VkResult result =
       vkAcquireNextImageKHR(sDevice, window.surface.swapchain, UINT64_MAX,
-                            window.surface.imageAvailable, VK_NULL_HANDLE,
-                            &window.surface.currentImageIndex);
+                            window.surface.imageAvailable[sFrameIndex],
+                            VK_NULL_HANDLE, &window.surface.currentImageIndex);
 
     if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
       GetLogger()->warn("Swapchains out of date; resizing and re-acquiring");
@@ -1850,7 +2686,8 @@ void iris::Renderer::EndFrame() noexcept {
 
       result =
         vkAcquireNextImageKHR(sDevice, window.surface.swapchain, UINT64_MAX,
-                              window.surface.imageAvailable, VK_NULL_HANDLE,
+                              window.surface.imageAvailable[sFrameIndex],
+                              VK_NULL_HANDLE,
                               &window.surface.currentImageIndex);
     }
 
@@ -1862,137 +2699,208 @@ void iris::Renderer::EndFrame() noexcept {
   }
 
   //
-  // Build secondary command buffers
+  // Write this frame's uniform data: one matrix slice per window, selected
+  // with a dynamic offset when binding the base descriptor set.
   //
-  if (sSecondaryCommandBuffers.size() < windows.size()) {
-    // Re-allocate secondary command buffers
-    if (!sSecondaryCommandBuffers.empty()) {
-      vkFreeCommandBuffers(
-        sDevice, sGraphicsCommandPools[0],
-        gsl::narrow_cast<std::uint32_t>(sSecondaryCommandBuffers.size()),
-        sSecondaryCommandBuffers.data());
-      sSecondaryCommandBuffers.clear();
-    }
 
-    VkCommandBufferAllocateInfo commandBufferAI = {};
-    commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAI.commandPool = sGraphicsCommandPools[0];
-    commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
-    commandBufferAI.commandBufferCount =
-      gsl::narrow_cast<std::uint32_t>(windows.size());
+  VkDeviceSize const matrixBufferFrameOffset =
+    sMatrixBufferStride * sMatrixBufferNumViews * sFrameIndex;
 
-    sSecondaryCommandBuffers.resize(windows.size());
-    if (auto result = vkAllocateCommandBuffers(sDevice, &commandBufferAI,
-                                               sSecondaryCommandBuffers.data());
-        result != VK_SUCCESS) {
-      GetLogger()->error(
-        "Renderer::Frame: allocating secondary command buffers failed: {}",
-        to_string(result));
-    }
+  for (auto [i, iter] : enumerate(windows)) {
+    auto&& window = iter.second;
+
+    auto pMatrices = reinterpret_cast<MatrixBufferData*>(
+      sMatrixBufferData + matrixBufferFrameOffset + sMatrixBufferStride * i);
+    pMatrices->viewMatrix = sViewMatrix;
+    pMatrices->viewMatrixInverse = sViewMatrixInverse;
+    pMatrices->projectionMatrix = window.projectionMatrix;
+    pMatrices->projectionMatrixInverse = window.projectionMatrixInverse;
   }
 
-  std::transform(
-    std::begin(windows), std::end(windows),
-    std::begin(sSecondaryCommandBuffers), std::begin(sSecondaryCommandBuffers),
-    [](auto&& titleWindow, auto&& commandBuffer) -> VkCommandBuffer {
-      auto&& [title, window] = titleWindow;
-      (void)title;
-
-      VkCommandBufferInheritanceInfo inheritanceInfo = {};
-      inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
-      inheritanceInfo.renderPass = sRenderPass;
-      inheritanceInfo.framebuffer = window.surface.currentFramebuffer();
-
-      VkCommandBufferBeginInfo beginInfo = {};
-      beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-      beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT |
-                        VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
-      beginInfo.pInheritanceInfo = &inheritanceInfo;
-
-      if (auto result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-          result != VK_SUCCESS) {
-        GetLogger()->error(
-          "Renderer::Frame: begin secondary command buffer failed: {}",
-          to_string(result));
-      }
+  vmaFlushAllocation(sAllocator, sMatrixBufferAllocation,
+                     matrixBufferFrameOffset,
+                     sMatrixBufferStride * windows.size());
 
-      vkCmdSetViewport(commandBuffer, 0, 1, &window.surface.viewport);
-      vkCmdSetScissor(commandBuffer, 0, 1, &window.surface.scissor);
-
-      absl::FixedArray<VkDescriptorSet> descriptorSets(2);
-      descriptorSets[0] = sBaseDescriptorSets[0];
-
-      for (auto&& mesh : Meshes()) {
-        glm::mat4 const modelViewMatrix = sViewMatrix * mesh.modelMatrix;
-        glm::mat4 const modelViewMatrixInverse =
-          sViewMatrixInverse * mesh.modelMatrixInverse;
-        glm::mat3 const normalMatrix = glm::transpose(modelViewMatrixInverse);
-
-        descriptorSets[1] = mesh.descriptorSets.sets[0];
-
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          mesh.pipeline);
-
-        vkCmdBindDescriptorSets(
-          commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh.pipeline.layout,
-          0, gsl::narrow_cast<std::uint32_t>(descriptorSets.size()),
-          descriptorSets.data(), 0, nullptr);
-
-        vkCmdPushConstants(commandBuffer, mesh.pipeline.layout,
-                           VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4),
-                           glm::value_ptr(modelViewMatrix));
-        vkCmdPushConstants(commandBuffer, mesh.pipeline.layout,
-                           VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4),
-                           sizeof(glm::mat4),
-                           glm::value_ptr(modelViewMatrixInverse));
-        vkCmdPushConstants(commandBuffer, mesh.pipeline.layout,
-                           VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4) * 2,
-                           sizeof(glm::mat3), glm::value_ptr(normalMatrix));
-
-        VkDeviceSize bindingOffset = 0;
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, mesh.vertexBuffer.get(),
-                               &bindingOffset);
-
-        if (mesh.numIndices > 0) {
-          vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, 0,
-                               VK_INDEX_TYPE_UINT32);
-          vkCmdDrawIndexed(commandBuffer, mesh.numIndices, 1, 0, 0, 0);
-        } else {
-          vkCmdDraw(commandBuffer, mesh.numVertices, 1, 0, 0);
-        }
-      }
-
-      if (auto result = vkEndCommandBuffer(commandBuffer);
-          result != VK_SUCCESS) {
-        GetLogger()->error(
-          "Renderer::Frame: end secondary command buffer failed: {}",
-          to_string(result));
-      }
+  auto pLights = reinterpret_cast<LightBufferData*>(
+    sLightBufferData + sLightBufferStride * sFrameIndex);
+  pLights->lights[0].direction =
+    glm::vec4(0, -std::sqrt(2.f), -std::sqrt(2.f), 0.f);
+  pLights->lights[0].color = glm::vec4(1.f, 1.f, 1.f, 1.f);
+  pLights->numLights = 1;
 
-      return commandBuffer;
-    });
+  vmaFlushAllocation(sAllocator, sLightBufferAllocation,
+                     sLightBufferStride * sFrameIndex, sLightBufferStride);
 
   //
-  // 1. Record primary command buffer for current frame
+  // Build secondary command buffers. Each frame in flight keeps the
+  // recordings for every window and replays them until the scene, the
+  // window's view index, its viewport or the set of meshes inside its frustum
+  // and their levels of detail change. Stale windows have their
+  // meshes split into ranges and each (window, range) pair is recorded on a
+  // TBB thread into a command buffer from that thread's pool.
+  //
+  // With GPU culling every mesh is recorded as an indirect draw and the
+  // culling pass decides what is drawn and at which level of detail, so
+  // recordings only go stale when the scene or the window changes.
   //
 
-  void* ptr;
+  auto&& meshes = Meshes();
+  std::size_t const numWindows = windows.size();
+  std::size_t const numThreads = sGraphicsCommandPools.size();
 
-  if (auto result = vmaMapMemory(sAllocator, sLightBufferAllocation, &ptr);
-      result != VK_SUCCESS) {
-    GetLogger()->error("Error mapping sLightBuffer: {}", to_string(result));
+  for (auto iter = frame.windowSecondaries.begin();
+       iter != frame.windowSecondaries.end();) {
+    if (windows.find(iter->first) == windows.end()) {
+      ReleaseWindowSecondaries(frame, iter->second);
+      frame.windowSecondaries.erase(iter++);
+    } else {
+      ++iter;
+    }
   }
 
-  auto pLights = static_cast<LightBufferData*>(ptr);
-  pLights->lights[0].direction = glm::vec4(0, -std::sqrt(2.f), -std::sqrt(2.f), 0.f);
-  pLights->lights[0].color = glm::vec4(1.f, 1.f, 1.f, 1.f);
-  pLights->numLights = 1;
+  // Insert every window before taking pointers to the map's values.
+  for (auto&& iter : windows) frame.windowSecondaries[iter.first];
+
+  absl::FixedArray<WindowSecondaries*> staleSecondaries(numWindows);
+  absl::FixedArray<Window const*> staleWindows(numWindows);
+  std::size_t numStaleWindows = 0;
+
+  std::vector<std::uint8_t> visible(meshes.size());
+  std::vector<DrawItem> draws;
+  std::vector<DrawItem> drawsScratch;
+  std::size_t maxDraws = 0;
+
+  auto const sameDraw = [](DrawItem const& a, DrawItem const& b) {
+    return a.meshIndex == b.meshIndex && a.levelOfDetail == b.levelOfDetail;
+  };
+
+  for (auto [i, iter] : enumerate(windows)) {
+    auto&& window = iter.second;
+    auto&& secondaries = frame.windowSecondaries[iter.first];
+
+    bool const sameView =
+      secondaries.sceneGeneration == sSceneGeneration &&
+      secondaries.viewIndex == i &&
+      std::memcmp(&secondaries.viewport, &window.surface.viewport,
+                  sizeof(VkViewport)) == 0 &&
+      std::memcmp(&secondaries.scissor, &window.surface.scissor,
+                  sizeof(VkRect2D)) == 0;
+
+    if (sGPUCulling) {
+      // The counts are from the last time this frame in flight was rendered.
+      std::size_t const numDrawn = std::min<std::size_t>(
+        GPUCullingNumDrawn(gsl::narrow_cast<std::uint32_t>(i)),
+        meshes.size());
+      window.numMeshesDrawn = gsl::narrow_cast<std::uint32_t>(numDrawn);
+      window.numMeshesCulled =
+        gsl::narrow_cast<std::uint32_t>(meshes.size() - numDrawn);
+
+      // The draws only change with the scene, so secondaries recorded for
+      // this scene and view are current without looking at them.
+      if (sameView) continue;
+      draws = StateQueue();
+    } else {
+      std::size_t const numVisible =
+        CullMeshes(window.projectionMatrix * sViewMatrix, visible);
+      window.numMeshesDrawn = gsl::narrow_cast<std::uint32_t>(numVisible);
+      window.numMeshesCulled =
+        gsl::narrow_cast<std::uint32_t>(meshes.size() - numVisible);
+
+      SortDraws(sViewMatrix, LevelOfDetailScale(window), visible, draws,
+                drawsScratch);
+
+      if (sameView &&
+          std::equal(secondaries.draws.begin(), secondaries.draws.end(),
+                     draws.begin(), draws.end(), sameDraw)) {
+        continue;
+      }
+    }
+
+    ReleaseWindowSecondaries(frame, secondaries);
+    secondaries.draws.swap(draws);
+    maxDraws = std::max(maxDraws, secondaries.draws.size());
+    secondaries.sceneGeneration = sSceneGeneration;
+    secondaries.viewIndex = gsl::narrow_cast<std::uint32_t>(i);
+    secondaries.viewport = window.surface.viewport;
+    secondaries.scissor = window.surface.scissor;
+
+    staleSecondaries[numStaleWindows] = &secondaries;
+    staleWindows[numStaleWindows] = &window;
+    numStaleWindows++;
+  }
+
+  if (numStaleWindows > 0) {
+    // Aim for a couple of ranges per thread so uneven ranges still balance.
+    std::size_t const drawsPerSecondary =
+      std::max(kMinDrawsPerSecondary,
+               (maxDraws * numStaleWindows + numThreads * 2 - 1) /
+                 (numThreads * 2));
+    std::size_t const secondariesPerWindow =
+      (maxDraws + drawsPerSecondary - 1) / drawsPerSecondary;
+
+    for (std::size_t i = 0; i < numStaleWindows; ++i) {
+      auto&& secondaries = *staleSecondaries[i];
+      std::size_t const numSecondaries =
+        (secondaries.draws.size() + drawsPerSecondary - 1) / drawsPerSecondary;
+      secondaries.commandBuffers.resize(numSecondaries, VK_NULL_HANDLE);
+      secondaries.threadIndices.resize(numSecondaries, 0);
+      secondaries.bindCounts.assign(numSecondaries, BindCounts{});
+    }
+
+    VkBuffer const drawCommandBuffer =
+      sGPUCulling ? GPUCullingDrawCommandBuffer() : VK_NULL_HANDLE;
+
+    tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0,
+                                      numStaleWindows * secondariesPerWindow),
+      [&](tbb::blocked_range<std::size_t> const& range) {
+        // Only one task at a time runs on a thread slot, which gives each
+        // thread exclusive use of its pool and free list while recording.
+        auto const threadIndex = gsl::narrow_cast<std::size_t>(
+          tbb::this_task_arena::current_thread_index());
+        Expects(threadIndex < numThreads);
+
+        for (std::size_t i = range.begin(); i != range.end(); ++i) {
+          std::size_t const windowIndex = i / secondariesPerWindow;
+          std::size_t const rangeIndex = i % secondariesPerWindow;
+          auto&& secondaries = *staleSecondaries[windowIndex];
+          if (rangeIndex >= secondaries.commandBuffers.size()) continue;
+
+          std::size_t const drawBegin = rangeIndex * drawsPerSecondary;
+          std::size_t const drawEnd = std::min(drawBegin + drawsPerSecondary,
+                                               secondaries.draws.size());
+
+          VkCommandBuffer commandBuffer =
+            GetThreadSecondaryCommandBuffer(frame, threadIndex);
+          if (commandBuffer == VK_NULL_HANDLE) continue;
+
+          RecordSecondaryCommandBuffer(
+            commandBuffer, *staleWindows[windowIndex], frame.baseDescriptorSet,
+            gsl::narrow_cast<std::uint32_t>(sMatrixBufferStride *
+                                            secondaries.viewIndex),
+            meshes,
+            gsl::span<DrawItem const>(secondaries.draws.data() + drawBegin,
+                                      drawEnd - drawBegin),
+            drawCommandBuffer,
+            sGPUCulling ? GPUCullingDrawCommandOffset(sFrameIndex,
+                                                      secondaries.viewIndex)
+                        : 0,
+            secondaries.bindCounts[rangeIndex]);
+          secondaries.commandBuffers[rangeIndex] = commandBuffer;
+          secondaries.threadIndices[rangeIndex] = threadIndex;
+        }
+      });
 
-  vmaFlushAllocation(sAllocator, sLightBufferAllocation, 0, VK_WHOLE_SIZE);
-  vmaUnmapMemory(sAllocator, sLightBufferAllocation);
+    GetLogger()->trace("Recorded secondary command buffers for {} of {} "
+                       "windows",
+                       numStaleWindows, numWindows);
+  }
+
+  //
+  // 1. Record primary command buffer for current frame
+  //
 
-  sCommandBufferIndex = (sCommandBufferIndex + 1) % sCommandBuffers.size();
-  auto&& cb = sCommandBuffers[sCommandBufferIndex];
+  auto&& cb = frame.commandBuffer;
 
   VkCommandBufferBeginInfo cbi = {};
   cbi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -2001,6 +2909,23 @@ void iris::Renderer::EndFrame() noexcept {
     GetLogger()->error("Error beginning command buffer: {}", to_string(result));
   }
 
+  // Uploads queued since the last frame, including the geometry of meshes
+  // created this frame, land before anything reads them.
+  VkSemaphore const uploadsComplete = RecordUploads(cb, sFrameIndex);
+
+  if (sGPUCulling) {
+    absl::FixedArray<std::array<glm::vec4, 6>> viewFrustumPlanes(numWindows);
+    absl::FixedArray<glm::vec4> viewLevelsOfDetail(numWindows);
+    for (auto [i, iter] : enumerate(windows)) {
+      viewFrustumPlanes[i] =
+        FrustumPlanes(iter.second.projectionMatrix * sViewMatrix);
+      viewLevelsOfDetail[i] = glm::vec4(glm::vec3(sViewMatrixInverse[3]),
+                                        LevelOfDetailScale(iter.second));
+    }
+
+    RecordGPUCulling(cb, viewFrustumPlanes, viewLevelsOfDetail);
+  }
+
   absl::FixedArray<VkClearValue> clearValues(sNumRenderPassAttachments);
   clearValues[sDepthStencilTargetAttachmentIndex].depthStencil = {1.f, 0};
 
@@ -2014,8 +2939,9 @@ void iris::Renderer::EndFrame() noexcept {
   // 2. For every window, begin rendering
   //
 
-  std::size_t const numWindows = windows.size();
-  absl::FixedArray<VkSemaphore> waitSemaphores(numWindows);
+  std::size_t const numWaitSemaphores =
+    numWindows + (uploadsComplete != VK_NULL_HANDLE ? 1 : 0);
+  absl::FixedArray<VkSemaphore> waitSemaphores(numWaitSemaphores);
   absl::FixedArray<VkSwapchainKHR> swapchains(numWindows);
   absl::FixedArray<std::uint32_t> imageIndices(numWindows);
 
@@ -2023,21 +2949,7 @@ void iris::Renderer::EndFrame() noexcept {
     auto&& window = iter.second;
     auto&& surface = window.surface;
 
-    if (auto result = vmaMapMemory(sAllocator, sMatrixBufferAllocation, &ptr);
-        result != VK_SUCCESS) {
-      GetLogger()->error("Error mapping sMatrixBuffer: {}", to_string(result));
-    }
-
-    auto pMatrices = static_cast<MatrixBufferData*>(ptr);
-    pMatrices->viewMatrix = sViewMatrix;
-    pMatrices->viewMatrixInverse = sViewMatrixInverse;
-    pMatrices->projectionMatrix = window.projectionMatrix;
-    pMatrices->projectionMatrixInverse = window.projectionMatrixInverse;
-
-    vmaFlushAllocation(sAllocator, sMatrixBufferAllocation, 0, VK_WHOLE_SIZE);
-    vmaUnmapMemory(sAllocator, sMatrixBufferAllocation);
-
-    waitSemaphores[i] = surface.imageAvailable;
+    waitSemaphores[i] = surface.imageAvailable[sFrameIndex];
     swapchains[i] = surface.swapchain;
     imageIndices[i] = surface.currentImageIndex;
 
@@ -2056,8 +2968,26 @@ void iris::Renderer::EndFrame() noexcept {
     // 3. Execute secondary command buffers
     //
 
-    vkCmdExecuteCommands(cb, sSecondaryCommandBuffers.size(),
-                         sSecondaryCommandBuffers.data());
+    // Each window's secondaries were recorded against its own matrix slice
+    // and are executed in sorted order. A failed recording is retried on the
+    // next pass through this frame.
+    auto&& secondaries = frame.windowSecondaries[iter.first];
+
+    window.numBindsIssued = window.numBindsElided = 0;
+    for (auto&& bindCounts : secondaries.bindCounts) {
+      window.numBindsIssued += bindCounts.issued;
+      window.numBindsElided += bindCounts.elided;
+    }
+
+    auto&& commandBuffers = secondaries.commandBuffers;
+    if (std::find(commandBuffers.begin(), commandBuffers.end(),
+                  VK_NULL_HANDLE) != commandBuffers.end()) {
+      secondaries.sceneGeneration = 0;
+    } else if (!commandBuffers.empty()) {
+      vkCmdExecuteCommands(
+        cb, gsl::narrow_cast<std::uint32_t>(commandBuffers.size()),
+        commandBuffers.data());
+    }
 
     if (auto wcb = window.EndFrame(rbi.framebuffer, sFrameNum, sFrameTimes)) {
       VkCommandBuffer winCB = *wcb;
@@ -2083,20 +3013,25 @@ void iris::Renderer::EndFrame() noexcept {
   //
 
   absl::FixedArray<VkPipelineStageFlags> waitDstStages(
-    numWindows, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    numWaitSemaphores, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  if (uploadsComplete != VK_NULL_HANDLE) {
+    waitSemaphores[numWindows] = uploadsComplete;
+    waitDstStages[numWindows] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  }
 
   VkSubmitInfo si = {};
   si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  si.waitSemaphoreCount = gsl::narrow_cast<std::uint32_t>(numWindows);
+  si.waitSemaphoreCount = gsl::narrow_cast<std::uint32_t>(numWaitSemaphores);
   si.pWaitSemaphores = waitSemaphores.data();
   si.pWaitDstStageMask = waitDstStages.data();
   si.commandBufferCount = 1;
   si.pCommandBuffers = &cb;
   si.signalSemaphoreCount = 1;
-  si.pSignalSemaphores = &sImagesReadyForPresent;
+  si.pSignalSemaphores = &frame.imagesReadyForPresent;
 
   if (auto result =
-        vkQueueSubmit(sGraphicsCommandQueue, 1, &si, sFrameComplete);
+        vkQueueSubmit(sGraphicsCommandQueue, 1, &si, frame.complete);
       result != VK_SUCCESS) {
     GetLogger()->error("Error submitting command buffer: {}",
                        to_string(result));
@@ -2111,7 +3046,7 @@ void iris::Renderer::EndFrame() noexcept {
   VkPresentInfoKHR pi = {};
   pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
   pi.waitSemaphoreCount = 1;
-  pi.pWaitSemaphores = &sImagesReadyForPresent;
+  pi.pWaitSemaphores = &frame.imagesReadyForPresent;
   pi.swapchainCount = gsl::narrow_cast<std::uint32_t>(numWindows);
   pi.pSwapchains = swapchains.data();
   pi.pImageIndices = imageIndices.data();
@@ -2124,6 +3059,7 @@ void iris::Renderer::EndFrame() noexcept {
 
   sFrameTimes[sFrameNum++ % sFrameTimes.size()] =
     1000.f * ImGui::GetIO().DeltaTime;
+  sFrameIndex = (sFrameIndex + 1) % sNumFramesInFlight;
 } // iris::Renderer::EndFrame
 
 std::error_code
@@ -2143,7 +3079,7 @@ iris::Renderer::LoadFile(filesystem::path const& path) noexcept {
 
       if (ext.compare(".json") == 0) {
         sIOContinuations.push(io::LoadJSON(path_));
-      } else if (ext.compare(".gltf") == 0) {
+      } else if (ext.compare(".gltf") == 0 || ext.compare(".glb") == 0) {
         sIOContinuations.push(io::LoadGLTF(path_));
       } else {
         GetLogger()->error("Unhandled file extension '{}' for {}", ext.string(),
@@ -2356,19 +3292,67 @@ iris::Renderer::AllocateDescriptorSets(gsl::span<VkDescriptorSetLayoutBinding> b
 } // iris::Renderer::AllocateDescriptorSets
 
 [[nodiscard]] std::system_error
-iris::Renderer::CreateMeshes(gsl::span<const MeshData> meshData) noexcept {
+iris::Renderer::CreateScene(SceneDataView const& sceneData,
+                            std::string const& name) noexcept {
   IRIS_LOG_ENTER();
 
+  std::vector<std::shared_ptr<Material const>> materials;
+  if (auto m = CreateMaterials(sceneData.materials, sceneData.textures,
+                               sceneData.images, name)) {
+    materials = std::move(*m);
+  } else {
+    IRIS_LOG_LEAVE();
+    return m.error();
+  }
+
+  // Created only if a mesh needs it.
+  std::shared_ptr<Material const> defaultMaterial;
+
   auto&& meshes = Meshes();
-  for (auto&& data : meshData) {
-    if (auto m = Mesh::Create(data)) {
-      meshes.push_back(std::move(*m));
+  sSceneGeneration++;
+
+  for (auto&& data : sceneData.meshes) {
+    std::shared_ptr<Material const> material;
+    if (data.material >= 0 &&
+        static_cast<std::size_t>(data.material) < materials.size()) {
+      material = materials[data.material];
     } else {
+      if (!defaultMaterial) {
+        MaterialData const defaultData;
+        if (auto m = CreateMaterials(gsl::make_span(&defaultData, 1), {}, {},
+                                     name + ":default")) {
+          defaultMaterial = std::move((*m)[0]);
+        } else {
+          IRIS_LOG_LEAVE();
+          return m.error();
+        }
+      }
+      material = defaultMaterial;
+    }
+
+    // One mesh per spatial cluster of the instances, so each is culled on
+    // its own bounds.
+    if (auto m = Mesh::Create(data, std::move(material), sQuantizeVertices)) {
+      for (auto&& mesh : *m) {
+        sMeshBoundingSpheres.x.push_back(mesh.boundingSphere.x);
+        sMeshBoundingSpheres.y.push_back(mesh.boundingSphere.y);
+        sMeshBoundingSpheres.z.push_back(mesh.boundingSphere.z);
+        sMeshBoundingSpheres.radius.push_back(mesh.boundingSphere.w);
+        sMeshStateKeys.push_back(MakeStateKey(
+          sPipelineRanks
+            .try_emplace(mesh.pipeline->handle, gsl::narrow_cast<std::uint32_t>(
+                                                  sPipelineRanks.size()))
+            .first->second));
+        if (sGPUCulling) AddGPUCullingMesh(MakeMeshCullData(mesh));
+        meshes.push_back(std::move(mesh));
+      }
+    } else {
+      IRIS_LOG_LEAVE();
       return m.error();
     }
   }
 
   IRIS_LOG_LEAVE();
   return std::system_error(Error::kNone);
-} // iris::Renderer::CreateMeshes
+} // iris::Renderer::CreateScene
 
@@ -32,6 +32,9 @@ enum class Options {
   kNone = (0),
   kReportDebugMessages = (1 << 0),
   kUseValidationLayers = (1 << 1),
+  kGPUCulling = (1 << 2),
+  kQuantizeVertices = (1 << 3),
+  kReduceOverdraw = (1 << 4),
 };
 
 /*! \brief Initialize the rendering system.
@@ -39,11 +42,15 @@ enum class Options {
  * There is only a single renderer per application instance.
  * \param[in] appName the name of the application.
  * \param[in] appVersion the version of the application.
+ * \param[in] logSinks additional sinks for the renderer logger.
+ * \param[in] numFramesInFlight how many frames the CPU may record while the
+ * GPU is still rendering earlier ones; clamped to [1, 3].
  */
 [[nodiscard]] std::system_error
 Initialize(gsl::czstring<> appName, Options const& options,
            std::uint32_t appVersion = 0,
-           spdlog::sinks_init_list logSinks = {}) noexcept;
+           spdlog::sinks_init_list logSinks = {},
+           std::uint32_t numFramesInFlight = 2) noexcept;
 
 void Shutdown() noexcept;
 
@@ -1,4 +1,8 @@
 #include "renderer/shader.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "fmt/format.h"
 #include "logging.h"
 #include "renderer/impl.h"
 #include "renderer/io/read_file.h"
@@ -12,6 +16,11 @@
 #if PLATFORM_COMPILER_GCC
 #pragma GCC diagnostic pop
 #endif
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
 
 namespace iris::Renderer {
 
@@ -122,11 +131,45 @@ const TBuiltInResource DefaultTBuiltInResource = {
     /* .generalConstantMatrixVectorIndexing = */ true,
   }};
 
+/*! \brief Convert command-line style macro definitions into a glslang
+ * preamble: "-DNAME", "-DNAME=VALUE" and "-UNAME" become #define and #undef
+ * lines. A definition without a -D or -U prefix is treated as -D.
+ */
+static std::string
+MacroDefinitionsToPreamble(gsl::span<std::string> macroDefinitions) {
+  std::string preamble;
+
+  for (auto&& definition : macroDefinitions) {
+    std::string_view macro = definition;
+    std::string_view directive = "#define ";
+
+    if (macro.substr(0, 2) == "-D") {
+      macro.remove_prefix(2);
+    } else if (macro.substr(0, 2) == "-U") {
+      macro.remove_prefix(2);
+      directive = "#undef ";
+    }
+    if (macro.empty()) continue;
+
+    preamble.append(directive);
+    if (auto eq = macro.find('=');
+        eq != std::string_view::npos && directive == "#define ") {
+      preamble.append(macro.substr(0, eq)).append(" ");
+      preamble.append(macro.substr(eq + 1));
+    } else {
+      preamble.append(macro);
+    }
+    preamble.append("\n");
+  }
+
+  return preamble;
+} // MacroDefinitionsToPreamble
+
 [[nodiscard]] static tl::expected<std::vector<std::uint32_t>, std::string>
 CompileShaderFromSource(std::string_view source,
                         VkShaderStageFlagBits shaderStage,
                         filesystem::path const& path,
-                        gsl::span<std::string> macroDefinitions[[maybe_unused]],
+                        gsl::span<std::string> macroDefinitions,
                         std::string const& entryPoint) {
   IRIS_LOG_ENTER();
   Expects(source.size() > 0);
@@ -136,6 +179,8 @@ CompileShaderFromSource(std::string_view source,
       return EShLanguage::EShLangVertex;
     } else if ((shaderStage & VK_SHADER_STAGE_FRAGMENT_BIT)) {
       return EShLanguage::EShLangFragment;
+    } else if ((shaderStage & VK_SHADER_STAGE_COMPUTE_BIT)) {
+      return EShLanguage::EShLangCompute;
     } else {
       GetLogger()->critical("Unhandled shaderStage: {}", shaderStage);
       std::terminate();
@@ -144,10 +189,13 @@ CompileShaderFromSource(std::string_view source,
 
   char const* strings[] = {source.data()};
   int lengths[] = {static_cast<int>(source.size())};
-  char const* names[] = {path.string().c_str()};
+  std::string const pathString = path.string();
+  char const* names[] = {pathString.c_str()};
+  std::string const preamble = MacroDefinitionsToPreamble(macroDefinitions);
 
   glslang::TShader shader(lang);
   shader.setStringsWithLengthsAndNames(strings, lengths, names, 1);
+  shader.setPreamble(preamble.c_str());
   shader.setEntryPoint(entryPoint.c_str());
   shader.setEnvInput(glslang::EShSource::EShSourceGlsl, lang,
                      glslang::EShClient::EShClientVulkan, 101);
@@ -188,8 +236,219 @@ CompileShaderFromSource(std::string_view source,
   }
 } // CompileShaderFromSource
 
+//! Change whenever the compiler or its options change the generated code, so
+//! stale on-disk entries are no longer found.
+static constexpr std::uint64_t kSPIRVCacheVersion = 2;
+
+static std::mutex sSPIRVCacheMutex;
+static absl::flat_hash_map<std::uint64_t, std::vector<std::uint32_t>>
+  sSPIRVCache;
+static std::atomic<std::uint64_t> sSPIRVCacheMemoryHits{0};
+static std::atomic<std::uint64_t> sSPIRVCacheDiskHits{0};
+static std::atomic<std::uint64_t> sSPIRVCacheMisses{0};
+
+static std::uint64_t
+SPIRVCacheKey(std::string_view source, VkShaderStageFlagBits shaderStage,
+              gsl::span<std::string> macroDefinitions,
+              std::string const& entryPoint) noexcept {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  auto const hashBytes = [&hash](void const* bytes, std::size_t size) {
+    hash = io::HashBytes(
+      {static_cast<std::byte const*>(bytes),
+       static_cast<std::ptrdiff_t>(size)},
+      hash);
+  };
+
+  std::uint64_t const version = kSPIRVCacheVersion;
+  std::uint32_t const stage = shaderStage;
+#ifndef NDEBUG
+  std::uint8_t const debugInfo = 1;
+#else
+  std::uint8_t const debugInfo = 0;
+#endif
+
+  hashBytes(&version, sizeof(version));
+  hashBytes(&debugInfo, sizeof(debugInfo));
+  hashBytes(&stage, sizeof(stage));
+  // Hash lengths along with strings so the boundaries are unambiguous.
+  for (auto&& str : {std::string_view(entryPoint), source}) {
+    std::uint64_t const size = str.size();
+    hashBytes(&size, sizeof(size));
+    hashBytes(str.data(), str.size());
+  }
+  for (auto&& macro : macroDefinitions) {
+    std::uint64_t const size = macro.size();
+    hashBytes(&size, sizeof(size));
+    hashBytes(macro.data(), macro.size());
+  }
+
+  return hash;
+} // SPIRVCacheKey
+
+/*! \brief The start of an on-disk cache entry; the code follows it. The
+ * length and hash of the code reject entries that were truncated or
+ * corrupted after they were written.
+ */
+struct SPIRVCacheHeader {
+  std::uint64_t numWords;
+  std::uint64_t hash;
+}; // struct SPIRVCacheHeader
+
+static std::uint64_t
+SPIRVCodeHash(gsl::span<std::uint32_t const> code) noexcept {
+  return io::HashBytes(gsl::as_bytes(code));
+} // SPIRVCodeHash
+
+/*! \brief Get the SPIR-V for a shader from the in-memory cache, then the
+ * on-disk cache, and only compile it with glslang if neither has it.
+ */
+[[nodiscard]] static tl::expected<std::vector<std::uint32_t>, std::string>
+GetOrCompileSPIRV(std::string_view source, VkShaderStageFlagBits shaderStage,
+                  filesystem::path const& path,
+                  gsl::span<std::string> macroDefinitions,
+                  std::string const& entryPoint) {
+  IRIS_LOG_ENTER();
+
+  std::uint64_t const key =
+    SPIRVCacheKey(source, shaderStage, macroDefinitions, entryPoint);
+
+  {
+    std::lock_guard<std::mutex> lock(sSPIRVCacheMutex);
+    if (auto iter = sSPIRVCache.find(key); iter != sSPIRVCache.end()) {
+      ++sSPIRVCacheMemoryHits;
+      IRIS_LOG_LEAVE();
+      return iter->second;
+    }
+  }
+
+  static filesystem::path const sCacheDirectory =
+    io::CacheDirectory("shaders");
+  filesystem::path const cachePath =
+    sCacheDirectory / fmt::format("{:016x}.spv", key);
+  std::uint32_t const kSPIRVMagic = 0x07230203;
+
+  if (filesystem::exists(cachePath)) {
+    if (auto bytes = io::ReadFile(cachePath);
+        bytes && bytes->size() > sizeof(SPIRVCacheHeader)) {
+      SPIRVCacheHeader header;
+      std::memcpy(&header, bytes->data(), sizeof(header));
+      std::size_t const codeSize = bytes->size() - sizeof(header);
+
+      std::vector<std::uint32_t> code;
+      if (codeSize % sizeof(std::uint32_t) == 0 &&
+          header.numWords == codeSize / sizeof(std::uint32_t)) {
+        code.resize(header.numWords);
+        std::memcpy(code.data(), bytes->data() + sizeof(header), codeSize);
+      }
+
+      if (!code.empty() && code[0] == kSPIRVMagic &&
+          SPIRVCodeHash(code) == header.hash) {
+        GetLogger()->debug("Loaded cached SPIR-V for {} from {}",
+                           path.string(), cachePath.string());
+        ++sSPIRVCacheDiskHits;
+
+        std::lock_guard<std::mutex> lock(sSPIRVCacheMutex);
+        sSPIRVCache.emplace(key, code);
+        IRIS_LOG_LEAVE();
+        return code;
+      }
+    }
+    GetLogger()->warn("Ignoring invalid cached SPIR-V {}", cachePath.string());
+  }
+
+  ++sSPIRVCacheMisses;
+  GetLogger()->debug("Compiling {}", path.string());
+
+  std::vector<std::uint32_t> code;
+  if (auto c = CompileShaderFromSource(source, shaderStage, path,
+                                       macroDefinitions, entryPoint)) {
+    code = std::move(*c);
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(c.error());
+  }
+
+  SPIRVCacheHeader const header{code.size(), SPIRVCodeHash(code)};
+  std::vector<std::byte> entry(sizeof(header) +
+                               code.size() * sizeof(std::uint32_t));
+  std::memcpy(entry.data(), &header, sizeof(header));
+  std::memcpy(entry.data() + sizeof(header), code.data(),
+              code.size() * sizeof(std::uint32_t));
+
+  if (auto error = io::WriteFile(cachePath, entry); error.code()) {
+    GetLogger()->warn("Cannot write SPIR-V cache {}: {}", cachePath.string(),
+                      error.what());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sSPIRVCacheMutex);
+    sSPIRVCache.emplace(key, code);
+  }
+
+  IRIS_LOG_LEAVE();
+  return code;
+} // GetOrCompileSPIRV
+
+static std::mutex sShaderVariantsMutex;
+static absl::flat_hash_map<std::string, std::shared_ptr<Shader const>>
+  sShaderVariants;
+
 } // namespace iris::Renderer
 
+iris::Renderer::ShaderCacheStatistics
+iris::Renderer::GetShaderCacheStatistics() noexcept {
+  return {sSPIRVCacheMemoryHits.load(), sSPIRVCacheDiskHits.load(),
+          sSPIRVCacheMisses.load()};
+} // iris::Renderer::GetShaderCacheStatistics
+
+tl::expected<std::shared_ptr<iris::Renderer::Shader const>, std::system_error>
+iris::Renderer::GetShaderVariant(filesystem::path const& path,
+                                 VkShaderStageFlagBits stage,
+                                 gsl::span<std::string> macroDefinitions,
+                                 std::string entry) noexcept {
+  IRIS_LOG_ENTER();
+  Expects(!path.empty());
+
+  // The order of definitions does not change the variant, so sort them to
+  // give every permutation of the same set one key.
+  std::vector<std::string> macros(macroDefinitions.begin(),
+                                  macroDefinitions.end());
+  std::sort(macros.begin(), macros.end());
+  macros.erase(std::unique(macros.begin(), macros.end()), macros.end());
+
+  std::string const key =
+    absl::StrCat(path.string(), "|", static_cast<std::uint32_t>(stage), "|",
+                 entry, "|", absl::StrJoin(macros, " "));
+
+  std::lock_guard<std::mutex> lock(sShaderVariantsMutex);
+  if (auto iter = sShaderVariants.find(key); iter != sShaderVariants.end()) {
+    IRIS_LOG_LEAVE();
+    return iter->second;
+  }
+
+  std::shared_ptr<Shader const> variant;
+  if (auto s = Shader::CreateFromFile(path, stage, macros, std::move(entry),
+                                      key)) {
+    variant = std::make_shared<Shader const>(std::move(*s));
+  } else {
+    IRIS_LOG_LEAVE();
+    return tl::unexpected(s.error());
+  }
+
+  GetLogger()->debug("Created shader variant {}", key);
+  sShaderVariants.emplace(key, variant);
+
+  IRIS_LOG_LEAVE();
+  return variant;
+} // iris::Renderer::GetShaderVariant
+
+void iris::Renderer::ReleaseShaderVariants() noexcept {
+  IRIS_LOG_ENTER();
+  std::lock_guard<std::mutex> lock(sShaderVariantsMutex);
+  sShaderVariants.clear();
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::ReleaseShaderVariants
+
 tl::expected<iris::Renderer::Shader, std::system_error>
 iris::Renderer::Shader::CreateFromSource(
   std::string_view source, VkShaderStageFlagBits stage,
@@ -202,8 +461,8 @@ iris::Renderer::Shader::CreateFromSource(
   Shader shader;
 
   std::vector<std::uint32_t> code;
-  if (auto c = CompileShaderFromSource(source, stage, "<inline>",
-                                       macroDefinitions, entry)) {
+  if (auto c = GetOrCompileSPIRV(source, stage, "<inline>", macroDefinitions,
+                                 entry)) {
     code = std::move(*c);
   } else {
     IRIS_LOG_LEAVE();
@@ -258,7 +517,7 @@ iris::Renderer::Shader::CreateFromFile(filesystem::path const& path,
   }
 
   std::vector<std::uint32_t> code;
-  if (auto c = CompileShaderFromSource(
+  if (auto c = GetOrCompileSPIRV(
         {reinterpret_cast<char*>(source.data()), source.size()}, stage, path,
         macroDefinitions, entry)) {
     code = std::move(*c);
@@ -10,6 +10,8 @@ namespace filesystem = std::experimental::filesystem;
 #include <filesystem>
 namespace filesystem = std::filesystem;
 #endif
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -44,6 +46,31 @@ private:
   std::string name;
 }; // struct Shader
 
+//! \brief Counters of the SPIR-V cache shared by Shader::CreateFromSource and
+//! Shader::CreateFromFile. Misses are the shaders actually compiled.
+struct ShaderCacheStatistics {
+  std::uint64_t memoryHits{0};
+  std::uint64_t diskHits{0};
+  std::uint64_t misses{0};
+}; // struct ShaderCacheStatistics
+
+ShaderCacheStatistics GetShaderCacheStatistics() noexcept;
+
+/*! \brief Get the Shader compiled from \p path with \p macroDefinitions.
+ *
+ * Each unique (path, stage, set of macro definitions, entry) is compiled
+ * once and the same VkShaderModule is shared by every caller. The registry
+ * keeps variants alive until ReleaseShaderVariants.
+ */
+tl::expected<std::shared_ptr<Shader const>, std::system_error>
+GetShaderVariant(filesystem::path const& path, VkShaderStageFlagBits stage,
+                 gsl::span<std::string> macroDefinitions = {},
+                 std::string entry = "main") noexcept;
+
+//! \brief Drop the registry's references to all shader variants; must be
+//! called before the device is destroyed.
+void ReleaseShaderVariants() noexcept;
+
 } // namespace iris::Renderer
 
 #endif // HEV_IRIS_RENDERER_SHADER_H_
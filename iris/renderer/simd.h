@@ -0,0 +1,20 @@
+#ifndef HEV_IRIS_RENDERER_SIMD_H_
+#define HEV_IRIS_RENDERER_SIMD_H_
+/*! \file
+ * \brief Detection of the SIMD instruction sets the renderer has fast paths
+ * for.
+ *
+ * IRIS_RENDERER_HAS_SSE2 is 1 and <emmintrin.h> is included when the target
+ * supports SSE2, which every x86-64 target does; it is 0 otherwise and the
+ * scalar paths are used.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IRIS_RENDERER_HAS_SSE2 1
+#else
+#define IRIS_RENDERER_HAS_SSE2 0
+#endif
+
+#endif // HEV_IRIS_RENDERER_SIMD_H_
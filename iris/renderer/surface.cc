@@ -229,12 +229,14 @@ iris::Renderer::Surface::Create(wsi::Window& window,
 
   VkSemaphoreCreateInfo sci = {};
   sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-  if (auto result =
-        vkCreateSemaphore(sDevice, &sci, nullptr, &surface.imageAvailable);
-      result != VK_SUCCESS) {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(
-      std::system_error(make_error_code(result), "Cannot create semaphore"));
+  for (auto&& imageAvailable : surface.imageAvailable) {
+    if (auto result =
+          vkCreateSemaphore(sDevice, &sci, nullptr, &imageAvailable);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(
+        std::system_error(make_error_code(result), "Cannot create semaphore"));
+    }
   }
 
   auto extent = window.Extent();
@@ -245,7 +247,9 @@ iris::Renderer::Surface::Create(wsi::Window& window,
   }
 
   Ensures(surface.handle != VK_NULL_HANDLE);
-  Ensures(surface.imageAvailable != VK_NULL_HANDLE);
+  for (auto&& imageAvailable : surface.imageAvailable) {
+    Ensures(imageAvailable != VK_NULL_HANDLE);
+  }
   IRIS_LOG_LEAVE();
   return std::move(surface);
 } // iris::Renderer::Surface::Create
@@ -528,7 +532,7 @@ iris::Renderer::Surface::Surface(Surface&& other) noexcept
   , framebuffers(std::move(other.framebuffers))
   , currentImageIndex(other.currentImageIndex) {
   other.handle = VK_NULL_HANDLE;
-  other.imageAvailable = VK_NULL_HANDLE;
+  other.imageAvailable.fill(VK_NULL_HANDLE);
   other.swapchain = VK_NULL_HANDLE;
 } // iris::Renderer::Surface
 
@@ -555,7 +559,7 @@ operator=(Surface&& rhs) noexcept {
   currentImageIndex = (rhs.currentImageIndex);
 
   rhs.handle = VK_NULL_HANDLE;
-  rhs.imageAvailable = VK_NULL_HANDLE;
+  rhs.imageAvailable.fill(VK_NULL_HANDLE);
   rhs.swapchain = VK_NULL_HANDLE;
 
   return *this;
@@ -566,7 +570,9 @@ iris::Renderer::Surface::~Surface() noexcept {
   IRIS_LOG_ENTER();
 
   vkDestroySwapchainKHR(sDevice, swapchain, nullptr);
-  vkDestroySemaphore(sDevice, imageAvailable, nullptr);
+  for (auto&& semaphore : imageAvailable) {
+    vkDestroySemaphore(sDevice, semaphore, nullptr);
+  }
   vkDestroySurfaceKHR(sInstance, handle, nullptr);
 
   IRIS_LOG_LEAVE();
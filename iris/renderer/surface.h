@@ -6,6 +6,7 @@
 #include "iris/renderer/image.h"
 #include "iris/renderer/impl.h"
 #include "iris/wsi/window.h"
+#include <array>
 #include <string>
 #include <system_error>
 
@@ -38,7 +39,9 @@ struct Surface {
   std::system_error Resize(VkExtent2D newExtent) noexcept;
 
   VkSurfaceKHR handle{VK_NULL_HANDLE};
-  VkSemaphore imageAvailable{VK_NULL_HANDLE};
+  //! Signaled by vkAcquireNextImageKHR; one per frame in flight, indexed by
+  //! sFrameIndex.
+  std::array<VkSemaphore, kMaxFramesInFlight> imageAvailable{};
 
   VkExtent2D extent{};
   VkViewport viewport{};
@@ -55,7 +55,7 @@ iris::Renderer::UI::Create() noexcept {
   UI ui;
 
   if (auto cbs = Renderer::AllocateCommandBuffers(
-        2, VK_COMMAND_BUFFER_LEVEL_SECONDARY)) {
+        kNumCommandBuffers, VK_COMMAND_BUFFER_LEVEL_SECONDARY)) {
     ui.commandBuffers = std::move(*cbs);
   } else {
     IRIS_LOG_LEAVE();
@@ -150,29 +150,31 @@ iris::Renderer::UI::Create() noexcept {
     return tl::unexpected(s.error());
   }
 
-  if (auto vb = Buffer::Create(
-        1024 * sizeof(ImDrawVert), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU, "UI::vertexBuffer")) {
-    ui.vertexBuffer = std::move(*vb);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(vb.error());
-  }
-
-  if (auto ib = Buffer::Create(
-        1024 * sizeof(ImDrawIdx), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU, "UI::indexBuffer")) {
-    ui.indexBuffer = std::move(*ib);
-  } else {
-    IRIS_LOG_LEAVE();
-    return tl::unexpected(ib.error());
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    if (auto vb = Buffer::Create(
+          1024 * sizeof(ImDrawVert), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+          VMA_MEMORY_USAGE_CPU_TO_GPU, "UI::vertexBuffer")) {
+      ui.vertexBuffers[i] = std::move(*vb);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(vb.error());
+    }
+
+    if (auto ib = Buffer::Create(
+          1024 * sizeof(ImDrawIdx), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+          VMA_MEMORY_USAGE_CPU_TO_GPU, "UI::indexBuffer")) {
+      ui.indexBuffers[i] = std::move(*ib);
+    } else {
+      IRIS_LOG_LEAVE();
+      return tl::unexpected(ib.error());
+    }
   }
 
-  absl::FixedArray<Shader> shaders(2);
+  absl::FixedArray<std::shared_ptr<Shader const>> shaders(2);
 
   if (auto vs = Shader::CreateFromSource(sUIVertexShaderSource,
                                          VK_SHADER_STAGE_VERTEX_BIT)) {
-    shaders[0] = std::move(*vs);
+    shaders[0] = std::make_shared<Shader const>(std::move(*vs));
   } else {
     IRIS_LOG_LEAVE();
     return tl::unexpected(vs.error());
@@ -180,7 +182,7 @@ iris::Renderer::UI::Create() noexcept {
 
   if (auto fs = Shader::CreateFromSource(sUIFragmentShaderSource,
                                          VK_SHADER_STAGE_FRAGMENT_BIT)) {
-    shaders[1] = std::move(*fs);
+    shaders[1] = std::make_shared<Shader const>(std::move(*fs));
   } else {
     IRIS_LOG_LEAVE();
     return tl::unexpected(fs.error());
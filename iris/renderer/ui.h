@@ -9,6 +9,7 @@
 #include "iris/renderer/image.h"
 #include "iris/renderer/impl.h"
 #include "iris/renderer/pipeline.h"
+#include <array>
 #include <memory>
 #include <system_error>
 
@@ -18,16 +19,17 @@ struct UI {
   tl::expected<iris::Renderer::UI, std::system_error>
   static Create() noexcept;
 
-  static constexpr std::size_t const kNumCommandBuffers = 2;
+  static constexpr std::size_t const kNumCommandBuffers = kMaxFramesInFlight;
   static constexpr std::size_t const kNumDescriptorSets = 1;
 
+  //! One command buffer and vertex and index buffer per frame in flight,
+  //! indexed by sFrameIndex.
   CommandBuffers commandBuffers;
-  std::uint32_t commandBufferIndex{0};
   Image fontImage{};
   ImageView fontImageView{};
   Sampler fontImageSampler{};
-  Buffer vertexBuffer{};
-  Buffer indexBuffer{};
+  std::array<Buffer, kMaxFramesInFlight> vertexBuffers{};
+  std::array<Buffer, kMaxFramesInFlight> indexBuffers{};
   DescriptorSets descriptorSets;
   Pipeline pipeline{};
   std::unique_ptr<ImGuiContext, decltype(&ImGui::DestroyContext)> context;
@@ -0,0 +1,798 @@
+#include "renderer/upload.h"
+#include "enumerate.h"
+#include "logging.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace iris::Renderer {
+
+static constexpr VkDeviceSize const kStagingRingSize{32 * 1024 * 1024};
+
+//! Staging offsets are aligned for any texel size and for the optimal
+//! buffer copy offset alignment of common devices.
+static constexpr VkDeviceSize const kStagingAlignment{16};
+
+struct StagingBuffer {
+  VkBuffer buffer{VK_NULL_HANDLE};
+  VmaAllocation allocation{VK_NULL_HANDLE};
+}; // struct StagingBuffer
+
+struct BufferUpload {
+  VkBuffer source;
+  VkBuffer buffer;
+  VkBufferCopy region;
+}; // struct BufferUpload
+
+struct ImageUpload {
+  VkBuffer source;
+  VkImage image;
+  VkImageLayout finalLayout;
+  VkBufferImageCopy region;
+  //! Levels after the first are generated by RecordMipmaps.
+  std::uint32_t mipLevels;
+}; // struct ImageUpload
+
+/*! \brief What a frame in flight holds on to until its fence signals. With
+ * a separate transfer queue the batch is recorded into its own command
+ * buffer and signals a semaphore that the frame waits on.
+ */
+struct UploadBatch {
+  std::uint64_t ringEnd{0};
+  std::vector<StagingBuffer> stagingBuffers{};
+  std::vector<std::function<void()>> releases{};
+  VkCommandPool commandPool{VK_NULL_HANDLE};
+  VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+  VkSemaphore complete{VK_NULL_HANDLE};
+}; // struct UploadBatch
+
+static std::mutex sUploadMutex;
+
+static VkBuffer sRingBuffer{VK_NULL_HANDLE};
+static VmaAllocation sRingAllocation{VK_NULL_HANDLE};
+static std::byte* sRingData{nullptr};
+
+// Ring positions only ever increase; position p is at byte
+// p % kStagingRingSize of the ring. Everything in [sRingTail, sRingHead) may
+// still be read by the GPU or by a copy that has not been recorded yet.
+static std::uint64_t sRingHead{0};
+static std::uint64_t sRingTail{0};
+
+// Uploads queued since the last batch was recorded and the staging buffers
+// of those that did not fit in the ring.
+static std::vector<BufferUpload> sBufferUploads;
+static std::vector<ImageUpload> sImageUploads;
+static std::vector<StagingBuffer> sStagingBuffers;
+
+// Releases queued since the last batch was recorded.
+static std::vector<std::function<void()>> sReleases;
+
+static std::array<UploadBatch, kMaxFramesInFlight> sBatches;
+
+static std::uint64_t sNumUploads{0};
+static std::uint64_t sNumBytesUploaded{0};
+static std::uint64_t sNumBatches{0};
+static std::uint64_t sNumStagingBuffers{0};
+static std::uint64_t sNumMipLevelsGenerated{0};
+
+static void
+DestroyStagingBuffers(std::vector<StagingBuffer>& buffers) noexcept {
+  for (auto&& staging : buffers) {
+    vmaDestroyBuffer(sAllocator, staging.buffer, staging.allocation);
+  }
+  buffers.clear();
+} // DestroyStagingBuffers
+
+/*! \brief Have \p write fill \p size bytes of staging memory: the ring if
+ * there is room, otherwise a staging buffer of its own. Must be called with
+ * sUploadMutex held.
+ */
+[[nodiscard]] static std::system_error
+Stage(VkDeviceSize size, std::function<void(std::byte*)> const& write,
+      VkBuffer& source, VkDeviceSize& sourceOffset) noexcept {
+  if (size <= kStagingRingSize) {
+    std::uint64_t position =
+      (sRingHead + kStagingAlignment - 1) / kStagingAlignment *
+      kStagingAlignment;
+    VkDeviceSize offset = position % kStagingRingSize;
+
+    // Copies never wrap around the end of the ring; skip to the next lap.
+    if (offset + size > kStagingRingSize) {
+      position += kStagingRingSize - offset;
+      offset = 0;
+    }
+
+    if (position + size - sRingTail <= kStagingRingSize) {
+      write(sRingData + offset);
+      vmaFlushAllocation(sAllocator, sRingAllocation, offset, size);
+      sRingHead = position + size;
+      source = sRingBuffer;
+      sourceOffset = offset;
+      return {Error::kNone};
+    }
+  }
+
+  VkBufferCreateInfo bufferCI = {};
+  bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCI.size = size;
+  bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+  VmaAllocationCreateInfo allocationCI = {};
+  allocationCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+  StagingBuffer staging;
+  VmaAllocationInfo allocationInfo;
+  if (auto result =
+        vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI, &staging.buffer,
+                        &staging.allocation, &allocationInfo);
+      result != VK_SUCCESS) {
+    return {make_error_code(result), "Cannot create staging buffer"};
+  }
+
+  write(static_cast<std::byte*>(allocationInfo.pMappedData));
+  vmaFlushAllocation(sAllocator, staging.allocation, 0, size);
+
+  sStagingBuffers.push_back(staging);
+  sNumStagingBuffers++;
+
+  source = staging.buffer;
+  sourceOffset = 0;
+  return {Error::kNone};
+} // Stage
+
+/*! \brief Record every queued copy into \p commandBuffer, leaving images
+ * in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL. Must be called with sUploadMutex
+ * held.
+ */
+static void RecordCopies(VkCommandBuffer commandBuffer) noexcept {
+  std::size_t const numImages = sImageUploads.size();
+  absl::FixedArray<VkImageMemoryBarrier> imageBarriers(numImages);
+
+  for (auto&& [i, upload] : enumerate(sImageUploads)) {
+    auto&& barrier = imageBarriers[i];
+    barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = upload.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0,
+                                upload.mipLevels, 0, 1};
+  }
+
+  // Buffer ranges may be rewritten after earlier work read them.
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier,
+                       0, nullptr, gsl::narrow_cast<std::uint32_t>(numImages),
+                       imageBarriers.data());
+
+  // Runs of copies between the same two buffers, such as the geometry of a
+  // model staged into the ring, become a single command.
+  std::vector<VkBufferCopy> regions;
+  for (std::size_t i = 0; i < sBufferUploads.size();) {
+    auto&& first = sBufferUploads[i];
+    regions.clear();
+
+    for (; i < sBufferUploads.size() &&
+           sBufferUploads[i].source == first.source &&
+           sBufferUploads[i].buffer == first.buffer;
+         ++i) {
+      regions.push_back(sBufferUploads[i].region);
+    }
+
+    vkCmdCopyBuffer(commandBuffer, first.source, first.buffer,
+                    gsl::narrow_cast<std::uint32_t>(regions.size()),
+                    regions.data());
+  }
+
+  for (auto&& upload : sImageUploads) {
+    vkCmdCopyBufferToImage(commandBuffer, upload.source, upload.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                           &upload.region);
+  }
+} // RecordCopies
+
+/*! \brief Record the barrier that ends the queued copies: it moves images to
+ * their final layouts and makes the writes available. Images with mipmaps
+ * stay in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL for RecordMipmaps. When
+ * \p srcQueueFamilyIndex and \p dstQueueFamilyIndex differ it is one half of
+ * a queue family ownership transfer of every destination, and the release on
+ * the transfer queue and the acquire on the graphics queue must be recorded
+ * from the same queued uploads. Must be called with sUploadMutex held.
+ */
+static void RecordFinishBarrier(VkCommandBuffer commandBuffer,
+                                VkPipelineStageFlags srcStageMask,
+                                VkAccessFlags srcAccessMask,
+                                VkPipelineStageFlags dstStageMask,
+                                VkAccessFlags dstAccessMask,
+                                std::uint32_t srcQueueFamilyIndex,
+                                std::uint32_t dstQueueFamilyIndex) noexcept {
+  bool const ownershipTransfer = (srcQueueFamilyIndex != dstQueueFamilyIndex);
+  if (!ownershipTransfer) {
+    srcQueueFamilyIndex = dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  }
+
+  absl::FixedArray<VkImageMemoryBarrier> imageBarriers(sImageUploads.size());
+  for (auto&& [i, upload] : enumerate(sImageUploads)) {
+    auto&& barrier = imageBarriers[i];
+    barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = (upload.mipLevels > 1
+                           ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                           : upload.finalLayout);
+    barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    barrier.image = upload.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0,
+                                upload.mipLevels, 0, 1};
+  }
+
+  // Ownership is transferred per buffer range; otherwise one global barrier
+  // covers every buffer.
+  std::vector<VkBufferMemoryBarrier> bufferBarriers;
+  if (ownershipTransfer) {
+    bufferBarriers.reserve(sBufferUploads.size());
+    for (auto&& upload : sBufferUploads) {
+      VkBufferMemoryBarrier barrier = {};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = srcAccessMask;
+      barrier.dstAccessMask = dstAccessMask;
+      barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+      barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+      barrier.buffer = upload.buffer;
+      barrier.offset = upload.region.dstOffset;
+      barrier.size = upload.region.size;
+      bufferBarriers.push_back(barrier);
+    }
+  }
+
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = srcAccessMask;
+  memoryBarrier.dstAccessMask = dstAccessMask;
+
+  vkCmdPipelineBarrier(
+    commandBuffer, srcStageMask, dstStageMask, 0,
+    (ownershipTransfer ? 0 : 1), &memoryBarrier,
+    gsl::narrow_cast<std::uint32_t>(bufferBarriers.size()),
+    bufferBarriers.data(),
+    gsl::narrow_cast<std::uint32_t>(imageBarriers.size()),
+    imageBarriers.data());
+} // RecordFinishBarrier
+
+/*! \brief Record the generation of the mip levels of every queued image
+ * that has them, after RecordFinishBarrier, into \p commandBuffer, which must
+ * be submitted to a graphics queue. Each level of every image is blitted from
+ * the one before it; the images share one barrier per level. Must be called
+ * with sUploadMutex held.
+ */
+static void RecordMipmaps(VkCommandBuffer commandBuffer) noexcept {
+  std::uint32_t maxLevels = 1;
+  for (auto&& upload : sImageUploads) {
+    maxLevels = std::max(maxLevels, upload.mipLevels);
+  }
+  if (maxLevels == 1) return;
+
+  auto const levelBarrier = [](ImageUpload const& upload,
+                               std::uint32_t baseLevel,
+                               std::uint32_t levelCount) {
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = upload.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel,
+                                levelCount, 0, 1};
+    return barrier;
+  };
+
+  auto const levelExtent = [](VkExtent3D extent, std::uint32_t level) {
+    return VkOffset3D{
+      static_cast<std::int32_t>(std::max(extent.width >> level, 1U)),
+      static_cast<std::int32_t>(std::max(extent.height >> level, 1U)),
+      static_cast<std::int32_t>(std::max(extent.depth >> level, 1U))};
+  };
+
+  std::vector<VkImageMemoryBarrier> barriers;
+  barriers.reserve(sImageUploads.size() * 2);
+
+  for (std::uint32_t level = 1; level < maxLevels; ++level) {
+    // The previous level of every image that has this one becomes the
+    // source of its blit.
+    barriers.clear();
+    for (auto&& upload : sImageUploads) {
+      if (level >= upload.mipLevels) continue;
+      auto barrier = levelBarrier(upload, level - 1, 1);
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr,
+                         gsl::narrow_cast<std::uint32_t>(barriers.size()),
+                         barriers.data());
+
+    for (auto&& upload : sImageUploads) {
+      if (level >= upload.mipLevels) continue;
+      VkExtent3D const extent = upload.region.imageExtent;
+
+      VkImageBlit blit = {};
+      blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+      blit.srcOffsets[1] = levelExtent(extent, level - 1);
+      blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+      blit.dstOffsets[1] = levelExtent(extent, level);
+
+      vkCmdBlitImage(commandBuffer, upload.image,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upload.image,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                     VK_FILTER_LINEAR);
+      sNumMipLevelsGenerated++;
+    }
+  }
+
+  // Every level but the last was a blit source; move them all to the final
+  // layout at once.
+  barriers.clear();
+  for (auto&& upload : sImageUploads) {
+    if (upload.mipLevels == 1) continue;
+
+    auto sources = levelBarrier(upload, 0, upload.mipLevels - 1);
+    sources.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    sources.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    sources.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    sources.newLayout = upload.finalLayout;
+    barriers.push_back(sources);
+
+    auto last = levelBarrier(upload, upload.mipLevels - 1, 1);
+    last.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    last.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    last.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    last.newLayout = upload.finalLayout;
+    barriers.push_back(last);
+  }
+
+  vkCmdPipelineBarrier(
+    commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr,
+    gsl::narrow_cast<std::uint32_t>(barriers.size()), barriers.data());
+} // RecordMipmaps
+
+//! \brief Count and forget the queued uploads once they have been recorded.
+//! Must be called with sUploadMutex held.
+static void ClearQueuedUploads() noexcept {
+  sNumUploads += sBufferUploads.size() + sImageUploads.size();
+  sNumBatches++;
+
+  sBufferUploads.clear();
+  sImageUploads.clear();
+} // ClearQueuedUploads
+
+/*! \brief Make \p batch hold on to the ring space, staging buffers and
+ * releases queued so far until its frame's fence signals. Must be called
+ * with sUploadMutex held, and only once the work reading them is recorded
+ * into a command buffer that will be submitted.
+ */
+static void HandOver(UploadBatch& batch) noexcept {
+  batch.ringEnd = sRingHead;
+  batch.stagingBuffers.insert(batch.stagingBuffers.end(),
+                              sStagingBuffers.begin(), sStagingBuffers.end());
+  sStagingBuffers.clear();
+  std::move(sReleases.begin(), sReleases.end(),
+            std::back_inserter(batch.releases));
+  sReleases.clear();
+} // HandOver
+
+/*! \brief Record and submit the queued uploads to sTransferCommandQueue with
+ * \p batch, signaling its semaphore. Must be called with sUploadMutex held.
+ */
+[[nodiscard]] static std::system_error
+SubmitTransferBatch(UploadBatch& batch) noexcept {
+  VkCommandBufferBeginInfo commandBufferBI = {};
+  commandBufferBI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  commandBufferBI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (auto result = vkBeginCommandBuffer(batch.commandBuffer, &commandBufferBI);
+      result != VK_SUCCESS) {
+    return {make_error_code(result), "Cannot begin upload command buffer"};
+  }
+
+  RecordCopies(batch.commandBuffer);
+
+  // The semaphore makes the writes visible to the graphics queue; the
+  // barrier only has to finish the layout transitions or release ownership.
+  RecordFinishBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                      VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                      sTransferQueueFamilyIndex, sGraphicsQueueFamilyIndex);
+
+  if (auto result = vkEndCommandBuffer(batch.commandBuffer);
+      result != VK_SUCCESS) {
+    return {make_error_code(result), "Cannot end upload command buffer"};
+  }
+
+  VkSubmitInfo submitI = {};
+  submitI.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitI.commandBufferCount = 1;
+  submitI.pCommandBuffers = &batch.commandBuffer;
+  submitI.signalSemaphoreCount = 1;
+  submitI.pSignalSemaphores = &batch.complete;
+
+  if (auto result =
+        vkQueueSubmit(sTransferCommandQueue, 1, &submitI, VK_NULL_HANDLE);
+      result != VK_SUCCESS) {
+    return {make_error_code(result), "Cannot submit upload command buffer"};
+  }
+
+  return {Error::kNone};
+} // SubmitTransferBatch
+
+} // namespace iris::Renderer
+
+std::system_error iris::Renderer::InitializeUploads() noexcept {
+  IRIS_LOG_ENTER();
+  Expects(sAllocator != VK_NULL_HANDLE);
+  Expects(sRingBuffer == VK_NULL_HANDLE);
+
+  std::string name = "sStagingRing";
+
+  VkBufferCreateInfo bufferCI = {};
+  bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCI.size = kStagingRingSize;
+  bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+  VmaAllocationCreateInfo allocationCI = {};
+  allocationCI.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+  allocationCI.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT |
+                       VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  allocationCI.pUserData = name.data();
+
+  VmaAllocationInfo allocationInfo;
+  if (auto result =
+        vmaCreateBuffer(sAllocator, &bufferCI, &allocationCI, &sRingBuffer,
+                        &sRingAllocation, &allocationInfo);
+      result != VK_SUCCESS) {
+    IRIS_LOG_LEAVE();
+    return {make_error_code(result), "Cannot create staging ring"};
+  }
+
+  NameObject(VK_OBJECT_TYPE_BUFFER, sRingBuffer, name.c_str());
+  sRingData = static_cast<std::byte*>(allocationInfo.pMappedData);
+
+  if (sTransferCommandQueue == sGraphicsCommandQueue) {
+    Ensures(sRingData != nullptr);
+    IRIS_LOG_LEAVE();
+    return {Error::kNone};
+  }
+
+  VkCommandPoolCreateInfo commandPoolCI = {};
+  commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  commandPoolCI.queueFamilyIndex = sTransferQueueFamilyIndex;
+
+  VkSemaphoreCreateInfo semaphoreCI = {};
+  semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  for (std::uint32_t i = 0; i < sNumFramesInFlight; ++i) {
+    auto&& batch = sBatches[i];
+
+    if (auto result = vkCreateCommandPool(sDevice, &commandPoolCI, nullptr,
+                                          &batch.commandPool);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot create upload command pool"};
+    }
+
+    NameObject(VK_OBJECT_TYPE_COMMAND_POOL, batch.commandPool,
+               fmt::format("sBatches:{}:commandPool", i).c_str());
+
+    VkCommandBufferAllocateInfo commandBufferAI = {};
+    commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAI.commandPool = batch.commandPool;
+    commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAI.commandBufferCount = 1;
+
+    if (auto result = vkAllocateCommandBuffers(sDevice, &commandBufferAI,
+                                               &batch.commandBuffer);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result),
+              "Cannot allocate upload command buffer"};
+    }
+
+    if (auto result =
+          vkCreateSemaphore(sDevice, &semaphoreCI, nullptr, &batch.complete);
+        result != VK_SUCCESS) {
+      IRIS_LOG_LEAVE();
+      return {make_error_code(result), "Cannot create upload semaphore"};
+    }
+
+    NameObject(VK_OBJECT_TYPE_SEMAPHORE, batch.complete,
+               fmt::format("sBatches:{}:complete", i).c_str());
+  }
+
+  Ensures(sRingData != nullptr);
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::InitializeUploads
+
+std::system_error
+iris::Renderer::QueueBufferUpload(VkBuffer buffer, VkDeviceSize offset,
+                                  VkDeviceSize size,
+                                  gsl::not_null<void const*> data) noexcept {
+  return QueueBufferWrite(buffer, offset, size, [&](std::byte* dst) {
+    std::memcpy(dst, data, size);
+  });
+} // iris::Renderer::QueueBufferUpload
+
+std::system_error iris::Renderer::QueueBufferWrite(
+  VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+  std::function<void(std::byte*)> const& write) noexcept {
+  Expects(buffer != VK_NULL_HANDLE);
+  Expects(size > 0);
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+  Expects(sRingBuffer != VK_NULL_HANDLE);
+
+  VkBuffer source;
+  VkDeviceSize sourceOffset;
+  if (auto error = Stage(size, write, source, sourceOffset); error.code()) {
+    return error;
+  }
+
+  sBufferUploads.push_back({source, buffer, {sourceOffset, offset, size}});
+  sNumBytesUploaded += size;
+
+  return {Error::kNone};
+} // iris::Renderer::QueueBufferWrite
+
+std::system_error
+iris::Renderer::QueueImageUpload(VkImage image, VkExtent3D extent,
+                                 VkImageLayout finalLayout, VkDeviceSize size,
+                                 gsl::not_null<void const*> data,
+                                 std::uint32_t mipLevels) noexcept {
+  Expects(image != VK_NULL_HANDLE);
+  Expects(size > 0);
+  Expects(mipLevels > 0);
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+  Expects(sRingBuffer != VK_NULL_HANDLE);
+
+  VkBuffer source;
+  VkDeviceSize sourceOffset;
+  if (auto error = Stage(
+        size, [&](std::byte* dst) { std::memcpy(dst, data, size); }, source,
+        sourceOffset);
+      error.code()) {
+    return error;
+  }
+
+  VkBufferImageCopy region = {};
+  region.bufferOffset = sourceOffset;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = extent;
+
+  sImageUploads.push_back({source, image, finalLayout, region, mipLevels});
+  sNumBytesUploaded += size;
+
+  return {Error::kNone};
+} // iris::Renderer::QueueImageUpload
+
+void iris::Renderer::DiscardBufferUploads(VkBuffer buffer, VkDeviceSize offset,
+                                          VkDeviceSize size) noexcept {
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+  VkDeviceSize const end = (size == VK_WHOLE_SIZE ? size : offset + size);
+
+  sBufferUploads.erase(
+    std::remove_if(sBufferUploads.begin(), sBufferUploads.end(),
+                   [&](BufferUpload const& upload) {
+                     return upload.buffer == buffer &&
+                            upload.region.dstOffset >= offset &&
+                            upload.region.dstOffset + upload.region.size <=
+                              end;
+                   }),
+    sBufferUploads.end());
+} // iris::Renderer::DiscardBufferUploads
+
+void iris::Renderer::DiscardImageUploads(VkImage image) noexcept {
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+
+  sImageUploads.erase(std::remove_if(sImageUploads.begin(),
+                                     sImageUploads.end(),
+                                     [&](ImageUpload const& upload) {
+                                       return upload.image == image;
+                                     }),
+                      sImageUploads.end());
+} // iris::Renderer::DiscardImageUploads
+
+VkSemaphore iris::Renderer::RecordUploads(VkCommandBuffer commandBuffer,
+                                          std::uint32_t frameIndex) noexcept {
+  Expects(commandBuffer != VK_NULL_HANDLE);
+  Expects(frameIndex < kMaxFramesInFlight);
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+
+  auto&& batch = sBatches[frameIndex];
+  if (sBufferUploads.empty() && sImageUploads.empty()) {
+    HandOver(batch);
+    return VK_NULL_HANDLE;
+  }
+
+  if (batch.complete == VK_NULL_HANDLE) {
+    HandOver(batch);
+    RecordCopies(commandBuffer);
+    RecordFinishBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                        VK_ACCESS_MEMORY_READ_BIT, sGraphicsQueueFamilyIndex,
+                        sGraphicsQueueFamilyIndex);
+    RecordMipmaps(commandBuffer);
+    ClearQueuedUploads();
+    return VK_NULL_HANDLE;
+  }
+
+  if (auto error = SubmitTransferBatch(batch); error.code()) {
+    // Leave the uploads, and what they read from, queued for the next frame
+    // to retry.
+    GetLogger()->error("Error submitting uploads: {}", error.what());
+    return VK_NULL_HANDLE;
+  }
+
+  HandOver(batch);
+
+  if (sTransferQueueFamilyIndex != sGraphicsQueueFamilyIndex) {
+    RecordFinishBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                        VK_ACCESS_MEMORY_READ_BIT, sTransferQueueFamilyIndex,
+                        sGraphicsQueueFamilyIndex);
+  }
+
+  // Blits need a graphics queue, so they follow the acquire in the frame.
+  RecordMipmaps(commandBuffer);
+  ClearQueuedUploads();
+  return batch.complete;
+} // iris::Renderer::RecordUploads
+
+void iris::Renderer::RetireUploads(std::uint32_t frameIndex) noexcept {
+  Expects(frameIndex < kMaxFramesInFlight);
+  std::vector<std::function<void()>> releases;
+
+  {
+    std::lock_guard<std::mutex> lock{sUploadMutex};
+
+    auto&& batch = sBatches[frameIndex];
+    sRingTail = std::max(sRingTail, batch.ringEnd);
+    batch.ringEnd = 0;
+    DestroyStagingBuffers(batch.stagingBuffers);
+    releases.swap(batch.releases);
+
+    // The frame waited on the batch's semaphore, so its fence covers the
+    // transfer command buffer too.
+    if (batch.commandPool != VK_NULL_HANDLE) {
+      vkResetCommandPool(sDevice, batch.commandPool, 0);
+    }
+  }
+
+  // The fence of a submission also covers every earlier submission to the
+  // graphics queue, so nothing still reads what was released before it.
+  // Releases may queue uploads, so they run without the mutex held.
+  for (auto&& release : releases) release();
+} // iris::Renderer::RetireUploads
+
+void iris::Renderer::QueueRelease(std::function<void()> release) noexcept {
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+  sReleases.push_back(std::move(release));
+} // iris::Renderer::QueueRelease
+
+std::system_error iris::Renderer::FlushUploads() noexcept {
+  IRIS_LOG_ENTER();
+  std::unique_lock<std::mutex> lock{sUploadMutex};
+
+  if (!sBufferUploads.empty() || !sImageUploads.empty()) {
+    VkCommandBuffer commandBuffer;
+    if (auto cb = BeginOneTimeSubmit()) {
+      commandBuffer = *cb;
+    } else {
+      IRIS_LOG_LEAVE();
+      return cb.error();
+    }
+
+    // Submitted on the graphics queue, so ownership stays with it.
+    RecordCopies(commandBuffer);
+    RecordFinishBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                        VK_ACCESS_MEMORY_READ_BIT, sGraphicsQueueFamilyIndex,
+                        sGraphicsQueueFamilyIndex);
+    RecordMipmaps(commandBuffer);
+    ClearQueuedUploads();
+
+    if (auto error = EndOneTimeSubmit(commandBuffer); error.code()) {
+      IRIS_LOG_LEAVE();
+      return error;
+    }
+  }
+
+  // Once the device is idle no batch is in flight.
+  vkDeviceWaitIdle(sDevice);
+
+  sRingTail = sRingHead;
+  DestroyStagingBuffers(sStagingBuffers);
+  std::vector<std::function<void()>> releases;
+  releases.swap(sReleases);
+  for (auto&& batch : sBatches) {
+    batch.ringEnd = 0;
+    DestroyStagingBuffers(batch.stagingBuffers);
+    std::move(batch.releases.begin(), batch.releases.end(),
+              std::back_inserter(releases));
+    batch.releases.clear();
+  }
+
+  lock.unlock();
+  for (auto&& release : releases) release();
+
+  IRIS_LOG_LEAVE();
+  return {Error::kNone};
+} // iris::Renderer::FlushUploads
+
+void iris::Renderer::ShutdownUploads() noexcept {
+  IRIS_LOG_ENTER();
+  std::lock_guard<std::mutex> lock{sUploadMutex};
+
+  GetLogger()->info(
+    "Uploads: {} copies of {} bytes in {} batches, {} staged outside the "
+    "ring, {} mip levels generated",
+    sNumUploads, sNumBytesUploaded, sNumBatches, sNumStagingBuffers,
+    sNumMipLevelsGenerated);
+
+  // The device is idle and whatever is still to be released is destroyed
+  // with its owner.
+  sBufferUploads.clear();
+  sImageUploads.clear();
+  sReleases.clear();
+  DestroyStagingBuffers(sStagingBuffers);
+  for (auto&& batch : sBatches) {
+    batch.ringEnd = 0;
+    DestroyStagingBuffers(batch.stagingBuffers);
+
+    // Destroying the pool frees the batch's command buffer.
+    if (batch.commandPool != VK_NULL_HANDLE) {
+      vkDestroyCommandPool(sDevice, batch.commandPool, nullptr);
+    }
+    if (batch.complete != VK_NULL_HANDLE) {
+      vkDestroySemaphore(sDevice, batch.complete, nullptr);
+    }
+    batch = {};
+  }
+
+  if (sRingBuffer != VK_NULL_HANDLE) {
+    vmaDestroyBuffer(sAllocator, sRingBuffer, sRingAllocation);
+  }
+
+  sRingBuffer = VK_NULL_HANDLE;
+  sRingAllocation = VK_NULL_HANDLE;
+  sRingData = nullptr;
+  sRingHead = sRingTail = 0;
+
+  IRIS_LOG_LEAVE();
+} // iris::Renderer::ShutdownUploads
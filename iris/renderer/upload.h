@@ -0,0 +1,114 @@
+#ifndef HEV_IRIS_RENDERER_UPLOAD_H_
+#define HEV_IRIS_RENDERER_UPLOAD_H_
+/*! \file
+ * \brief Batched uploads of buffer and image data through a staging ring.
+ *
+ * Queuing an upload copies the data into a persistently mapped staging ring
+ * and returns without touching the GPU. Every frame takes all uploads
+ * queued since the previous one as a batch. When the device has a queue to
+ * spare the batch is submitted to sTransferCommandQueue and the frame waits
+ * on it, with queue family ownership of every destination transferred to
+ * the graphics family; otherwise the batch is recorded at the start of the
+ * frame's own command buffer. Either way it completes when the frame's
+ * fence signals and the ring space it used is reclaimed when that frame in
+ * flight comes around again. Uploads that do not fit in the ring get a
+ * staging buffer of their own instead of waiting for space.
+ *
+ * Uploads may be queued from any thread. The destination must not be used
+ * until the upload has been recorded, which happens before anything a later
+ * frame records.
+ */
+
+#include "renderer/impl.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+
+namespace iris::Renderer {
+
+/*! \brief Create the staging ring. Must be called after the allocator has
+ * been created.
+ */
+[[nodiscard]] std::system_error InitializeUploads() noexcept;
+
+/*! \brief Queue a copy of \p size bytes of \p data to \p offset in
+ * \p buffer, which must have been created with
+ * VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+ */
+[[nodiscard]] std::system_error
+QueueBufferUpload(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                  gsl::not_null<void const*> data) noexcept;
+
+/*! \brief Queue an upload of \p size bytes to \p offset in \p buffer that
+ * \p write writes directly into staging memory, saving a copy for data that
+ * has to be converted anyway. \p write is called before this returns, with
+ * uploads from other threads blocked.
+ */
+[[nodiscard]] std::system_error
+QueueBufferWrite(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                 std::function<void(std::byte*)> const& write) noexcept;
+
+/*! \brief Queue a copy of \p size bytes of tightly packed \p data to the
+ * first mip level and layer of \p image, which must have been created with
+ * VK_IMAGE_USAGE_TRANSFER_DST_BIT. The image is moved from an undefined
+ * layout to \p finalLayout around the copy.
+ *
+ * If \p mipLevels is greater than 1, the other levels are generated from the
+ * first by linear blits, so the image must also have been created with
+ * VK_IMAGE_USAGE_TRANSFER_SRC_BIT and a format that supports them. The blits
+ * of every image in a batch are recorded together on the graphics queue.
+ */
+[[nodiscard]] std::system_error
+QueueImageUpload(VkImage image, VkExtent3D extent, VkImageLayout finalLayout,
+                 VkDeviceSize size, gsl::not_null<void const*> data,
+                 std::uint32_t mipLevels = 1) noexcept;
+
+/*! \brief Drop uploads to [\p offset, \p offset + \p size) of \p buffer that
+ * have not been recorded yet; must be called before the buffer is destroyed
+ * or the range is reused.
+ */
+void DiscardBufferUploads(VkBuffer buffer, VkDeviceSize offset = 0,
+                          VkDeviceSize size = VK_WHOLE_SIZE) noexcept;
+
+//! \brief Drop uploads to \p image that have not been recorded yet; must be
+//! called before the image is destroyed.
+void DiscardImageUploads(VkImage image) noexcept;
+
+/*! \brief Take every queued upload as the batch of frame in flight
+ * \p frameIndex, recording it or the acquiring half of its ownership
+ * transfer into \p commandBuffer. Must be recorded outside of a render pass
+ * and before any command that reads the destinations.
+ * \return a semaphore the frame's submission must wait on at
+ * VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, or VK_NULL_HANDLE.
+ */
+VkSemaphore RecordUploads(VkCommandBuffer commandBuffer,
+                          std::uint32_t frameIndex) noexcept;
+
+/*! \brief Reclaim the staging space of the batch recorded for frame in
+ * flight \p frameIndex and call the releases it took; must be called after
+ * that frame's fence signaled.
+ */
+void RetireUploads(std::uint32_t frameIndex) noexcept;
+
+/*! \brief Call \p release once the GPU has finished every frame submitted
+ * so far and the frame being recorded, for memory they may still read that
+ * should not be reused before then. The next batch takes \p release and
+ * RetireUploads calls it, or FlushUploads does if it comes first. May be
+ * called from any thread.
+ */
+void QueueRelease(std::function<void()> release) noexcept;
+
+/*! \brief Submit every queued upload now and wait for it and all earlier
+ * work to complete. For callers that must read or replace a destination
+ * before the next frame records its uploads.
+ */
+[[nodiscard]] std::system_error FlushUploads() noexcept;
+
+//! \brief Destroy the staging ring; must be called after the device is idle
+//! and before the allocator is destroyed.
+void ShutdownUploads() noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_UPLOAD_H_
@@ -0,0 +1,92 @@
+#include "renderer/vertex_format.h"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <cstring>
+
+iris::Renderer::VertexFormat
+iris::Renderer::MakeVertexFormat(MeshDataView const& data,
+                                 bool quantize) noexcept {
+  VertexFormat format;
+
+  auto const add = [&format](VkFormat attributeFormat, std::uint32_t size) {
+    format.attributes[format.numAttributes] = {
+      format.numAttributes, 0, attributeFormat, format.stride};
+    format.numAttributes++;
+    format.stride += size;
+  };
+
+  add(VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3);
+
+  if (quantize) {
+    // Three-component 16-bit formats are rarely supported for vertex
+    // buffers, so normals carry an unused fourth half.
+    add(VK_FORMAT_R16G16B16A16_SFLOAT, sizeof(std::uint16_t) * 4);
+    add(VK_FORMAT_R8G8B8A8_SNORM, sizeof(std::uint8_t) * 4);
+  } else {
+    add(VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3);
+    add(VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 4);
+  }
+
+  if (data.hasTexCoords) {
+    if (!quantize) {
+      add(VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 2);
+    } else if (std::all_of(data.vertices.begin(), data.vertices.end(),
+                           [](MeshData::Vertex const& vertex) {
+                             return glm::all(glm::greaterThanEqual(
+                                      vertex.texcoord, glm::vec2(0.f))) &&
+                                    glm::all(glm::lessThanEqual(
+                                      vertex.texcoord, glm::vec2(1.f)));
+                           })) {
+      add(VK_FORMAT_R16G16_UNORM, sizeof(std::uint16_t) * 2);
+    } else {
+      add(VK_FORMAT_R16G16_SFLOAT, sizeof(std::uint16_t) * 2);
+    }
+  }
+
+  return format;
+} // iris::Renderer::MakeVertexFormat
+
+void iris::Renderer::PackVertices(VertexFormat const& format,
+                                  gsl::span<MeshData::Vertex const> vertices,
+                                  std::byte* dst) noexcept {
+  Expects(format.numAttributes >= 3);
+
+  // The layout is decided once per mesh; only the texture coordinates have
+  // more than one encoding per precision.
+  bool const quantized =
+    (format.attributes[1].format == VK_FORMAT_R16G16B16A16_SFLOAT);
+  VkFormat const texcoordFormat =
+    (format.numAttributes > 3 ? format.attributes[3].format
+                              : VK_FORMAT_UNDEFINED);
+
+  auto const write = [](std::byte*& p, auto const& value) {
+    std::memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+  };
+
+  for (auto&& vertex : vertices) {
+    std::byte* p = dst;
+    write(p, vertex.position);
+
+    if (quantized) {
+      write(p, glm::packHalf4x16(glm::vec4(vertex.normal, 0.f)));
+      write(p, glm::packSnorm4x8(vertex.tangent));
+    } else {
+      write(p, vertex.normal);
+      write(p, vertex.tangent);
+    }
+
+    switch (texcoordFormat) {
+    case VK_FORMAT_R32G32_SFLOAT: write(p, vertex.texcoord); break;
+    case VK_FORMAT_R16G16_UNORM:
+      write(p, glm::packUnorm2x16(vertex.texcoord));
+      break;
+    case VK_FORMAT_R16G16_SFLOAT:
+      write(p, glm::packHalf2x16(vertex.texcoord));
+      break;
+    default: break;
+    }
+
+    dst += format.stride;
+  }
+} // iris::Renderer::PackVertices
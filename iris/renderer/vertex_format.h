@@ -0,0 +1,53 @@
+#ifndef HEV_IRIS_RENDERER_VERTEX_FORMAT_H_
+#define HEV_IRIS_RENDERER_VERTEX_FORMAT_H_
+/*! \file
+ * \brief Tightly packed, optionally quantized vertex buffer layouts.
+ *
+ * MeshData keeps its vertices in the fat MeshData::Vertex layout. A
+ * VertexFormat describes how they are stored on the GPU instead: only the
+ * attributes a mesh has, back to back, and with quantization normals as
+ * half floats, tangents as snorm bytes and texture coordinates as unorm16
+ * (or half floats when they repeat outside [0, 1]). The shaders read every
+ * attribute as floats, so both layouts work with the same pipelines.
+ */
+
+#include "renderer/mesh.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace iris::Renderer {
+
+struct VertexFormat {
+  std::uint32_t stride{0};
+  std::uint32_t numAttributes{0};
+  std::array<VkVertexInputAttributeDescription, 4> attributes{};
+
+  //! \brief The single binding of the format.
+  VkVertexInputBindingDescription Binding() const noexcept {
+    return {0, stride, VK_VERTEX_INPUT_RATE_VERTEX};
+  }
+
+  //! \brief The attributes of the format, in shader location order.
+  gsl::span<VkVertexInputAttributeDescription const>
+  Attributes() const noexcept {
+    return {attributes.data(), numAttributes};
+  }
+}; // struct VertexFormat
+
+/*! \brief Choose the format for the vertices of \p data: quantized if
+ * \p quantize is true and with texture coordinates if \p data has them.
+ */
+VertexFormat MakeVertexFormat(MeshDataView const& data,
+                              bool quantize) noexcept;
+
+/*! \brief Write \p vertices to \p dst in \p format; \p dst must have room
+ * for vertices.size() * format.stride bytes.
+ */
+void PackVertices(VertexFormat const& format,
+                  gsl::span<MeshData::Vertex const> vertices,
+                  std::byte* dst) noexcept;
+
+} // namespace iris::Renderer
+
+#endif // HEV_IRIS_RENDERER_VERTEX_FORMAT_H_
@@ -0,0 +1,184 @@
+#include "renderer/vertex_format.h"
+#include "glm/gtc/packing.hpp"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using iris::Renderer::MakeVertexFormat;
+using iris::Renderer::MeshData;
+using iris::Renderer::PackVertices;
+using iris::Renderer::VertexFormat;
+
+//! \brief Unit normals and tangents, and texture coordinates in [0, 1], or
+//! repeating up to 8 times if \p repeat.
+static MeshData MakeMeshData(bool repeat) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> unit(-1.f, 1.f);
+  std::uniform_real_distribution<float> texcoord(repeat ? -8.f : 0.f,
+                                                 repeat ? 8.f : 1.f);
+
+  MeshData data;
+  data.hasTexCoords = true;
+
+  for (int i = 0; i < 1000; ++i) {
+    MeshData::Vertex vertex;
+    vertex.position =
+      glm::vec3(unit(generator), unit(generator), unit(generator)) * 100.f;
+    vertex.normal = glm::normalize(
+      glm::vec3(unit(generator), unit(generator), unit(generator)));
+    vertex.tangent = glm::vec4(
+      glm::normalize(
+        glm::vec3(unit(generator), unit(generator), unit(generator))),
+      i % 2 ? 1.f : -1.f);
+    vertex.texcoord = glm::vec2(texcoord(generator), texcoord(generator));
+    data.vertices.push_back(vertex);
+  }
+
+  // The extremes of each encoding.
+  data.vertices[0].normal = glm::vec3(1.f, 0.f, 0.f);
+  data.vertices[0].tangent = glm::vec4(0.f, -1.f, 0.f, 1.f);
+  data.vertices[0].texcoord = glm::vec2(repeat ? -8.f : 0.f, 1.f);
+
+  return data;
+} // MakeMeshData
+
+static std::vector<std::byte> Pack(VertexFormat const& format,
+                                   MeshData const& data) {
+  std::vector<std::byte> bytes(data.vertices.size() * format.stride);
+  PackVertices(format, data.vertices, bytes.data());
+  return bytes;
+} // Pack
+
+template <class T>
+static T Read(std::vector<std::byte> const& bytes, std::size_t offset) {
+  T value;
+  std::memcpy(&value, bytes.data() + offset, sizeof(value));
+  return value;
+} // Read
+
+static void ExpectAttribute(VertexFormat const& format, std::uint32_t location,
+                            VkFormat attributeFormat, std::uint32_t offset) {
+  ASSERT_LT(location, format.numAttributes);
+  auto&& attribute = format.attributes[location];
+  EXPECT_EQ(attribute.location, location);
+  EXPECT_EQ(attribute.binding, 0u);
+  EXPECT_EQ(attribute.format, attributeFormat);
+  EXPECT_EQ(attribute.offset, offset);
+} // ExpectAttribute
+
+TEST(MakeVertexFormat, QuantizedLayout) {
+  auto const format = MakeVertexFormat(MakeMeshData(false), true);
+  EXPECT_EQ(format.stride, 28u);
+  EXPECT_EQ(format.numAttributes, 4u);
+  ExpectAttribute(format, 0, VK_FORMAT_R32G32B32_SFLOAT, 0);
+  ExpectAttribute(format, 1, VK_FORMAT_R16G16B16A16_SFLOAT, 12);
+  ExpectAttribute(format, 2, VK_FORMAT_R8G8B8A8_SNORM, 20);
+  ExpectAttribute(format, 3, VK_FORMAT_R16G16_UNORM, 24);
+
+  EXPECT_EQ(format.Binding().stride, 28u);
+  EXPECT_EQ(static_cast<std::size_t>(format.Attributes().size()), 4u);
+}
+
+TEST(MakeVertexFormat, QuantizedRepeatingTexCoordsAreHalfFloats) {
+  auto const format = MakeVertexFormat(MakeMeshData(true), true);
+  EXPECT_EQ(format.stride, 28u);
+  ExpectAttribute(format, 3, VK_FORMAT_R16G16_SFLOAT, 24);
+}
+
+TEST(MakeVertexFormat, FullPrecisionLayout) {
+  auto const format = MakeVertexFormat(MakeMeshData(false), false);
+  EXPECT_EQ(format.stride, 48u);
+  EXPECT_EQ(format.numAttributes, 4u);
+  ExpectAttribute(format, 0, VK_FORMAT_R32G32B32_SFLOAT, 0);
+  ExpectAttribute(format, 1, VK_FORMAT_R32G32B32_SFLOAT, 12);
+  ExpectAttribute(format, 2, VK_FORMAT_R32G32B32A32_SFLOAT, 24);
+  ExpectAttribute(format, 3, VK_FORMAT_R32G32_SFLOAT, 40);
+}
+
+TEST(MakeVertexFormat, OmitsMissingTexCoords) {
+  MeshData data = MakeMeshData(false);
+  data.hasTexCoords = false;
+
+  auto const quantized = MakeVertexFormat(data, true);
+  EXPECT_EQ(quantized.stride, 24u);
+  EXPECT_EQ(quantized.numAttributes, 3u);
+
+  auto const full = MakeVertexFormat(data, false);
+  EXPECT_EQ(full.stride, 40u);
+  EXPECT_EQ(full.numAttributes, 3u);
+}
+
+TEST(PackVertices, QuantizedRoundTripIsWithinBounds) {
+  for (bool repeat : {false, true}) {
+    MeshData const data = MakeMeshData(repeat);
+    auto const format = MakeVertexFormat(data, true);
+    auto const bytes = Pack(format, data);
+
+    for (std::size_t i = 0; i < data.vertices.size(); ++i) {
+      auto&& vertex = data.vertices[i];
+      std::size_t const base = i * format.stride;
+
+      // Positions are never quantized.
+      EXPECT_EQ(Read<glm::vec3>(bytes, base), vertex.position);
+
+      // Half floats keep 11 significant bits: half an ulp below 1 is 2^-11.
+      glm::vec4 const normal =
+        glm::unpackHalf4x16(Read<glm::uint64>(bytes, base + 12));
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_NEAR(normal[c], vertex.normal[c], 1.f / 2048.f);
+      }
+      EXPECT_EQ(normal.w, 0.f);
+
+      // Snorm bytes step by 1/127; the handedness sign is exact.
+      glm::vec4 const tangent =
+        glm::unpackSnorm4x8(Read<glm::uint32>(bytes, base + 20));
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_NEAR(tangent[c], vertex.tangent[c], 0.5f / 127.f + 1e-6f);
+      }
+      EXPECT_EQ(tangent.w, vertex.tangent.w);
+
+      glm::uint32 const packedTexcoord = Read<glm::uint32>(bytes, base + 24);
+      if (!repeat) {
+        // Unorm16 steps by 1/65535 and hits both ends exactly.
+        glm::vec2 const texcoord = glm::unpackUnorm2x16(packedTexcoord);
+        for (int c = 0; c < 2; ++c) {
+          EXPECT_NEAR(texcoord[c], vertex.texcoord[c], 0.5f / 65535.f + 1e-7f);
+        }
+      } else {
+        // Half floats are relative: 2^-11 of the magnitude.
+        glm::vec2 const texcoord = glm::unpackHalf2x16(packedTexcoord);
+        for (int c = 0; c < 2; ++c) {
+          EXPECT_NEAR(texcoord[c], vertex.texcoord[c],
+                      std::abs(vertex.texcoord[c]) / 2048.f + 1e-7f);
+        }
+      }
+    }
+
+    // The extremes are exact.
+    glm::vec2 const texcoord =
+      repeat ? glm::unpackHalf2x16(Read<glm::uint32>(bytes, 24))
+             : glm::unpackUnorm2x16(Read<glm::uint32>(bytes, 24));
+    EXPECT_EQ(texcoord, data.vertices[0].texcoord);
+    EXPECT_EQ(glm::unpackSnorm4x8(Read<glm::uint32>(bytes, 20)),
+              data.vertices[0].tangent);
+  }
+}
+
+TEST(PackVertices, FullPrecisionIsExact) {
+  MeshData const data = MakeMeshData(true);
+  auto const format = MakeVertexFormat(data, false);
+  auto const bytes = Pack(format, data);
+
+  for (std::size_t i = 0; i < data.vertices.size(); ++i) {
+    auto&& vertex = data.vertices[i];
+    std::size_t const base = i * format.stride;
+    EXPECT_EQ(Read<glm::vec3>(bytes, base), vertex.position);
+    EXPECT_EQ(Read<glm::vec3>(bytes, base + 12), vertex.normal);
+    EXPECT_EQ(Read<glm::vec4>(bytes, base + 24), vertex.tangent);
+    EXPECT_EQ(Read<glm::vec2>(bytes, base + 40), vertex.texcoord);
+  }
+}
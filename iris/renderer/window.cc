@@ -154,6 +154,10 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
         "Frame Times", frameTimes.data(), frameTimes.size(), 0,
         fmt::format("Average {:.3f} ms", 1000.f / io.Framerate).c_str(), 0.f,
         100.f, ImVec2(0, 50));
+      ImGui::Text("Meshes drawn %u culled %u", numMeshesDrawn,
+                  numMeshesCulled);
+      ImGui::Text("Binds issued %u elided %u", numBindsIssued,
+                  numBindsElided);
     }
     ImGui::End();
 
@@ -196,14 +200,18 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
   ImDrawData* drawData = ImGui::GetDrawData();
   if (drawData->TotalVtxCount == 0) return VkCommandBuffer{VK_NULL_HANDLE};
 
+  // The previous contents of this frame's buffers are no longer in use.
+  auto&& vertexBuffer = ui.vertexBuffers[sFrameIndex];
+  auto&& indexBuffer = ui.indexBuffers[sFrameIndex];
+
   VkDeviceSize newBufferSize = drawData->TotalVtxCount * sizeof(ImDrawVert);
-  if (newBufferSize > ui.vertexBuffer.size) {
+  if (newBufferSize > vertexBuffer.size) {
     if (auto vb =
           Buffer::Create(newBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                          VMA_MEMORY_USAGE_CPU_TO_GPU, "ui::vertexBuffer")) {
       auto newVB = std::move(*vb);
-      // ensures old ui.vertexBuffer will get destroyed on scope exit
-      std::swap(ui.vertexBuffer, newVB);
+      // ensures old vertexBuffer will get destroyed on scope exit
+      std::swap(vertexBuffer, newVB);
     } else {
       using namespace std::string_literals;
       return tl::unexpected(std::system_error(
@@ -213,13 +221,13 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
   }
 
   newBufferSize = drawData->TotalIdxCount * sizeof(ImDrawIdx);
-  if (newBufferSize > ui.indexBuffer.size) {
+  if (newBufferSize > indexBuffer.size) {
     if (auto ib =
           Buffer::Create(newBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                          VMA_MEMORY_USAGE_CPU_TO_GPU, "ui::sIndexBuffer")) {
       auto newIB = std::move(*ib);
-      // ensures old ui.indexBuffer will get destroyed on scope exit
-      std::swap(ui.indexBuffer, newIB);
+      // ensures old indexBuffer will get destroyed on scope exit
+      std::swap(indexBuffer, newIB);
     } else {
       using namespace std::string_literals;
       return tl::unexpected(std::system_error(
@@ -229,7 +237,7 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
   }
 
   ImDrawVert* pVerts;
-  if (auto p = ui.vertexBuffer.Map<ImDrawVert*>()) {
+  if (auto p = vertexBuffer.Map<ImDrawVert*>()) {
     pVerts = *p;
   } else {
     using namespace std::string_literals;
@@ -239,7 +247,7 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
   }
 
   ImDrawIdx* pIndxs;
-  if (auto p = ui.indexBuffer.Map<ImDrawIdx*>()) {
+  if (auto p = indexBuffer.Map<ImDrawIdx*>()) {
     pIndxs = *p;
   } else {
     using namespace std::string_literals;
@@ -258,16 +266,14 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
     pIndxs += cmdList->IdxBuffer.Size;
   }
 
-  ui.vertexBuffer.Unmap();
-  ui.indexBuffer.Unmap();
+  vertexBuffer.Unmap();
+  indexBuffer.Unmap();
 
   absl::FixedArray<VkClearValue> clearValues(4);
   clearValues[sColorTargetAttachmentIndex].color = {{0, 0, 0, 0}};
   clearValues[sDepthStencilTargetAttachmentIndex].depthStencil = {1.f, 0};
 
-  ui.commandBufferIndex =
-    (ui.commandBufferIndex + 1) % ui.commandBuffers.size();
-  auto&& cb = ui.commandBuffers[ui.commandBufferIndex];
+  auto&& cb = ui.commandBuffers[sFrameIndex];
 
   VkCommandBufferInheritanceInfo inheritanceInfo = {};
   inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
@@ -293,8 +299,8 @@ iris::Renderer::Window::EndFrame(VkFramebuffer framebuffer,
     ui.descriptorSets.sets.data(), 0, nullptr);
 
   VkDeviceSize bindingOffset = 0;
-  vkCmdBindVertexBuffers(cb, 0, 1, ui.vertexBuffer.get(), &bindingOffset);
-  vkCmdBindIndexBuffer(cb, ui.indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+  vkCmdBindVertexBuffers(cb, 0, 1, vertexBuffer.get(), &bindingOffset);
+  vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
 
   glm::vec2 const displaySize{drawData->DisplaySize.x, drawData->DisplaySize.y};
   glm::vec2 const displayPos{drawData->DisplayPos.x, drawData->DisplayPos.y};
@@ -356,7 +362,12 @@ iris::Renderer::Window::Window(Window&& other) noexcept
   , surface(std::move(other.surface))
   , showUI(other.showUI)
   , ui(std::move(other.ui))
-  , projectionMatrix(std::move(other.projectionMatrix)) {
+  , projectionMatrix(std::move(other.projectionMatrix))
+  , projectionMatrixInverse(std::move(other.projectionMatrixInverse))
+  , numMeshesDrawn(other.numMeshesDrawn)
+  , numMeshesCulled(other.numMeshesCulled)
+  , numBindsIssued(other.numBindsIssued)
+  , numBindsElided(other.numBindsElided) {
   // Re-bind delegates
   window.OnResize(std::bind(&Window::Resize, this, std::placeholders::_1));
   window.OnClose(std::bind(&Window::Close, this));
@@ -372,6 +383,11 @@ operator=(Window&& rhs) noexcept {
   showUI = rhs.showUI;
   ui = std::move(rhs.ui);
   projectionMatrix = std::move(rhs.projectionMatrix);
+  projectionMatrixInverse = std::move(rhs.projectionMatrixInverse);
+  numMeshesDrawn = rhs.numMeshesDrawn;
+  numMeshesCulled = rhs.numMeshesCulled;
+  numBindsIssued = rhs.numBindsIssued;
+  numBindsElided = rhs.numBindsElided;
 
   // Re-bind delegates
   window.OnResize(std::bind(&Window::Resize, this, std::placeholders::_1));
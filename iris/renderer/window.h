@@ -38,6 +38,13 @@ struct Window {
   glm::mat4 projectionMatrix;
   glm::mat4 projectionMatrixInverse;
 
+  //! Meshes drawn and culled against this window's frustum last frame.
+  std::uint32_t numMeshesDrawn{0};
+  std::uint32_t numMeshesCulled{0};
+  //! Bind commands recorded and skipped as redundant for this window.
+  std::uint32_t numBindsIssued{0};
+  std::uint32_t numBindsElided{0};
+
   void Resize(wsi::Extent2D const& newExtent) noexcept;
   void Close() noexcept;
 
@@ -0,0 +1,19 @@
+set(_meshoptimizer_git_tag v0.18)
+
+set(MESHOPT_BUILD_DEMO OFF CACHE BOOL "" FORCE)
+set(MESHOPT_BUILD_TOOLS OFF CACHE BOOL "" FORCE)
+set(MESHOPT_BUILD_SHARED_LIBS OFF CACHE BOOL "" FORCE)
+
+FetchContent_Declare(meshoptimizer
+  GIT_REPOSITORY https://github.com/zeux/meshoptimizer
+  GIT_SHALLOW TRUE GIT_TAG ${_meshoptimizer_git_tag}
+)
+
+FetchContent_GetProperties(meshoptimizer)
+if(NOT meshoptimizer_POPULATED)
+  message(STATUS "Populating build dependency: meshoptimizer")
+  FetchContent_Populate(meshoptimizer)
+  add_subdirectory(${meshoptimizer_SOURCE_DIR} ${meshoptimizer_BINARY_DIR})
+endif()
+
+unset(_meshoptimizer_git_tag)